@@ -2,9 +2,16 @@
 
 void Asteroid::Draw(GameState& state) const
 {
-	const int asteroidID = PlayBlitter::Instance().GetSpriteId("asteroid_2"); 
-	PlayBlitter::Instance().SetSpriteOrigin(asteroidID, asteroidCentre);
-	PlayBlitter::Instance().DrawRotated(asteroidID, GetPosition(), 2 * state.time, GetRotation() + pi/2);
+	const int asteroidID = PlayBlitter::Instance().GetSpriteId(SPRITE_ASTEROID);
+	PlayBlitter::Instance().DrawRotated(asteroidID, GetDrawPosition(state), 2 * state.time, GetRotation() + pi/2);
+}
+
+bool Asteroid::GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const
+{
+	spriteId = PlayBlitter::Instance().GetSpriteId(SPRITE_ASTEROID);
+	frame = static_cast<int>(2 * state.time);
+	angle = static_cast<float>(GetRotation() + pi / 2);
+	return true;
 }
 
 void Asteroid::Spawn(GameState& state)
@@ -20,14 +27,4 @@ void Asteroid::Spawn(GameState& state)
 		Vector2f currentVel = { Vx, Vy };
 		a->SetVelocity(currentVel);
 	}
-}
-
-void Asteroid::Update(GameState& state)
-{
-	Point2f currentPos = GetPosition();
-	Vector2f currentVel = GetVelocity();
-	// Move until the asteroid hits the screen edge then despawn
-	Point2f idealPos = { currentPos.x + currentVel.x, currentPos.y + currentVel.y };
-	SetPosition(idealPos);
-	GameObject::ScreenWrapper(idealPos);
 }
\ No newline at end of file
@@ -1,17 +1,22 @@
 #pragma once
 #include "Play.h"
 #include "GameObject.h"
+#include "ObjectPool.h"
 
-class Asteroid : public GameObject
+class Asteroid : public GameObject, public PooledObject< Asteroid, 64 >
 {
 public:
-	Point2f asteroidCentre{ 75, 80 };
+	// The sprite's origin (set once at startup)
+	static inline const Point2f asteroidCentre{ 75, 80 };
+
+	static constexpr Type TYPE = OBJ_ASTEROID;
 
 	// Constructor and destructor
 	Asteroid(Point2f pos) : GameObject(pos)
 	{
-		SetType(OBJ_ASTEROID);
-		SetUpdateOrder(3);
+		SetType(TYPE);
+		SetUpdateOrder(NO_UPDATE);
+		SetKinematic(MotionStore::WRAP_SCREEN);
 		SetDrawOrder(1);
 	}
 
@@ -21,8 +26,8 @@ public:
 	}
 
 	// Function definitions
-	void Update(GameState& state) override;
 	void Draw(GameState& state) const override;
+	bool GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const override;
 	static void Spawn(GameState& state);
 
 protected:
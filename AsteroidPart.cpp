@@ -1,20 +1,10 @@
 #include "AsteroidPart.h"
 
 // Function definitions
-void AsteroidPart::Update(GameState& state)
-{
-	Point2f currentPos = GetPosition();
-	Vector2f currentVel = GetVelocity();
-	// Move until the asteroid hits the screen edge then despawn
-	Point2f idealPos = { currentPos.x + currentVel.x, currentPos.y + currentVel.y };
-	SetPosition(idealPos);
-}
-
 void AsteroidPart::Draw(GameState& state) const 
 {
-	const int asteroidPartID = PlayBlitter::Instance().GetSpriteId("asteroid_pieces_3");
-	PlayBlitter::Instance().SetSpriteOrigin(asteroidPartID, asteroidPartCentre);
-	PlayBlitter::Instance().DrawRotated(asteroidPartID, GetPosition(), GetFrame(), GetRotation() + pi/2); //Here adding pi/2 just 
+	const int asteroidPartID = PlayBlitter::Instance().GetSpriteId(SPRITE_ASTEROID_PIECES);
+	PlayBlitter::Instance().DrawRotated(asteroidPartID, GetDrawPosition(state), GetFrame(), GetRotation() + pi/2); //Here adding pi/2 just 
 }
 
 void AsteroidPart::Spawn(GameObject* a) 
@@ -1,18 +1,22 @@
 #pragma once
 #include "Play.h"
 #include "GameObject.h"
+#include "ObjectPool.h"
 
-class AsteroidPart : public GameObject
+class AsteroidPart : public GameObject, public PooledObject< AsteroidPart, 64 >
 {
 public:
 	// Constants
-	const Point2f asteroidPartCentre{ 75, 80 };
+	static inline const Point2f asteroidPartCentre{ 75, 80 };
+
+	static constexpr Type TYPE = OBJ_ASTEROID_PART;
 
 	// Constructor and destructor
 	AsteroidPart(Point2f pos) : GameObject(pos)
 	{
-		SetType(OBJ_ASTEROID_PART);
-		SetUpdateOrder(4);
+		SetType(TYPE);
+		SetUpdateOrder(NO_UPDATE);
+		SetKinematic(MotionStore::WRAP_NONE);
 		SetDrawOrder(1);
 	}
 
@@ -22,7 +26,6 @@ public:
 	}
 
 	// Function definitions
-	void Update(GameState& state) override;
 	void Draw(GameState& state) const override;
 	static void Spawn(GameObject* a);
 
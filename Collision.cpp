@@ -0,0 +1,485 @@
+#include <emmintrin.h>
+#include "Collision.h"
+
+std::vector< int > CollisionGrid::s_vCellStart;
+std::vector< float > CollisionGrid::s_vX;
+std::vector< float > CollisionGrid::s_vY;
+std::vector< float > CollisionGrid::s_vMoveX;
+std::vector< float > CollisionGrid::s_vMoveY;
+std::vector< GameObject::Type > CollisionGrid::s_vTypes;
+std::vector< uint8_t > CollisionGrid::s_vGhosts;
+std::vector< GameObject* > CollisionGrid::s_vObjects;
+std::vector< CollisionGrid::UnsortedEntry > CollisionGrid::s_vUnsorted;
+float CollisionGrid::s_maxMoves[GameObject::OBJ_TYPE_COUNT] = {};
+std::vector< GameObject* > CollisionGrid::s_vCandidates;
+std::vector< GameObject::Type > CollisionGrid::s_vCandidateTypes;
+std::vector< float > CollisionGrid::s_vCandidateX;
+std::vector< float > CollisionGrid::s_vCandidateY;
+std::vector< float > CollisionGrid::s_vCandidateMoveX;
+std::vector< float > CollisionGrid::s_vCandidateMoveY;
+std::vector< float > CollisionGrid::s_vCandidateTimes;
+CollisionGrid::NarrowPhase CollisionGrid::s_narrowPhases[GameObject::OBJ_TYPE_COUNT][GameObject::OBJ_TYPE_COUNT] = {};
+unsigned CollisionGrid::s_contactMasks[GameObject::OBJ_TYPE_COUNT] = {};
+unsigned CollisionGrid::s_contactTypes = 0;
+std::vector< CollisionGrid::Contact > CollisionGrid::s_vContacts;
+std::vector< CollisionGrid::ContactHit > CollisionGrid::s_vContactHits;
+
+// Clamping before converting keeps far away objects (and huge coordinates) in the edge cells
+int CollisionGrid::CellColumn( float x )
+{
+	float column = ( x - GRID_LEFT ) * ( 1.0f / CELL_SIZE );
+	column = std::min( std::max( column, 0.0f ), static_cast<float>( GRID_COLUMNS - 1 ) );
+	return static_cast<int>( column );
+}
+
+int CollisionGrid::CellRow( float y )
+{
+	float row = ( y - GRID_TOP ) * ( 1.0f / CELL_SIZE );
+	row = std::min( std::max( row, 0.0f ), static_cast<float>( GRID_ROWS - 1 ) );
+	return static_cast<int>( row );
+}
+
+void CollisionGrid::AddEntry( float x, float y, Vector2f move, GameObject* p, GameObject::Type type, bool ghost )
+{
+	int cell = CellRow( y ) * GRID_COLUMNS + CellColumn( x );
+	s_vUnsorted.push_back( { x, y, move, p, type, ghost, cell } );
+	s_vCellStart[cell + 1]++;
+}
+
+void CollisionGrid::Build( unsigned typeMask )
+{
+	s_vCellStart.assign( GRID_COLUMNS * GRID_ROWS + 1, 0 );
+	s_vUnsorted.clear();
+	typeMask |= s_contactTypes;
+
+	// Gather the entries and count how many land in each cell
+	for( int type = 0; type < GameObject::OBJ_TYPE_COUNT; type++ )
+	{
+		s_maxMoves[type] = 0.0f;
+		if( !( typeMask & TypeBit( static_cast<GameObject::Type>( type ) ) ) )
+			continue;
+
+		for( GameObject* p : GameObject::GetTypeView( static_cast<GameObject::Type>( type ) ) )
+		{
+			if( !p->GetActive() )
+				continue;
+
+			// Up to three ghosts, for objects near an edge (or a corner)
+			Point2f pos = p->GetPosition();
+			Vector2f move = TickMove( p );
+			s_maxMoves[type] = std::max( s_maxMoves[type], std::sqrt( move.x * move.x + move.y * move.y ) );
+			float ghostX = 0.0f;
+			float ghostY = 0.0f;
+			if( pos.x < TORUS_LEFT + GHOST_MARGIN )
+				ghostX = TORUS_WIDTH;
+			else if( pos.x > TORUS_LEFT + TORUS_WIDTH - GHOST_MARGIN )
+				ghostX = -TORUS_WIDTH;
+			if( pos.y < TORUS_TOP + GHOST_MARGIN )
+				ghostY = TORUS_HEIGHT;
+			else if( pos.y > TORUS_TOP + TORUS_HEIGHT - GHOST_MARGIN )
+				ghostY = -TORUS_HEIGHT;
+
+			const GameObject::Type objectType = static_cast<GameObject::Type>( type );
+			AddEntry( pos.x, pos.y, move, p, objectType, false );
+			if( ghostX != 0.0f )
+				AddEntry( pos.x + ghostX, pos.y, move, p, objectType, true );
+			if( ghostY != 0.0f )
+				AddEntry( pos.x, pos.y + ghostY, move, p, objectType, true );
+			if( ghostX != 0.0f && ghostY != 0.0f )
+				AddEntry( pos.x + ghostX, pos.y + ghostY, move, p, objectType, true );
+		}
+	}
+
+	// Turn the counts into start positions, then drop each entry into its cell's range
+	for( int n = 1; n < static_cast<int>( s_vCellStart.size() ); n++ )
+		s_vCellStart[n] += s_vCellStart[n - 1];
+
+	const size_t count = s_vUnsorted.size();
+	s_vX.resize( count );
+	s_vY.resize( count );
+	s_vMoveX.resize( count );
+	s_vMoveY.resize( count );
+	s_vTypes.resize( count );
+	s_vGhosts.resize( count );
+	s_vObjects.resize( count );
+
+	for( const UnsortedEntry& entry : s_vUnsorted )
+	{
+		int index = s_vCellStart[entry.cell]++;
+		s_vX[index] = entry.x;
+		s_vY[index] = entry.y;
+		s_vMoveX[index] = entry.move.x;
+		s_vMoveY[index] = entry.move.y;
+		s_vTypes[index] = entry.type;
+		s_vGhosts[index] = entry.ghost;
+		s_vObjects[index] = entry.pObject;
+	}
+
+	// The scatter has moved each start on to the next cell's start, so shift them back
+	for( int n = static_cast<int>( s_vCellStart.size() ) - 1; n > 0; n-- )
+		s_vCellStart[n] = s_vCellStart[n - 1];
+	s_vCellStart[0] = 0;
+}
+
+void CollisionGrid::Clear()
+{
+	s_vCellStart.clear();
+	s_vUnsorted.clear();
+	s_vX.clear();
+	s_vY.clear();
+	s_vMoveX.clear();
+	s_vMoveY.clear();
+	s_vTypes.clear();
+	s_vGhosts.clear();
+	s_vObjects.clear();
+	s_vCandidates.clear();
+	s_vContacts.clear();
+	s_vContactHits.clear();
+}
+
+// Ghosts make the seams invisible here, so plain distances are enough
+int CollisionGrid::Query( Point2f pos, float radius, unsigned typeMask, std::vector< GameObject* >& vResults )
+{
+	PB_ASSERT_MSG( radius <= GHOST_MARGIN, "Query radius is bigger than the ghost margin!" );
+	vResults.clear();
+	if( s_vCellStart.empty() )
+		return 0;
+
+	const int column0 = CellColumn( pos.x - radius );
+	const int column1 = CellColumn( pos.x + radius );
+	const int row0 = CellRow( pos.y - radius );
+	const int row1 = CellRow( pos.y + radius );
+	const float radiusSq = radius * radius;
+
+	for( int row = row0; row <= row1; row++ )
+	{
+		// The cells in a row are contiguous, so each row is one run of entries
+		const int start = s_vCellStart[row * GRID_COLUMNS + column0];
+		const int end = s_vCellStart[row * GRID_COLUMNS + column1 + 1];
+
+		for( int n = start; n < end; n++ )
+		{
+			float dx = s_vX[n] - pos.x;
+			float dy = s_vY[n] - pos.y;
+
+			if( dx * dx + dy * dy < radiusSq && ( typeMask & TypeBit( s_vTypes[n] ) ) && s_vObjects[n]->GetActive() )
+				vResults.push_back( s_vObjects[n] );
+		}
+	}
+
+	return static_cast<int>( vResults.size() );
+}
+
+// Solves |p + v t| = radius for the first t, where p and v are b's position and movement relative to a's
+// p.v < 0 means they are getting closer, and the discriminant says whether they ever get close enough
+float CollisionGrid::SweptCircleTime( Point2f a, Vector2f aMove, Point2f b, Vector2f bMove, float radius )
+{
+	float px = b.x - a.x;
+	float py = b.y - a.y;
+	px -= TORUS_WIDTH * ( static_cast<float>( px > TORUS_WIDTH * 0.5f ) - static_cast<float>( px < TORUS_WIDTH * -0.5f ) );
+	py -= TORUS_HEIGHT * ( static_cast<float>( py > TORUS_HEIGHT * 0.5f ) - static_cast<float>( py < TORUS_HEIGHT * -0.5f ) );
+	float vx = bMove.x - aMove.x;
+	float vy = bMove.y - aMove.y;
+
+	float c = px * px + py * py - radius * radius;
+	if( c < 0.0f )
+		return 0.0f;
+
+	float a2 = vx * vx + vy * vy;
+	float b2 = px * vx + py * vy;
+	float disc = b2 * b2 - a2 * c;
+	if( b2 >= 0.0f || disc < 0.0f )
+		return -1.0f;
+
+	float first = -b2 - std::sqrt( disc );
+	return first <= a2 ? first / a2 : -1.0f;
+}
+
+// The same sums as SweptCircleTime, four at a time, with the early outs turned into masks
+void CollisionGrid::SweptCircleTimes( Point2f a, Vector2f aMove, float radius, const float* pX, const float* pY,
+									  const float* pMoveX, const float* pMoveY, int count, float* pTimes )
+{
+	const int simdEnd = count & ~3;
+
+	const __m128 ax = _mm_set1_ps( a.x );
+	const __m128 ay = _mm_set1_ps( a.y );
+	const __m128 aMoveX = _mm_set1_ps( aMove.x );
+	const __m128 aMoveY = _mm_set1_ps( aMove.y );
+	const __m128 radiusSq = _mm_set1_ps( radius * radius );
+	const __m128 width = _mm_set1_ps( TORUS_WIDTH );
+	const __m128 halfWidth = _mm_set1_ps( TORUS_WIDTH * 0.5f );
+	const __m128 height = _mm_set1_ps( TORUS_HEIGHT );
+	const __m128 halfHeight = _mm_set1_ps( TORUS_HEIGHT * 0.5f );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 miss = _mm_set1_ps( -1.0f );
+
+	for( int n = 0; n < simdEnd; n += 4 )
+	{
+		__m128 px = _mm_sub_ps( _mm_loadu_ps( pX + n ), ax );
+		__m128 py = _mm_sub_ps( _mm_loadu_ps( pY + n ), ay );
+		px = _mm_sub_ps( px, _mm_and_ps( _mm_cmpgt_ps( px, halfWidth ), width ) );
+		px = _mm_add_ps( px, _mm_and_ps( _mm_cmplt_ps( px, _mm_sub_ps( zero, halfWidth ) ), width ) );
+		py = _mm_sub_ps( py, _mm_and_ps( _mm_cmpgt_ps( py, halfHeight ), height ) );
+		py = _mm_add_ps( py, _mm_and_ps( _mm_cmplt_ps( py, _mm_sub_ps( zero, halfHeight ) ), height ) );
+		__m128 vx = _mm_sub_ps( _mm_loadu_ps( pMoveX + n ), aMoveX );
+		__m128 vy = _mm_sub_ps( _mm_loadu_ps( pMoveY + n ), aMoveY );
+
+		__m128 c = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( px, px ), _mm_mul_ps( py, py ) ), radiusSq );
+		__m128 a2 = _mm_add_ps( _mm_mul_ps( vx, vx ), _mm_mul_ps( vy, vy ) );
+		__m128 b2 = _mm_add_ps( _mm_mul_ps( px, vx ), _mm_mul_ps( py, vy ) );
+		__m128 disc = _mm_sub_ps( _mm_mul_ps( b2, b2 ), _mm_mul_ps( a2, c ) );
+		__m128 first = _mm_sub_ps( _mm_sub_ps( zero, b2 ), _mm_sqrt_ps( _mm_max_ps( disc, zero ) ) );
+
+		// Lanes which miss can divide by zero, but they are masked out
+		__m128 hits = _mm_and_ps( _mm_and_ps( _mm_cmplt_ps( b2, zero ), _mm_cmpge_ps( disc, zero ) ), _mm_cmple_ps( first, a2 ) );
+		__m128 time = _mm_or_ps( _mm_and_ps( hits, _mm_div_ps( first, a2 ) ), _mm_andnot_ps( hits, miss ) );
+		__m128 touching = _mm_cmplt_ps( c, zero );
+		time = _mm_andnot_ps( touching, time );
+
+		_mm_storeu_ps( pTimes + n, time );
+	}
+
+	for( int n = simdEnd; n < count; n++ )
+		pTimes[n] = SweptCircleTime( a, aMove, { pX[n], pY[n] }, { pMoveX[n], pMoveY[n] }, radius );
+}
+
+// Long moves are split into pieces when gathering candidates so each piece's reach stays within the ghost margin
+// The candidates are then tested against the whole move in one batch
+int CollisionGrid::GatherSwept( Point2f from, Point2f to, float radius, unsigned typeMask, const GameObject* pSelf )
+{
+	s_vCandidates.clear();
+	s_vCandidateTypes.clear();
+	s_vCandidateX.clear();
+	s_vCandidateY.clear();
+	s_vCandidateMoveX.clear();
+	s_vCandidateMoveY.clear();
+	s_vCandidateTimes.clear();
+	if( s_vCellStart.empty() )
+		return 0;
+
+	const Vector2f move = to - from;
+	const float length = std::sqrt( move.x * move.x + move.y * move.y );
+	// Only the types being looked for matter, so one fast type doesn't shrink everyone else's queries
+	float maxMove = 0.0f;
+	for( int type = 0; type < GameObject::OBJ_TYPE_COUNT; type++ )
+	{
+		if( typeMask & TypeBit( static_cast<GameObject::Type>( type ) ) )
+			maxMove = std::max( maxMove, s_maxMoves[type] );
+	}
+	const float reach = radius + maxMove;
+	PB_ASSERT_MSG( reach < GHOST_MARGIN, "Swept query radius is too big for the ghost margin!" );
+	// Clamped so that a release build can't divide by zero (or go negative) if the assert above would have fired
+	const float pieceLength = 2.0f * std::max( GHOST_MARGIN - reach, 1.0f );
+	const int pieces = std::max( 1, static_cast<int>( std::ceil( length / pieceLength ) ) );
+	const GameObject::Type selfType = pSelf ? pSelf->GetType() : GameObject::OBJ_NONE;
+
+	for( int piece = 0; piece < pieces; piece++ )
+	{
+		const float t = ( piece + 0.5f ) / pieces;
+		const Point2f centre = { from.x + move.x * t, from.y + move.y * t };
+		const float pieceReach = reach + length / ( 2.0f * pieces );
+
+		const int column0 = CellColumn( centre.x - pieceReach );
+		const int column1 = CellColumn( centre.x + pieceReach );
+		const int row0 = CellRow( centre.y - pieceReach );
+		const int row1 = CellRow( centre.y + pieceReach );
+
+		for( int row = row0; row <= row1; row++ )
+		{
+			const int start = s_vCellStart[row * GRID_COLUMNS + column0];
+			const int end = s_vCellStart[row * GRID_COLUMNS + column1 + 1];
+
+			for( int n = start; n < end; n++ )
+			{
+				if( !( typeMask & TypeBit( s_vTypes[n] ) ) ||
+					std::fabs( s_vX[n] - centre.x ) > pieceReach || std::fabs( s_vY[n] - centre.y ) > pieceReach )
+					continue;
+				if( pSelf && s_vTypes[n] == selfType && s_vObjects[n] <= pSelf )
+					continue;
+
+				// Entries are stored where they ended up, so step back to where they started the tick
+				s_vCandidates.push_back( s_vObjects[n] );
+				s_vCandidateTypes.push_back( s_vTypes[n] );
+				s_vCandidateX.push_back( s_vX[n] - s_vMoveX[n] );
+				s_vCandidateY.push_back( s_vY[n] - s_vMoveY[n] );
+				s_vCandidateMoveX.push_back( s_vMoveX[n] );
+				s_vCandidateMoveY.push_back( s_vMoveY[n] );
+			}
+		}
+	}
+
+	const int count = static_cast<int>( s_vCandidates.size() );
+	s_vCandidateTimes.resize( count );
+	SweptCircleTimes( from, move, radius, s_vCandidateX.data(), s_vCandidateY.data(),
+					  s_vCandidateMoveX.data(), s_vCandidateMoveY.data(), count, s_vCandidateTimes.data() );
+	return pieces;
+}
+
+// Overlapping pieces can find an object more than once, so this keeps its earliest hit
+// > One piece can't see both an object and its ghost, as they are a whole torus apart
+template< class Hit >
+static void RemoveDuplicateHits( std::vector< Hit >& vHits )
+{
+	std::sort( vHits.begin(), vHits.end(), []( const Hit& a, const Hit& b )
+		{ return a.pObject != b.pObject ? a.pObject < b.pObject : a.time < b.time; } );
+	vHits.erase( std::unique( vHits.begin(), vHits.end(), []( const Hit& a, const Hit& b ) { return a.pObject == b.pObject; } ), vHits.end() );
+}
+
+int CollisionGrid::QuerySwept( Point2f from, Point2f to, float radius, unsigned typeMask, std::vector< SweptHit >& vHits )
+{
+	vHits.clear();
+	const int pieces = GatherSwept( from, to, radius, typeMask, nullptr );
+
+	const int count = static_cast<int>( s_vCandidates.size() );
+	for( int n = 0; n < count; n++ )
+	{
+		const float time = s_vCandidateTimes[n];
+		if( time < 0.0f || !s_vCandidates[n]->GetActive() )
+			continue;
+
+		vHits.push_back( { s_vCandidates[n], time } );
+	}
+
+	if( pieces > 1 )
+		RemoveDuplicateHits( vHits );
+	std::sort( vHits.begin(), vHits.end(), []( const SweptHit& a, const SweptHit& b ) { return a.time < b.time; } );
+	return static_cast<int>( vHits.size() );
+}
+
+void CollisionGrid::SetContactPair( GameObject::Type a, GameObject::Type b, NarrowPhase phase )
+{
+	PB_ASSERT_MSG( a >= 0 && a < GameObject::OBJ_TYPE_COUNT && b >= 0 && b < GameObject::OBJ_TYPE_COUNT, "Contact pair type out of range!" );
+
+	s_narrowPhases[a][b] = phase;
+	s_narrowPhases[b][a] = phase;
+	s_contactMasks[std::min( a, b )] |= TypeBit( std::max( a, b ) );
+	s_contactTypes |= TypeBit( a ) | TypeBit( b );
+}
+
+void CollisionGrid::ClearContactPairs()
+{
+	for( int type = 0; type < GameObject::OBJ_TYPE_COUNT; type++ )
+		s_contactMasks[type] = 0;
+	s_contactTypes = 0;
+}
+
+// Each object looks for the types it pairs with from where it started the tick, using the bigger radius if any of its
+// pairs needs it, and the narrow phase then sorts out which of those hits are real
+// The objects are visited in grid order, using the copies of their positions and moves in the grid, so neighbouring
+// queries share cells and the objects themselves are only touched by the narrow phase
+void CollisionGrid::FindContacts( const GameState& state )
+{
+	s_vContacts.clear();
+
+	float radii[GameObject::OBJ_TYPE_COUNT];
+	for( int type = 0; type < GameObject::OBJ_TYPE_COUNT; type++ )
+	{
+		radii[type] = static_cast<float>( S_SCREEN_LIMIT );
+		for( int other = type; other < GameObject::OBJ_TYPE_COUNT; other++ )
+		{
+			if( ( s_contactMasks[type] & TypeBit( static_cast<GameObject::Type>( other ) ) ) && s_narrowPhases[type][other] == NARROW_SHAPE )
+				radii[type] = BROADPHASE_RADIUS;
+		}
+	}
+
+	const int entries = GetEntryCount();
+	for( int entry = 0; entry < entries; entry++ )
+	{
+		const GameObject::Type type = s_vTypes[entry];
+		const unsigned partners = s_contactMasks[type];
+		if( !partners || s_vGhosts[entry] )
+			continue;
+
+		GameObject* pA = s_vObjects[entry];
+		const Point2f to = { s_vX[entry], s_vY[entry] };
+		const Vector2f aMove = { s_vMoveX[entry], s_vMoveY[entry] };
+		const float radius = radii[type];
+		// Pairs of the same type are found from both ends (and an object finds itself), so only the one found from
+		// the lower address is kept
+		const int pieces = GatherSwept( to - aMove, to, radius, partners, pA );
+
+		// Everything in the grid is still active, as nothing has run since it was built, and the types were copied
+		// into it, so the candidates can be sifted without touching the other objects
+		s_vContactHits.clear();
+		const int count = static_cast<int>( s_vCandidates.size() );
+		for( int n = 0; n < count; n++ )
+		{
+			if( s_vCandidateTimes[n] >= 0.0f )
+				s_vContactHits.push_back( { s_vCandidates[n], s_vCandidateTypes[n], s_vCandidateTimes[n] } );
+		}
+		if( pieces > 1 )
+			RemoveDuplicateHits( s_vContactHits );
+
+		for( const ContactHit& hit : s_vContactHits )
+		{
+			// The batch has already done the circle test when it used the circle radius
+			const float time = radius == S_SCREEN_LIMIT && s_narrowPhases[type][hit.type] == NARROW_CIRCLE ? hit.time :
+				ContactTime( state, pA, aMove, hit.pObject, TickMove( hit.pObject ), hit.time );
+			if( time >= 0.0f )
+				s_vContacts.push_back( { pA, hit.pObject, PairBit( type, hit.type ), time } );
+		}
+	}
+}
+
+int CollisionGrid::GetContacts( uint64_t pairMask, std::vector< Contact >& vContacts )
+{
+	vContacts.clear();
+	for( const Contact& contact : s_vContacts )
+	{
+		if( contact.pairBit & pairMask )
+			vContacts.push_back( contact );
+	}
+	return static_cast<int>( vContacts.size() );
+}
+
+// B is placed at its image nearest A, so the sprites line up across the seam
+float CollisionGrid::ContactTime( const GameState& state, const GameObject* pA, Vector2f aMove, const GameObject* pB, Vector2f bMove, float hitTime )
+{
+	const Point2f aEnd = pA->GetPosition();
+	const Point2f aStart = aEnd - aMove;
+	const Point2f bEnd = aEnd + TorusOffset( aEnd, pB->GetPosition() );
+	const Point2f bStart = bEnd - bMove;
+
+	const NarrowPhase phase = GetNarrowPhase( pA->GetType(), pB->GetType() );
+	const float circleTime = SweptCircleTime( aStart, aMove, bStart, bMove, static_cast<float>( S_SCREEN_LIMIT ) );
+
+	int aSprite, aFrame, bSprite, bFrame;
+	float aAngle, bAngle;
+	if( phase == NARROW_CIRCLE ||
+		!pA->GetCollisionSprite( state, aSprite, aFrame, aAngle ) ||
+		!pB->GetCollisionSprite( state, bSprite, bFrame, bAngle ) )
+		return circleTime;
+
+	const PlayBlitter& blitter = PlayBlitter::Instance();
+	float startTime = hitTime;
+	if( phase == NARROW_PIXELS )
+	{
+		if( circleTime < 0.0f )
+			return -1.0f;
+		startTime = circleTime;
+	}
+	else
+	{
+		PB_ASSERT_MSG( blitter.GetSpriteShapeReach( aSprite ) + blitter.GetSpriteShapeReach( bSprite ) <= BROADPHASE_RADIUS,
+					   "Collision shapes reach further than the broadphase radius!" );
+	}
+
+	const Vector2f relativeMove = bMove - aMove;
+	const float remaining = std::sqrt( relativeMove.x * relativeMove.x + relativeMove.y * relativeMove.y ) * ( 1.0f - startTime );
+	const int steps = std::max( 1, static_cast<int>( std::ceil( remaining / NARROW_STEP ) ) );
+
+	for( int step = 0; step <= steps; step++ )
+	{
+		const float t = startTime + ( 1.0f - startTime ) * step / steps;
+		const Point2f aPos = { aStart.x + aMove.x * t, aStart.y + aMove.y * t };
+		const Point2f bPos = { bStart.x + bMove.x * t, bStart.y + bMove.y * t };
+
+		const bool overlap = phase == NARROW_PIXELS ?
+			blitter.SpriteMaskCollide( aSprite, aPos, aFrame, aAngle, bSprite, bPos, bFrame, bAngle ) :
+			blitter.SpriteShapeCollide( aSprite, aPos, aAngle, bSprite, bPos, bAngle );
+		if( overlap )
+			return t;
+	}
+
+	return -1.0f;
+}
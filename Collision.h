@@ -0,0 +1,206 @@
+#pragma once
+#include "Play.h"
+#include "GameObject.h"
+
+// A uniform grid over the play area used to find the objects near a point without testing every object
+// It's rebuilt from scratch at the end of each tick (once everything has moved), using a counting sort so that the
+// entries for each cell are contiguous, and then used to find all the contacts for the tick in one pass
+// > Objects created since aren't in it until the next tick, and objects deactivated since are never returned
+// The play area is a torus: objects wrap from one edge to the other (see GameObject::ScreenWrapper), so distances
+// are measured to the nearest image of the other object, and objects near an edge are also indexed just past the
+// opposite edge (as 'ghosts') so queries find them across the seam
+class CollisionGrid
+{
+public:
+    // S_SCREEN_LIMIT is also the collision distance, so a collision query only touches the 3x3 cells around it
+    static constexpr float CELL_SIZE = static_cast<float>(S_SCREEN_LIMIT);
+
+    static constexpr unsigned TypeBit(GameObject::Type type) { return 1u << type; }
+    // The types the game queries against (the player's targets)
+    static constexpr unsigned INDEXED_TYPES = (1u << GameObject::OBJ_METEOR) | (1u << GameObject::OBJ_ASTEROID) | (1u << GameObject::OBJ_GEM);
+
+    // Re-indexes every active object whose type is in the mask or in a contact pair (see SetContactPair)
+    // Each entry's move is where it started the tick to where it is now (see GameObject::GetPrevPosition)
+    static void Build(unsigned typeMask = INDEXED_TYPES);
+    // Forgets every entry and contact, for when the objects they point to are destroyed
+    static void Clear();
+
+    // Finds the objects whose type is in the mask and whose centres are strictly closer than the radius
+    // The results replace the vector's contents, in cell order, and the number found is returned
+    static int Query(Point2f pos, float radius, unsigned typeMask, std::vector< GameObject* >& vResults);
+
+    // A hit found by a swept query, and how far through the tick (0 to 1) the two objects first touched
+    struct SweptHit
+    {
+        GameObject* pObject;
+        float time;
+    };
+
+    // Finds the objects whose type is in the mask which a circle moving from 'from' to 'to' during the tick comes closer
+    // than the radius to, allowing for the objects' own movement over the tick
+    // The results replace the vector's contents, earliest first, and the number found is returned
+    static int QuerySwept(Point2f from, Point2f to, float radius, unsigned typeMask, std::vector< SweptHit >& vHits);
+
+    // How a pair of types found by a query is checked (set up for each pair with SetContactPair)
+    enum NarrowPhase
+    {
+        NARROW_CIRCLE = 0, // Centres closer than S_SCREEN_LIMIT
+        NARROW_SHAPE, // The collision shapes from the sprites' .INF files overlap
+        NARROW_PIXELS, // Centres closer than S_SCREEN_LIMIT, then the sprites' pixels overlap
+    };
+    static NarrowPhase GetNarrowPhase(GameObject::Type a, GameObject::Type b) { return s_narrowPhases[a][b]; }
+
+    // Queries followed by a narrow phase use this radius, which is enough for the largest pair of collision shapes
+    static constexpr float BROADPHASE_RADIUS = 2.5f * CELL_SIZE;
+    // Shapes and pixels are tested every NARROW_STEP of relative movement from the time of the broadphase hit
+    static constexpr float NARROW_STEP = 4.0f;
+
+    // One bit for each unordered pair of types, for filtering contacts
+    static_assert(GameObject::OBJ_TYPE_COUNT * GameObject::OBJ_TYPE_COUNT <= 64, "Too many object types for a pair mask!");
+    static constexpr uint64_t PairBit(GameObject::Type a, GameObject::Type b)
+    {
+        return a <= b ? 1ull << (a * GameObject::OBJ_TYPE_COUNT + b) : 1ull << (b * GameObject::OBJ_TYPE_COUNT + a);
+    }
+
+    // Two objects which collided during the tick, and how far through it (0 to 1) they first touched
+    // > pA is the one with the lower type (for a pair of the same type, the one at the lower address)
+    struct Contact
+    {
+        GameObject* pA;
+        GameObject* pB;
+        uint64_t pairBit;
+        float time;
+    };
+
+    // Asks FindContacts to look for collisions between the two types, checked with the narrow phase given
+    // > Objects without a collision sprite fall back to the circle test
+    static void SetContactPair(GameObject::Type a, GameObject::Type b, NarrowPhase phase);
+    // Forgets every pair set up with SetContactPair
+    static void ClearContactPairs();
+
+    // The collision stage: finds every contact between the pairs of types set up with SetContactPair, using the grid
+    // from the last Build and the sprites the objects are drawn with, and replaces the last tick's contacts
+    // > Each object queries the grid once for all the types it pairs with, so nothing walks a whole type list
+    static void FindContacts(const GameState& state);
+
+    // Copies out the contacts whose pair is in the mask (made from PairBit), and returns how many
+    // > They aren't in any particular order (sorting them by time can cost more than finding them when there are many)
+    // > They stay valid until the next FindContacts, as it only records active objects and only inactive ones are destroyed
+    static int GetContacts(uint64_t pairMask, std::vector< Contact >& vContacts);
+    static int GetContactCount() { return static_cast<int>(s_vContacts.size()); }
+
+    // The number of entries, including ghosts
+    static int GetEntryCount() { return static_cast<int>(s_vObjects.size()); }
+
+    // The area objects wrap within, and its size (the distance an object jumps when it wraps)
+    static constexpr float TORUS_LEFT = static_cast<float>(-S_SCREEN_LIMIT);
+    static constexpr float TORUS_TOP = 0.0f;
+    static constexpr float TORUS_WIDTH = static_cast<float>(DISPLAY_WIDTH + 2 * S_SCREEN_LIMIT);
+    static constexpr float TORUS_HEIGHT = static_cast<float>(DISPLAY_HEIGHT + S_SCREEN_LIMIT);
+
+    // The vector from a to b (on the torus) going whichever way round is shorter
+    // > Uses comparisons rather than rounding or branches, so loops of these vectorise even with plain SSE2
+    static Vector2f TorusOffset(Point2f a, Point2f b)
+    {
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        dx -= TORUS_WIDTH * (static_cast<float>(dx > TORUS_WIDTH * 0.5f) - static_cast<float>(dx < TORUS_WIDTH * -0.5f));
+        dy -= TORUS_HEIGHT * (static_cast<float>(dy > TORUS_HEIGHT * 0.5f) - static_cast<float>(dy < TORUS_HEIGHT * -0.5f));
+        return { dx, dy };
+    }
+
+    // The squared distance between two points (on the torus) going whichever way round is shorter
+    static float TorusDistanceSq(Point2f a, Point2f b)
+    {
+        Vector2f d = TorusOffset(a, b);
+        return d.x * d.x + d.y * d.y;
+    }
+
+    // How far through their moves (0 to 1) two circles moving in straight lines first come closer than the radius
+    // (the sum of their radii), or -1 if they don't
+    // > The start positions are compared on the torus, and circles which start off touching give 0
+    static float SweptCircleTime(Point2f a, Vector2f aMove, Point2f b, Vector2f bMove, float radius);
+
+    // SweptCircleTime for one moving circle against many others, stored as separate arrays of positions and moves
+    // > Uses SSE2 four at a time (gives the same results as SweptCircleTime, apart from rounding)
+    static void SweptCircleTimes(Point2f a, Vector2f aMove, float radius, const float* pX, const float* pY,
+                                 const float* pMoveX, const float* pMoveY, int count, float* pTimes);
+
+private:
+    // Objects this close to an edge get a ghost past the opposite one, which limits query radii to this
+    // Broadphase queries need room for the movement too, so it's three cells
+    static constexpr float GHOST_MARGIN = 3 * CELL_SIZE;
+
+    // The grid covers the torus plus a border for the ghosts, and anything outside it is filed in the nearest edge cell
+    static constexpr float GRID_LEFT = TORUS_LEFT - GHOST_MARGIN;
+    static constexpr float GRID_TOP = TORUS_TOP - GHOST_MARGIN;
+    static constexpr int GRID_COLUMNS = static_cast<int>((TORUS_WIDTH + 2 * GHOST_MARGIN + CELL_SIZE - 1) / CELL_SIZE);
+    static constexpr int GRID_ROWS = static_cast<int>((TORUS_HEIGHT + 2 * GHOST_MARGIN + CELL_SIZE - 1) / CELL_SIZE);
+
+    static void AddEntry(float x, float y, Vector2f move, GameObject* p, GameObject::Type type, bool ghost);
+
+    // Gathers the entries of the types in the mask near a swept circle into the candidate arrays, and fills in their
+    // swept circle times (the work behind QuerySwept), returning how many pieces the move was split into
+    // > Entries of pSelf's type at or below its address are left out, if it's given
+    static int GatherSwept(Point2f from, Point2f to, float radius, unsigned typeMask, const GameObject* pSelf);
+
+    // How far the object moved during the tick, going whichever way round the torus is shorter
+    static Vector2f TickMove(const GameObject* p) { return TorusOffset(p->GetPrevPosition(), p->GetPosition()); }
+
+    // Runs the pair's narrow phase on a broadphase hit between two objects with the given moves
+    // Returns how far through the tick (0 to 1) they first collide, or -1 if they don't
+    static float ContactTime(const GameState& state, const GameObject* pA, Vector2f aMove, const GameObject* pB, Vector2f bMove, float hitTime);
+
+    static int CellColumn(float x);
+    static int CellRow(float y);
+
+    // Where each cell's entries start, with an extra element at the end for the total
+    static std::vector< int > s_vCellStart;
+    // The entries sorted by cell, with their positions copied out so the narrow phase doesn't touch the objects
+    static std::vector< float > s_vX;
+    static std::vector< float > s_vY;
+    // How far each entry moved during the tick to get there
+    static std::vector< float > s_vMoveX;
+    static std::vector< float > s_vMoveY;
+    static std::vector< GameObject::Type > s_vTypes;
+    // Whether each entry is a ghost (rather than where the object really is)
+    static std::vector< uint8_t > s_vGhosts;
+    static std::vector< GameObject* > s_vObjects;
+    // The entries in the order they were gathered, before sorting
+    struct UnsortedEntry
+    {
+        float x, y;
+        Vector2f move;
+        GameObject* pObject;
+        GameObject::Type type;
+        bool ghost;
+        int cell;
+    };
+    static std::vector< UnsortedEntry > s_vUnsorted;
+    // The furthest any entry of each type moved
+    static float s_maxMoves[GameObject::OBJ_TYPE_COUNT];
+    // Swept query candidates, gathered from the cells as arrays so they can be tested as a batch
+    static std::vector< GameObject* > s_vCandidates;
+    static std::vector< GameObject::Type > s_vCandidateTypes;
+    static std::vector< float > s_vCandidateX;
+    static std::vector< float > s_vCandidateY;
+    static std::vector< float > s_vCandidateMoveX;
+    static std::vector< float > s_vCandidateMoveY;
+    static std::vector< float > s_vCandidateTimes;
+
+    static NarrowPhase s_narrowPhases[GameObject::OBJ_TYPE_COUNT][GameObject::OBJ_TYPE_COUNT];
+    // For each type, the types of the same or higher type it has contact pairs with (so each pair is only looked for once)
+    static unsigned s_contactMasks[GameObject::OBJ_TYPE_COUNT];
+    // Every type in a contact pair
+    static unsigned s_contactTypes;
+    // The contacts found by the last FindContacts, unordered (found per object, in the order the layers are walked)
+    static std::vector< Contact > s_vContacts;
+    // A swept hit with the other object's type, so contacts can be sorted out without touching the object
+    struct ContactHit
+    {
+        GameObject* pObject;
+        GameObject::Type type;
+        float time;
+    };
+    static std::vector< ContactHit > s_vContactHits;
+};
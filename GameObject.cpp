@@ -1,7 +1,15 @@
 #include "GameObject.h"
+#include "Collision.h"
 
-std::vector< GameObject* > GameObject::s_vUpdateList;
-std::vector< GameObject* > GameObject::s_vDrawList;
+std::vector< GameObject* > GameObject::s_vUpdateLayers[MAX_ORDERS];
+std::vector< GameObject* > GameObject::s_vDrawLayers[MAX_ORDERS];
+bool GameObject::s_bUpdateLayersDirty = false;
+bool GameObject::s_bDrawLayersDirty = false;
+std::vector< GameObject* > GameObject::s_vTypeLists[OBJ_TYPE_COUNT + 1];
+int GameObject::s_nTypeCounts[OBJ_TYPE_COUNT + 1]{ 0 };
+int GameObject::s_nObjectCount = 0;
+bool GameObject::s_bTypeListsDirty = false;
+std::vector< GameObject* > GameObject::s_vKillList;
 
 // Game object constructor
 // Added default
@@ -9,44 +17,318 @@ GameObject::GameObject() = default;
 GameObject::GameObject( Point2f pos )
 {
 	m_pos = pos;
+	m_prevPos = pos;
+	Register();
+}
 
-	s_vUpdateList.push_back( this );
-	s_vDrawList.push_back( this );
+// Adds the object to the end of its update layer (if it has one), draw layer and type list
+void GameObject::Register()
+{
+	if( m_updateOrder != NO_UPDATE )
+	{
+		m_updateSlot = static_cast<int>( s_vUpdateLayers[m_updateOrder].size() );
+		s_vUpdateLayers[m_updateOrder].push_back( this );
+	}
+	m_drawSlot = static_cast<int>( s_vDrawLayers[m_drawOrder].size() );
+	s_vDrawLayers[m_drawOrder].push_back( this );
+	m_typeSlot = static_cast<int>( TypeList( m_type ).size() );
+	TypeList( m_type ).push_back( this );
+	s_nTypeCounts[m_type + 1]++;
+	s_nObjectCount++;
 }
 
 // Game object destructor
+// Leaves an empty slot in each layer rather than searching and shuffling them down
 GameObject::~GameObject()
 {
-	s_vDrawList.erase( std::find( s_vDrawList.begin(), s_vDrawList.end(), this ) );
-	s_vUpdateList.erase( std::find( s_vUpdateList.begin(), s_vUpdateList.end(), this ) );
+	if( m_drawSlot >= 0 )
+	{
+		s_vDrawLayers[m_drawOrder][m_drawSlot] = nullptr;
+		s_bDrawLayersDirty = true;
+	}
+
+	if( m_updateSlot >= 0 )
+	{
+		s_vUpdateLayers[m_updateOrder][m_updateSlot] = nullptr;
+		s_bUpdateLayersDirty = true;
+	}
+
+	if( m_typeSlot >= 0 )
+	{
+		TypeList( m_type )[m_typeSlot] = nullptr;
+		s_bTypeListsDirty = true;
+		s_nTypeCounts[m_type + 1]--;
+		s_nObjectCount--;
+	}
+
+	if( m_bodySlot >= 0 )
+		MotionStore::Remove( m_bodySlot );
+}
+
+void GameObject::SetType( Type type )
+{
+	PB_ASSERT_MSG( type >= OBJ_NONE && type < OBJ_TYPE_COUNT, "Object type out of range!" );
+
+	if( m_typeSlot >= 0 && type != m_type )
+	{
+		TypeList( m_type )[m_typeSlot] = nullptr;
+		s_bTypeListsDirty = true;
+		s_nTypeCounts[m_type + 1]--;
+		m_typeSlot = static_cast<int>( TypeList( type ).size() );
+		TypeList( type ).push_back( this );
+		s_nTypeCounts[type + 1]++;
+	}
+	m_type = type;
+}
+
+void GameObject::SetDrawOrder( int drawOrder )
+{
+	PB_ASSERT_MSG( drawOrder >= 0 && drawOrder < MAX_ORDERS, "Draw order out of range!" );
+
+	if( m_drawSlot >= 0 && drawOrder != m_drawOrder )
+	{
+		s_vDrawLayers[m_drawOrder][m_drawSlot] = nullptr;
+		s_bDrawLayersDirty = true;
+		m_drawSlot = static_cast<int>( s_vDrawLayers[drawOrder].size() );
+		s_vDrawLayers[drawOrder].push_back( this );
+	}
+	m_drawOrder = drawOrder;
+}
+
+void GameObject::SetUpdateOrder( int updateOrder )
+{
+	PB_ASSERT_MSG( updateOrder == NO_UPDATE || ( updateOrder >= 0 && updateOrder < MAX_ORDERS ), "Update order out of range!" );
+
+	// Only registered objects live in the layers (the type index holds every registered object)
+	if( m_typeSlot >= 0 && updateOrder != m_updateOrder )
+	{
+		if( m_updateSlot >= 0 )
+		{
+			s_vUpdateLayers[m_updateOrder][m_updateSlot] = nullptr;
+			s_bUpdateLayersDirty = true;
+			m_updateSlot = -1;
+		}
+
+		if( updateOrder != NO_UPDATE )
+		{
+			m_updateSlot = static_cast<int>( s_vUpdateLayers[updateOrder].size() );
+			s_vUpdateLayers[updateOrder].push_back( this );
+		}
+	}
+	m_updateOrder = updateOrder;
+}
+
+void GameObject::SetKinematic( MotionStore::WrapMode wrap )
+{
+	PB_ASSERT_MSG( m_bodySlot < 0, "Object is already kinematic!" );
+	MotionStore::Add( &m_bodySlot, m_pos, m_velocity, wrap );
+}
+
+// Only registered objects are queued, so the kill list never holds more than the object count
+void GameObject::SetActive( bool isActive )
+{
+	if( !isActive && !m_killQueued && m_typeSlot >= 0 )
+	{
+		s_vKillList.push_back( this );
+		m_killQueued = true;
+	}
+
+	m_active = isActive;
+}
+
+// Slides the remaining objects down over the empty slots, keeping their order, and tells each one where it ended up
+void GameObject::CompactLayers( std::vector< GameObject* >* vLayers, int layerCount, int GameObject::* slot )
+{
+	for( int n = 0; n < layerCount; n++ )
+	{
+		std::vector< GameObject* >& vLayer = vLayers[n];
+		int write = 0;
+
+		for( GameObject* p : vLayer )
+		{
+			if( p )
+			{
+				p->*slot = write;
+				vLayer[write++] = p;
+			}
+		}
+		vLayer.resize( write );
+	}
 }
 
 void GameObject::UpdateAll( GameState& state )
 {
-	std::sort( s_vUpdateList.begin(), s_vUpdateList.end(), GameObject::UpdateOrder );
+	// Highest order first, matching the old descending sort
+	// Objects created during the update are added to the end of their layer, so indices are used rather than iterators
+	// Nothing is destroyed until the end, so objects deactivated by others are simply skipped
+	// Kinematic objects are all moved first, as they used to have the highest orders
+	MotionStore::IntegrateAll();
 
-	for( int n = 0; n < s_vUpdateList.size(); n++ )
+	for( int order = MAX_ORDERS - 1; order >= 0; order-- )
 	{
-		s_vUpdateList[n]->Update( state );
-		   
-		if( !s_vUpdateList[n]->m_active )
-    			delete s_vUpdateList[n--];
+		std::vector< GameObject* >& vLayer = s_vUpdateLayers[order];
+
+		for( int n = 0; n < static_cast<int>( vLayer.size() ); n++ )
+		{
+			if( vLayer[n] && vLayer[n]->m_active )
+			{
+				vLayer[n]->m_prevPos = vLayer[n]->m_pos;
+				vLayer[n]->Update( state );
+			}
+		}
 	}
+
+	ReclaimInactive();
+
+	// Then the collision stage: everything still active is indexed where it ended up and the tick's contacts are found
+	// for the game to handle (see CollisionGrid::GetContacts)
+	CollisionGrid::Build();
+	CollisionGrid::FindContacts( state );
+}
+
+void GameObject::ReclaimInactive()
+{
+	const int killCount = static_cast<int>( s_vKillList.size() );
+
+	if( killCount > 0 && killCount == s_nObjectCount )
+	{
+		ReclaimEverything();
+		return;
+	}
+
+	// Each destructor just empties its slots, so the whole batch costs one visit per object plus one compaction per list
+	// Destructors may deactivate other objects, so indices are used rather than iterators
+	for( int n = 0; n < static_cast<int>( s_vKillList.size() ); n++ )
+	{
+		GameObject* p = s_vKillList[n];
+		p->m_killQueued = false;
+
+		// It may have been reactivated since it was queued
+		if( !p->m_active )
+			delete p;
+	}
+	s_vKillList.clear();
+
+	if( s_bUpdateLayersDirty )
+	{
+		CompactLayers( s_vUpdateLayers, MAX_ORDERS, &GameObject::m_updateSlot );
+		s_bUpdateLayersDirty = false;
+	}
+
+	if( s_bDrawLayersDirty )
+	{
+		CompactLayers( s_vDrawLayers, MAX_ORDERS, &GameObject::m_drawSlot );
+		s_bDrawLayersDirty = false;
+	}
+
+	if( s_bTypeListsDirty )
+	{
+		CompactLayers( s_vTypeLists, OBJ_TYPE_COUNT + 1, &GameObject::m_typeSlot );
+		s_bTypeListsDirty = false;
+	}
+}
+
+// Everything has been deactivated at once (e.g. the world being reset), so the lists are emptied wholesale rather than picked apart
+// Anything reactivated since it was queued is registered again, and anything created by a destructor registers as normal
+void GameObject::ReclaimEverything()
+{
+	for( std::vector< GameObject* >& vLayer : s_vUpdateLayers )
+		vLayer.clear();
+	for( std::vector< GameObject* >& vLayer : s_vDrawLayers )
+		vLayer.clear();
+	for( std::vector< GameObject* >& vList : s_vTypeLists )
+		vList.clear();
+	for( int& count : s_nTypeCounts )
+		count = 0;
+	s_nObjectCount = 0;
+	s_bUpdateLayersDirty = false;
+	s_bDrawLayersDirty = false;
+	s_bTypeListsDirty = false;
+
+	std::vector< GameObject* > vKillList;
+	vKillList.swap( s_vKillList );
+
+	for( GameObject* p : vKillList )
+	{
+		p->m_killQueued = false;
+
+		if( p->m_active )
+		{
+			p->Register();
+		}
+		else
+		{
+			p->m_updateSlot = -1;
+			p->m_drawSlot = -1;
+			p->m_typeSlot = -1;
+			delete p;
+		}
+	}
+
+	// Hand the buffer back so the kill list doesn't have to grow again
+	vKillList.clear();
+	if( s_vKillList.empty() )
+		s_vKillList.swap( vKillList );
 }
 
 void GameObject::DrawAll( GameState& state )
 {
-	std::sort( s_vDrawList.begin(), s_vDrawList.end(), GameObject::DrawOrder );
+	if( s_bDrawLayersDirty )
+	{
+		CompactLayers( s_vDrawLayers, MAX_ORDERS, &GameObject::m_drawSlot );
+		s_bDrawLayersDirty = false;
+	}
+
+	// The draws are recorded and then made by the blitter's draw threads, with the same result as making them in order
+	PlayBlitter::Instance().BeginBatch();
+
+	// Highest order first so that the lowest orders end up on top
+	for( int order = MAX_ORDERS - 1; order >= 0; order-- )
+	{
+		std::vector< GameObject* >& vLayer = s_vDrawLayers[order];
+
+		for( int n = 0; n < static_cast<int>( vLayer.size() ); n++ )
+		{
+			if( vLayer[n]->m_active )
+				vLayer[n]->Draw( state );
+		}
+	}
+
+	PlayBlitter::Instance().EndBatch();
+}
+
+void GameObject::DrawSpecificCentred(GameState& state, PlayBlitter::SpriteHandle sprite) const
+{
+	PlayBlitter& blit = PlayBlitter::Instance();
+	const int spriteID = blit.GetSpriteId(sprite);
 
-	for( int n = 0; n < s_vDrawList.size(); n++ )
-		s_vDrawList[n]->Draw( state );
+	// Centred for this draw only, so the sprite's own origin is left alone
+	PlayBlitter::DrawParams params;
+	params.useOrigin = true;
+	params.origin = blit.GetSpriteSize(spriteID) / 2;
+	blit.DrawRotated(spriteID, GetDrawPosition(state), 2 * state.time, GetRotation(), 1.0f, params);
 }
 
-void GameObject::DrawSpecificCentred(GameState& state, const char* name) const
+Point2f GameObject::GetPrevPosition() const
 {
-	const int spriteID = PlayBlitter::Instance().GetSpriteId(name);
-	PlayBlitter::Instance().CentreSpriteOrigin(spriteID);
-	PlayBlitter::Instance().DrawRotated(spriteID, GetPosition(), 2 * state.time, GetRotation());
+	if( m_bodySlot >= 0 )
+		return MotionStore::GetPrevPosition( m_bodySlot );
+
+	// Nothing moves objects which aren't updated
+	return m_updateSlot >= 0 ? m_prevPos : m_pos;
+}
+
+// A jump of more than half the screen height in one tick can only be a wrap (or teleport), so it isn't blended across
+Point2f GameObject::GetDrawPosition( const GameState& state ) const
+{
+	const Point2f prev = GetPrevPosition();
+	const Point2f pos = GetPosition();
+
+	const float maxBlend = DISPLAY_HEIGHT / 2.0f;
+	if( std::abs( pos.x - prev.x ) > maxBlend || std::abs( pos.y - prev.y ) > maxBlend )
+		return pos;
+
+	return { prev.x + ( pos.x - prev.x ) * state.alpha, prev.y + ( pos.y - prev.y ) * state.alpha };
 }
 
 float GameObject::RandomNumGen(int min, int max)
@@ -152,25 +434,36 @@ void GameObject::ScreenWrapper(Point2f idealPos)
 // Can give the no. objects
 int GameObject::GetObjectCount( GameObject::Type type )
 {
-	int count = 0;
+	if( type == OBJ_ALL )
+		return s_nObjectCount;
 
-	for( GameObject* p : s_vUpdateList )
-	{
-		if( p->m_type == type || type == OBJ_ALL )
-			count++;
-	}
-
-	return count;
+	PB_ASSERT_MSG( type >= OBJ_NONE && type < OBJ_TYPE_COUNT, "Object type out of range!" );
+	return s_nTypeCounts[type + 1];
 }
 
 int GameObject::GetObjectList( GameObject::Type type, std::vector< GameObject* >& vList )
 {
 	vList.clear();
 
-	for( GameObject* p : s_vUpdateList )
+	// Not every object is in an update layer, but every one is in a type list
+	if( type == OBJ_ALL )
+	{
+		for( std::vector< GameObject* >& vTypeList : s_vTypeLists )
+		{
+			for( GameObject* p : vTypeList )
+			{
+				if( p )
+					vList.push_back( p );
+			}
+		}
+	}
+	else
 	{
-		if( p->m_type == type || type == OBJ_ALL )
-			vList.push_back( p );
+		for( GameObject* p : TypeList( type ) )
+		{
+			if( p )
+				vList.push_back( p );
+		}
 	}
 
 	return vList.size();
@@ -179,19 +472,55 @@ int GameObject::GetObjectList( GameObject::Type type, std::vector< GameObject* >
 std::vector< GameObject* > GameObject::GetTypeList(GameObject::Type type)
 {
 	std::vector< GameObject* > typeList;
-	for (GameObject* p : s_vUpdateList)
-	{
-		if (p->m_type == type || type == OBJ_ALL)
-			typeList.push_back(p);
-	}
-
+	GetObjectList( type, typeList );
 	return typeList;
 }
 
 // Can remove the 
 void GameObject::DestroyAll()
 {
-	for( int n = 0; n < s_vDrawList.size(); n++ )
-		delete s_vUpdateList[n--];
+	CollisionGrid::Clear();
+
+	for( std::vector< GameObject* >& vLayer : s_vUpdateLayers )
+		vLayer.clear();
+
+	for( std::vector< GameObject* >& vLayer : s_vDrawLayers )
+		vLayer.clear();
+
+	// The lists are emptied before anything is deleted, so each object forgets its slots first
+	for( std::vector< GameObject* >& vList : s_vTypeLists )
+	{
+		std::vector< GameObject* > vDoomed;
+		vDoomed.swap( vList );
+		for( GameObject* p : vDoomed )
+		{
+			if( p )
+			{
+				p->m_updateSlot = -1;
+				p->m_drawSlot = -1;
+				p->m_typeSlot = -1;
+				delete p;
+			}
+		}
+	}
+
+	for( int& count : s_nTypeCounts )
+		count = 0;
+	s_nObjectCount = 0;
+	s_vKillList.clear();
+	s_bUpdateLayersDirty = false;
+	s_bDrawLayersDirty = false;
+	s_bTypeListsDirty = false;
 }
 
+void GameObject::DeactivateAll()
+{
+	for( std::vector< GameObject* >& vList : s_vTypeLists )
+	{
+		for( GameObject* p : vList )
+		{
+			if( p )
+				p->SetActive( false );
+		}
+	}
+}
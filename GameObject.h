@@ -1,6 +1,7 @@
 #pragma once
 #include "Play.h"
 #include "MainGame.h"
+#include "MotionStore.h"
 
 class GameObject
 {
@@ -14,6 +15,7 @@ public:
         OBJ_ASTEROID_PART,
         OBJ_GEM,
         OBJ_PARTICLE,
+        OBJ_TYPE_COUNT, // The number of real object types
         OBJ_ALL = 999
     };
 
@@ -30,37 +32,96 @@ public:
     GameObject(Point2f pos);
     virtual ~GameObject();
 
-    virtual void Update(GameState& state) = 0;
+    // Objects with no behaviour of their own can leave this alone and use SetUpdateOrder( NO_UPDATE )
+    virtual void Update(GameState& state) { (void)state; }
     virtual void Draw(GameState& state) const = 0;
+    // The sprite, frame and angle the object is drawn with, for pixel-perfect collision tests (false if it doesn't have one)
+    virtual bool GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const { (void)state; (void)spriteId; (void)frame; (void)angle; return false; }
 
-    void DrawSpecificCentred(GameState& state, const char* name) const;
+    // Draws the sprite centred on the object (the sprite's own origin is left as it is)
+    void DrawSpecificCentred(GameState& state, PlayBlitter::SpriteHandle sprite) const;
     static float RandomNumGen(int min, int max);
     static Point2f RandomPos(GameState& state);
     static float RandomAngle(Point2f pos);
     static bool CheckCollisions(GameObject* a, GameObject* b);
     void ScreenWrapper(Point2f idealPos);
 
-    void SetPosition(Point2f pos) { m_pos = pos; }
-    Point2f GetPosition() const { return m_pos; };
+    // Kinematic objects keep their position and velocity in the MotionStore instead
+    void SetPosition(Point2f pos) { if (m_bodySlot < 0) m_pos = pos; else MotionStore::SetPosition(m_bodySlot, pos); }
+    Point2f GetPosition() const { return m_bodySlot < 0 ? m_pos : MotionStore::GetPosition(m_bodySlot); };
 
-    void SetVelocity(Vector2f vel) { m_velocity = vel; }
-    Vector2f GetVelocity() const { return m_velocity; };
+    void SetVelocity(Vector2f vel) { if (m_bodySlot < 0) m_velocity = vel; else MotionStore::SetVelocity(m_bodySlot, vel); }
+    Vector2f GetVelocity() const { return m_bodySlot < 0 ? m_velocity : MotionStore::GetVelocity(m_bodySlot); };
+
+    // Where the object was at the start of the current tick (objects which aren't kinematic or updated don't move)
+    Point2f GetPrevPosition() const;
+
+    // Where to draw the object, blended between its positions at the last two ticks using state.alpha
+    Point2f GetDrawPosition(const GameState& state) const;
+
+    // Hands the object's motion over to the MotionStore, which moves it in bulk at the start of UpdateAll
+    void SetKinematic(MotionStore::WrapMode wrap);
+    bool GetKinematic() const { return m_bodySlot >= 0; }
 
     void SetRotation(float rot) { m_rot = rot; }
     float GetRotation() const { return m_rot; };
 
-    void SetActive(bool isActive) { m_active = isActive; }
+    // Deactivated objects are destroyed together at the end of the next UpdateAll
+    void SetActive(bool isActive);
     bool GetActive() const { return m_active; };
 
-    void SetType(Type type) { m_type = type; }
+    // Moves the object into the index for its new type
+    void SetType(Type type);
     Type GetType() const { return m_type; }
 
-    void SetDrawOrder(int drawOrder) { m_drawOrder = drawOrder; }
+    // Moves the object into the draw layer for the new order (higher orders are drawn first)
+    void SetDrawOrder(int drawOrder);
     int GetDrawOrder() const { return m_drawOrder; };
 
-    void SetUpdateOrder(int updateOrder) { m_updateOrder = updateOrder; }
+    // Moves the object into the update layer for the new order (higher orders are updated first)
+    // NO_UPDATE takes it out of the update layers altogether
+    void SetUpdateOrder(int updateOrder);
     int GetUpdateOrder() const { return m_updateOrder; };
 
+    // A non-allocating range over all the objects of one concrete class, already cast to that class
+    // > T must declare a static TYPE constant matching the type it passes to SetType
+    // > Objects created while iterating aren't visited, and objects deleted while iterating are skipped
+    template< class T >
+    class TypeView
+    {
+    public:
+        class Iterator
+        {
+        public:
+            Iterator( const std::vector< GameObject* >* pList, size_t index, size_t end ) : m_pList( pList ), m_index( index ), m_end( end ) { SkipEmpty(); }
+            T* operator*() const { return static_cast<T*>( ( *m_pList )[m_index] ); }
+            Iterator& operator++() { m_index++; SkipEmpty(); return *this; }
+            bool operator!=( const Iterator& other ) const { return m_index != other.m_index; }
+
+        private:
+            void SkipEmpty() { while( m_index < m_end && ( *m_pList )[m_index] == nullptr ) m_index++; }
+
+            const std::vector< GameObject* >* m_pList;
+            size_t m_index;
+            size_t m_end;
+        };
+
+        TypeView( const std::vector< GameObject* >& vList ) : m_pList( &vList ), m_end( vList.size() ) {}
+        Iterator begin() const { return Iterator( m_pList, 0, m_end ); }
+        Iterator end() const { return Iterator( m_pList, m_end, m_end ); }
+
+    private:
+        const std::vector< GameObject* >* m_pList;
+        size_t m_end;
+    };
+
+    // Gets a view of all the objects of the given class (e.g. GetTypeView< Meteor >())
+    template< class T >
+    static TypeView< T > GetTypeView() { return TypeView< T >( TypeList( T::TYPE ) ); }
+    // The same for a type chosen at run time, without the cast
+    static TypeView< GameObject > GetTypeView( Type type ) { return TypeView< GameObject >( TypeList( type ) ); }
+
+    // Constant time for any type
     static int GetObjectCount(Type eType);
     static int GetObjectList(GameObject::Type eType, std::vector< GameObject* >& vList);
     static std::vector< GameObject* > GetTypeList(GameObject::Type type);
@@ -68,27 +129,63 @@ public:
     static void UpdateAll(GameState& state);
     static void DrawAll(GameState& state);
     static void DestroyAll();
+    // Deactivates every object, so the whole world is reclaimed at the end of the next UpdateAll
+    static void DeactivateAll();
 
-protected:
+    // Update and draw orders must be in the range 0 to MAX_ORDERS-1
+    static constexpr int MAX_ORDERS = 8;
+    static constexpr int NO_UPDATE = -1;
 
-    static bool DrawOrder(const GameObject* a, const GameObject* b) { return a->m_drawOrder > b->m_drawOrder; }
-    static bool UpdateOrder(const GameObject* a, const GameObject* b) { return a->m_updateOrder > b->m_updateOrder; }
+protected:
 
     Type m_type{ OBJ_NONE };
     bool m_active{ true };
     Point2f m_pos{ 0, 0 };
+    // The position at the start of the current tick (only kept up to date for objects in an update layer)
+    Point2f m_prevPos{ 0, 0 };
     Vector2f m_velocity{ 0, 0 };
     int spriteId{ -1 };
     float m_rot{ 0.0f };
 
     int m_drawOrder{ 0 };
     int m_updateOrder{ 0 };
+    // Where the object sits in its draw and update layers (-1 if it isn't in one)
+    int m_drawSlot{ -1 };
+    int m_updateSlot{ -1 };
+    // Where the object sits in the index for its type (-1 if it isn't in one)
+    int m_typeSlot{ -1 };
+    // Where the object's motion sits in the MotionStore (-1 if it isn't kinematic)
+    int m_bodySlot{ -1 };
+    // Whether the object is already waiting in the kill list
+    bool m_killQueued{ false };
+
+    // Removes all the empty slots left behind by objects leaving a set of layers (or type lists)
+    static void CompactLayers( std::vector< GameObject* >* vLayers, int layerCount, int GameObject::* slot );
+    // Destroys everything in the kill list which is still inactive, then compacts each set of lists once
+    static void ReclaimInactive();
+    static void ReclaimEverything();
+    void Register();
 
     // Storing pointers to objects as opposed to the object data
     // This prevents having to move a lot of data around
     // Instead we just reassign the address
-    static std::vector< GameObject* > s_vUpdateList;
-    static std::vector< GameObject* > s_vDrawList;
+    // Each order has its own layer, so walking the layers from the highest order down replaces sorting every frame
+    // Objects within a layer stay in the order they were added to it
+    // Objects leaving a layer just null their slot, and the gaps are closed up in one pass later on
+    static std::vector< GameObject* > s_vUpdateLayers[MAX_ORDERS];
+    static std::vector< GameObject* > s_vDrawLayers[MAX_ORDERS];
+    static bool s_bUpdateLayersDirty;
+    static bool s_bDrawLayersDirty;
+
+    // An index of the objects of each type (OBJ_NONE included) kept up to date as objects are created and destroyed
+    static std::vector< GameObject* >& TypeList( Type type ) { return s_vTypeLists[type + 1]; }
+    static std::vector< GameObject* > s_vTypeLists[OBJ_TYPE_COUNT + 1];
+    static int s_nTypeCounts[OBJ_TYPE_COUNT + 1];
+    static int s_nObjectCount;
+    static bool s_bTypeListsDirty;
+
+    // Objects deactivated during the frame, in the order they were deactivated
+    static std::vector< GameObject* > s_vKillList;
 };
 
 
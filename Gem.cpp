@@ -5,29 +5,34 @@ void Gem::Draw(GameState& state) const
 	switch (GetGemState())
 	{
 	case STATE_BASE:
-		GameObject::DrawSpecificCentred(state, "Gem");
+		GameObject::DrawSpecificCentred(state, SPRITE_GEM);
 		break;
 	case STATE_FIVE:
-		GameObject::DrawSpecificCentred(state, "Five");
+		GameObject::DrawSpecificCentred(state, SPRITE_GEM_FIVE);
 		break;
 	case STATE_SHIELD:
-		GameObject::DrawSpecificCentred(state, "Shield");
+		GameObject::DrawSpecificCentred(state, SPRITE_GEM_SHIELD);
 		break;
 	case STATE_SPEED:
-		GameObject::DrawSpecificCentred(state, "speedUp");
+		GameObject::DrawSpecificCentred(state, SPRITE_GEM_SPEED);
 		break;
 	}
 }
 
-void Gem::Spawn(GameObject* a)
+// Uses the same sprite as Draw for each state
+bool Gem::GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const
 {
-	Point2f pos = a->GetPosition();
-	GameObject* gem = new Gem(pos);
+	const PlayBlitter::SpriteHandle sprites[] = { SPRITE_GEM, SPRITE_GEM_FIVE, SPRITE_GEM_SHIELD, SPRITE_GEM_SPEED };
+	spriteId = PlayBlitter::Instance().GetSpriteId(sprites[GetGemState()]);
+	frame = static_cast<int>(2 * state.time);
+	angle = GetRotation();
+	return true;
 }
 
-void Gem::Update(GameState& state)
+void Gem::Spawn(GameObject* a)
 {
-	
+	Point2f pos = a->GetPosition();
+	GameObject* gem = new Gem(pos);
 }
 
 
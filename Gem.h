@@ -1,18 +1,21 @@
 #pragma once
 #include "Play.h"
 #include "GameObject.h"
+#include "ObjectPool.h"
 
-class Gem : public GameObject
+class Gem : public GameObject, public PooledObject< Gem, 64 >
 {
 private:
 	int m_gemState{ 0 };
 
 public:
+	static constexpr Type TYPE = OBJ_GEM;
+
 	// Constructor and destructor
 	Gem(Point2f pos) : GameObject(pos)
 	{
-		SetType(OBJ_GEM);
-		SetUpdateOrder(1);
+		SetType(TYPE);
+		SetUpdateOrder(NO_UPDATE);
 		SetDrawOrder(5);
 		//Random chance other gems
 		// each powerup has a 1/4 chance of spawing (high for testing purposes)
@@ -57,8 +60,8 @@ public:
 	};
 
 	// Function definitions
-	void Update(GameState& state) override;
 	void Draw(GameState& state) const override;
+	bool GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const override;
 	static void Spawn(GameObject* a);
 
 	void SetGemState(int gemState) { m_gemState = gemState; }
@@ -2,7 +2,10 @@
 #include "GameObject.h"
 #include "Asteroid.h"
 #include "Meteor.h"
+#include "AsteroidPart.h"
 #include "Player.h"
+#include "ObjectPool.h"
+#include "Collision.h"
 #define PLAY_IMPLEMENTATION
 #include "Play.h"
 
@@ -23,6 +26,28 @@ int WINAPI WinMain( PLAY_WINARGS_IN )
 	blit.SetDisplayBuffer(buff.GetDisplayBuffer(), DISPLAY_WIDTH, DISPLAY_HEIGHT);
 	// Load the background image from the file
 	blit.LoadBackground("Data\\Backgrounds\\Background.png");
+	// Each sprite is always drawn and collided around the same origin, so the origins are set once here rather than before
+	// each draw (see GameObject::DrawSpecificCentred for drawing around a different one)
+	for (PlayBlitter::SpriteHandle sprite : { SPRITE_AGENT8_FLY, SPRITE_AGENT8_SPEED, SPRITE_AGENT8_DEAD, SPRITE_SHIELD_RING, SPRITE_GEM, SPRITE_GEM_FIVE, SPRITE_GEM_SHIELD, SPRITE_GEM_SPEED })
+	{
+		blit.CentreSpriteOrigin(blit.GetSpriteId(sprite));
+	}
+	blit.SetSpriteOrigin(blit.GetSpriteId(SPRITE_ASTEROID), Asteroid::asteroidCentre);
+	blit.SetSpriteOrigin(blit.GetSpriteId(SPRITE_ASTEROID_PIECES), AsteroidPart::asteroidPartCentre);
+	blit.SetSpriteOrigin(blit.GetSpriteId(SPRITE_METEOR), Meteor::meteorCentre);
+	blit.SetSpriteOrigin(blit.GetSpriteId(SPRITE_AGENT8_LEFT), Player::attachedCentre);
+	blit.SetSpriteOrigin(blit.GetSpriteId(SPRITE_AGENT8_RIGHT), Player::attachedCentre);
+	// Most of the background isn't drawn over each frame, so only the parts which were are copied back
+	blit.SetDirtyRects(true);
+	// Asteroids and meteors keep the angle they were spawned at, so their rotated frames are drawn from a cache
+	blit.SetRotationCache(256, 64 * 1024 * 1024);
+	// GameObject::DrawAll shares its drawing out between threads
+	blit.SetDrawThreads(std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+
+	// The pairs of types the collision stage looks for, and how their hits are checked once the broadphase has found them
+	CollisionGrid::SetContactPair(GameObject::OBJ_PLAYER, GameObject::OBJ_METEOR, CollisionGrid::NARROW_PIXELS);
+	CollisionGrid::SetContactPair(GameObject::OBJ_PLAYER, GameObject::OBJ_ASTEROID, CollisionGrid::NARROW_SHAPE);
+	CollisionGrid::SetContactPair(GameObject::OBJ_PLAYER, GameObject::OBJ_GEM, CollisionGrid::NARROW_SHAPE);
 	
 	//Return
 	// Display the window title
@@ -37,15 +62,28 @@ bool MainGameUpdate( float elapsedTime )
 	
 	// To keep track of the elapsed time
 	state.time += elapsedTime;
+	ObjectPool::NewFrameAll();
+
+	// Run as many fixed ticks as the elapsed time covers
+	state.tickAccumulator += elapsedTime;
+	int ticks = 0;
+	while (state.tickAccumulator >= TICK_TIME && ticks < MAX_TICKS_PER_FRAME)
+	{
+		SimulationTick();
+		state.tickAccumulator -= TICK_TIME;
+		ticks++;
+	}
+	if (state.tickAccumulator >= TICK_TIME)
+	{
+		state.tickAccumulator = 0;
+	}
+	// Only the active state moves the world, so anything else is drawn where it stopped rather than blended towards it
+	state.alpha = GetMainGameState() == ACTIVE_STATE ? state.tickAccumulator / TICK_TIME : 1.0f;
 
 	blit.DrawBackground();
 	// Calling the methods
 	GameObject::DrawAll(state);
 
-	Meteor::Spawn(state);
-	Asteroid::Spawn(state);
-	Player::Spawn(state);
-
 	switch (GetMainGameState())
 	{
 	case START_STATE:
@@ -65,6 +103,31 @@ bool MainGameUpdate( float elapsedTime )
 	return buff.KeyDown(VK_ESCAPE);
 }
 
+// Advances the game world by one fixed step
+void SimulationTick()
+{
+	Meteor::Spawn(state);
+	Asteroid::Spawn(state);
+	Player::Spawn(state);
+
+	if (GetMainGameState() == ACTIVE_STATE)
+	{
+		GameObject::UpdateAll(state);
+
+		for (Player* player : GameObject::GetTypeView<Player>())
+		{
+			if (player->GetActive())
+			{
+				player->HandleContacts(state);
+			}
+			if (player->GetIsDead())
+			{
+				SetMainGameState(GAMEOVER_STATE);
+			}
+		}
+	}
+}
+
 //Different updates depending on the current game state
 void StartStateUpdate()
 {
@@ -80,29 +143,16 @@ void StartStateUpdate()
 		SetMainGameState(ACTIVE_STATE);
 	}
 
-	blit.DrawStringCentred(blit.GetSpriteId("105px"), { DISPLAY_WIDTH / 2, 50 }, "Welcome to Sky High Spy!");
-	blit.DrawStringCentred(blit.GetSpriteId("64px"), { DISPLAY_WIDTH / 2, 2 * DISPLAY_HEIGHT / 6 }, "Use the direction buttons to aim Agent8,");
-	blit.DrawStringCentred(blit.GetSpriteId("64px"), { DISPLAY_WIDTH / 2, 3 * DISPLAY_HEIGHT / 6 }, "Press SPACE to jump between Asteroids,");
-	blit.DrawStringCentred(blit.GetSpriteId("64px"), { DISPLAY_WIDTH / 2, 4 * DISPLAY_HEIGHT / 6 }, "Press ENTER/RETURN to start the game,");
-	blit.DrawStringCentred(blit.GetSpriteId("64px"), { DISPLAY_WIDTH / 2, 5 * DISPLAY_HEIGHT / 6 }, "Press ESCAPE to quit the game.");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_105), { DISPLAY_WIDTH / 2, 50 }, "Welcome to Sky High Spy!");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_64), { DISPLAY_WIDTH / 2, 2 * DISPLAY_HEIGHT / 6 }, "Use the direction buttons to aim Agent8,");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_64), { DISPLAY_WIDTH / 2, 3 * DISPLAY_HEIGHT / 6 }, "Press SPACE to jump between Asteroids,");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_64), { DISPLAY_WIDTH / 2, 4 * DISPLAY_HEIGHT / 6 }, "Press ENTER/RETURN to start the game,");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_64), { DISPLAY_WIDTH / 2, 5 * DISPLAY_HEIGHT / 6 }, "Press ESCAPE to quit the game.");
 }
 
 void PlayStateUpdate()
 {
-	GameObject::UpdateAll(state);
-
-	PlayBlitter::Instance().DrawStringCentred(PlayBlitter::Instance().GetSpriteId("64px"), { DISPLAY_WIDTH / 2, 50 }, "SCORE: " + std::to_string(state.score));
-	
-	std::vector <GameObject*> pList = GameObject::GetTypeList(GameObject::OBJ_PLAYER);
-	for (GameObject* p : pList)
-	{
-		Player* player = dynamic_cast<Player*>(p);
-				
-		if (player != nullptr && player->GetIsDead())
-		{
-			SetMainGameState(GAMEOVER_STATE);
-		}
-	}
+	PlayBlitter::Instance().DrawStringCentred(PlayBlitter::Instance().GetSpriteId(SPRITE_FONT_64), { DISPLAY_WIDTH / 2, 50 }, "SCORE: " + std::to_string(state.score));
 }
 
 void GameOverStateUpdate()
@@ -111,17 +161,13 @@ void GameOverStateUpdate()
 
 	if (PlayBuffer::Instance().KeyDown(VK_RETURN))
 	{
-		std::vector <GameObject*> oList = GameObject::GetTypeList(GameObject::OBJ_ALL);
-		for (GameObject* o : oList)
-		{
-			o->SetActive(false);
-		}
+		GameObject::DeactivateAll();
 		state.score = 0;
 		SetMainGameState(ACTIVE_STATE);
 	}
-	blit.DrawStringCentred(blit.GetSpriteId("151px"), { DISPLAY_WIDTH / 2, 50 }, "GAME OVER:");
-	blit.DrawStringCentred(blit.GetSpriteId("64"), { DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 }, "Press ENTER/RETURN to retry!");
-	blit.DrawStringCentred(blit.GetSpriteId("64"), { DISPLAY_WIDTH / 2, 3 * DISPLAY_HEIGHT / 4 }, "Press ESCAPE to Quit.");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_151), { DISPLAY_WIDTH / 2, 50 }, "GAME OVER:");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_64), { DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 }, "Press ENTER/RETURN to retry!");
+	blit.DrawStringCentred(blit.GetSpriteId(SPRITE_FONT_64), { DISPLAY_WIDTH / 2, 3 * DISPLAY_HEIGHT / 4 }, "Press ESCAPE to Quit.");
 
 }
 
@@ -132,14 +178,16 @@ void MainGameExit( void )
 	PlayBlitter::Destroy();
 	PlaySpeaker::Destroy();
 	GameObject::DestroyAll();
+	ObjectPool::PrintStatsAll();
 }
 
 
 bool HasCollided(Point2f pos1, Point2f pos2)
 {
-	Vector2f d = pos2 - pos1;
-	float dist = sqrt((d.x * d.x) + (d.y * d.y));
-	if (dist < S_SCREEN_LIMIT)
+	// Comparing squared distances saves the square root
+	// Objects wrap round the screen, so they can touch across an edge
+	float distSq = CollisionGrid::TorusDistanceSq(pos1, pos2);
+	if (distSq < S_SCREEN_LIMIT * S_SCREEN_LIMIT)
 	{
 		return true;
 	}
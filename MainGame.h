@@ -8,6 +8,7 @@
     static void SetMainGameState(int pState) { m_mainGameState = pState; }
     static int GetMainGameState() { return m_mainGameState; }
 
+    void SimulationTick();
     void StartStateUpdate();
     void PlayStateUpdate();
     void GameOverStateUpdate();
@@ -19,6 +20,10 @@
         float time{ 0 };
         int score{ 0 };
         int difficulty{ 0 };
+        // Elapsed time which hasn't been simulated yet
+        float tickAccumulator{ 0 };
+        // How far the frame being drawn is between the last tick and the next one (0 to 1)
+        float alpha{ 1 };
     };
 
     static enum MainGameState
@@ -35,4 +40,32 @@
     const double pi = 3.14159265358979323846;
     const double MAX_SPEED = sqrt(9);
 
-    static constexpr int S_SCREEN_LIMIT = 50;
\ No newline at end of file
+    static constexpr int S_SCREEN_LIMIT = 50;
+
+    // The simulation steps at a fixed rate however often frames are drawn (velocities are in pixels per tick)
+    const int TICKS_PER_SECOND = 60;
+    const float TICK_TIME = 1.0f / TICKS_PER_SECOND;
+    // Any time left over after this many ticks in one frame is dropped, so the game slows down rather than falling further behind
+    const int MAX_TICKS_PER_FRAME = 5;
+
+    // The sprites the game draws, by their full names, hashed at compile time so looking up their ids does no string work
+    constexpr PlayBlitter::SpriteHandle SPRITE_ASTEROID{ "asteroid_2" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_ASTEROID_PIECES{ "asteroid_pieces_3" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_METEOR{ "meteor_2" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_AGENT8_FLY{ "agent8_fly" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_AGENT8_SPEED{ "agent8_spd" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_AGENT8_LEFT{ "agent8_left_7" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_AGENT8_RIGHT{ "agent8_right_7" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_AGENT8_DEAD{ "agent8_dead_2" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_SHIELD_RING{ "shield_ring" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_GEM{ "gem" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_GEM_FIVE{ "five" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_GEM_SHIELD{ "shield" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_GEM_SPEED{ "speedup" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_PARTICLE{ "particle" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_PARTICLE_GREY{ "particle2" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_SPARKLE_WHITE{ "white_sparkle" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_SPARKLE_YELLOW{ "yellow_sparkle" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_FONT_64{ "font64px_10x10" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_FONT_105{ "font105px_10x10" };
+    constexpr PlayBlitter::SpriteHandle SPRITE_FONT_151{ "font151px_10x10" };
\ No newline at end of file
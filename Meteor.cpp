@@ -2,10 +2,16 @@
 
 void Meteor::Draw(GameState& state) const
 {
-	const int meteorID = PlayBlitter::Instance().GetSpriteId("meteor_2");
-	Vector2f newOrigin = { 64,45 };
-	PlayBlitter::Instance().SetSpriteOrigin(meteorID, newOrigin);
-	PlayBlitter::Instance().DrawRotated(meteorID, GetPosition(), 2 * state.time, GetRotation() + pi / 2);
+	const int meteorID = PlayBlitter::Instance().GetSpriteId(SPRITE_METEOR);
+	PlayBlitter::Instance().DrawRotated(meteorID, GetDrawPosition(state), 2 * state.time, GetRotation() + pi / 2);
+}
+
+bool Meteor::GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const
+{
+	spriteId = PlayBlitter::Instance().GetSpriteId(SPRITE_METEOR);
+	frame = static_cast<int>(2 * state.time);
+	angle = static_cast<float>(GetRotation() + pi / 2);
+	return true;
 }
 
 void Meteor::Spawn(GameState& state)
@@ -21,14 +27,4 @@ void Meteor::Spawn(GameState& state)
 		Vector2f currentVel = { Vx, Vy };
 		m->SetVelocity(currentVel);
 	}
-}
-
-void Meteor::Update(GameState& state)
-{
-	Point2f currentPos = GetPosition();
-	Vector2f currentVel = GetVelocity();
-	// Move until the meteor hits the screen edge then despawn
-	Point2f idealPos = { currentPos.x + currentVel.x, currentPos.y + currentVel.y };
-	SetPosition(idealPos);
-	GameObject::ScreenWrapper(idealPos);
 }
\ No newline at end of file
@@ -1,15 +1,22 @@
 #pragma once
 #include "Play.h"
 #include "GameObject.h"
+#include "ObjectPool.h"
 
-class Meteor : public GameObject
+class Meteor : public GameObject, public PooledObject< Meteor, 64 >
 {
 public:
+	// The sprite's origin (set once at startup)
+	static inline const Point2f meteorCentre{ 64, 45 };
+
+	static constexpr Type TYPE = OBJ_METEOR;
+
 	// Constructor and destructor
 	Meteor(Point2f pos) : GameObject(pos)
 	{
-		SetType(OBJ_METEOR);
-		SetUpdateOrder(2);
+		SetType(TYPE);
+		SetUpdateOrder(NO_UPDATE);
+		SetKinematic(MotionStore::WRAP_SCREEN);
 		SetDrawOrder(3);
 	}
 
@@ -19,8 +26,8 @@ public:
 	}
 
 	// Function definitions
-	void Update(GameState& state) override;
 	void Draw(GameState& state) const override;
+	bool GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const override;
 	static void Spawn(GameState& state);
 
 private:
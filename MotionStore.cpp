@@ -0,0 +1,142 @@
+#include <emmintrin.h>
+#include "MotionStore.h"
+
+std::vector< float > MotionStore::s_vX;
+std::vector< float > MotionStore::s_vY;
+std::vector< float > MotionStore::s_vPrevX;
+std::vector< float > MotionStore::s_vPrevY;
+std::vector< float > MotionStore::s_vVX;
+std::vector< float > MotionStore::s_vVY;
+std::vector< uint32_t > MotionStore::s_vWrapMask;
+std::vector< int* > MotionStore::s_vSlots;
+
+// The edges used by GameObject::ScreenWrapper
+static const float WRAP_LEFT = static_cast<float>( -S_SCREEN_LIMIT );
+static const float WRAP_RIGHT = static_cast<float>( DISPLAY_WIDTH + S_SCREEN_LIMIT );
+static const float WRAP_TOP = 0.0f;
+static const float WRAP_BOTTOM = static_cast<float>( DISPLAY_HEIGHT + S_SCREEN_LIMIT );
+
+int MotionStore::Add( int* pSlot, Point2f pos, Vector2f vel, WrapMode wrap )
+{
+	int slot = static_cast<int>( s_vX.size() );
+	s_vX.push_back( pos.x );
+	s_vY.push_back( pos.y );
+	s_vPrevX.push_back( pos.x );
+	s_vPrevY.push_back( pos.y );
+	s_vVX.push_back( vel.x );
+	s_vVY.push_back( vel.y );
+	s_vWrapMask.push_back( wrap == WRAP_SCREEN ? 0xFFFFFFFF : 0 );
+	s_vSlots.push_back( pSlot );
+
+	*pSlot = slot;
+	return slot;
+}
+
+// Swaps the last body into the hole so the arrays stay packed
+void MotionStore::Remove( int slot )
+{
+	PB_ASSERT_MSG( slot >= 0 && slot < static_cast<int>( s_vX.size() ), "Motion slot out of range!" );
+
+	int last = static_cast<int>( s_vX.size() ) - 1;
+	if( slot != last )
+	{
+		s_vX[slot] = s_vX[last];
+		s_vY[slot] = s_vY[last];
+		s_vPrevX[slot] = s_vPrevX[last];
+		s_vPrevY[slot] = s_vPrevY[last];
+		s_vVX[slot] = s_vVX[last];
+		s_vVY[slot] = s_vVY[last];
+		s_vWrapMask[slot] = s_vWrapMask[last];
+		s_vSlots[slot] = s_vSlots[last];
+		*s_vSlots[slot] = slot;
+	}
+
+	s_vX.pop_back();
+	s_vY.pop_back();
+	s_vPrevX.pop_back();
+	s_vPrevY.pop_back();
+	s_vVX.pop_back();
+	s_vVY.pop_back();
+	s_vWrapMask.pop_back();
+	s_vSlots.pop_back();
+}
+
+// Matches ScreenWrapper exactly: crossing the left or right edge only moves x, otherwise crossing the top or bottom moves y
+void MotionStore::IntegrateRange( int start, int end )
+{
+	for( int n = start; n < end; n++ )
+	{
+		s_vPrevX[n] = s_vX[n];
+		s_vPrevY[n] = s_vY[n];
+		float x = s_vX[n] + s_vVX[n];
+		float y = s_vY[n] + s_vVY[n];
+
+		if( s_vWrapMask[n] )
+		{
+			if( x > WRAP_RIGHT )
+				x = WRAP_LEFT;
+			else if( x < WRAP_LEFT )
+				x = WRAP_RIGHT;
+			else if( y < WRAP_TOP )
+				y = WRAP_BOTTOM;
+			else if( y > WRAP_BOTTOM )
+				y = WRAP_TOP;
+		}
+
+		s_vX[n] = x;
+		s_vY[n] = y;
+	}
+}
+
+void MotionStore::IntegrateAllScalar()
+{
+	IntegrateRange( 0, GetBodyCount() );
+}
+
+// The else-if chain in ScreenWrapper becomes a set of masks, with the y tests cancelled out wherever x has already wrapped
+void MotionStore::IntegrateAll()
+{
+	const int count = GetBodyCount();
+	const int simdEnd = count & ~3;
+
+	const __m128 left = _mm_set1_ps( WRAP_LEFT );
+	const __m128 right = _mm_set1_ps( WRAP_RIGHT );
+	const __m128 top = _mm_set1_ps( WRAP_TOP );
+	const __m128 bottom = _mm_set1_ps( WRAP_BOTTOM );
+
+	float* pX = s_vX.data();
+	float* pY = s_vY.data();
+	float* pPrevX = s_vPrevX.data();
+	float* pPrevY = s_vPrevY.data();
+	const float* pVX = s_vVX.data();
+	const float* pVY = s_vVY.data();
+	const uint32_t* pWrap = s_vWrapMask.data();
+
+	for( int n = 0; n < simdEnd; n += 4 )
+	{
+		__m128 prevX = _mm_loadu_ps( pX + n );
+		__m128 prevY = _mm_loadu_ps( pY + n );
+		_mm_storeu_ps( pPrevX + n, prevX );
+		_mm_storeu_ps( pPrevY + n, prevY );
+
+		__m128 x = _mm_add_ps( prevX, _mm_loadu_ps( pVX + n ) );
+		__m128 y = _mm_add_ps( prevY, _mm_loadu_ps( pVY + n ) );
+		__m128 wrap = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pWrap + n ) ) );
+
+		__m128 pastRight = _mm_and_ps( wrap, _mm_cmpgt_ps( x, right ) );
+		__m128 pastLeft = _mm_and_ps( wrap, _mm_cmplt_ps( x, left ) );
+		__m128 wrapY = _mm_andnot_ps( _mm_or_ps( pastRight, pastLeft ), wrap );
+		__m128 pastTop = _mm_and_ps( wrapY, _mm_cmplt_ps( y, top ) );
+		__m128 pastBottom = _mm_and_ps( wrapY, _mm_cmpgt_ps( y, bottom ) );
+
+		x = _mm_or_ps( _mm_andnot_ps( pastRight, x ), _mm_and_ps( pastRight, left ) );
+		x = _mm_or_ps( _mm_andnot_ps( pastLeft, x ), _mm_and_ps( pastLeft, right ) );
+		y = _mm_or_ps( _mm_andnot_ps( pastTop, y ), _mm_and_ps( pastTop, bottom ) );
+		y = _mm_or_ps( _mm_andnot_ps( pastBottom, y ), _mm_and_ps( pastBottom, top ) );
+
+		_mm_storeu_ps( pX + n, x );
+		_mm_storeu_ps( pY + n, y );
+	}
+
+	IntegrateRange( simdEnd, count );
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Play.h"
+#include "MainGame.h"
+
+// Positions and velocities of kinematic objects (ones which just drift in a straight line) kept as structure-of-arrays
+// This lets them all be moved together by one SIMD loop instead of each having its own virtual Update
+// Bodies are addressed by slot, and removing one moves the last body into its place (telling its owner the new slot)
+class MotionStore
+{
+public:
+    // Whether a body wraps around the screen edges in the same way as GameObject::ScreenWrapper
+    enum WrapMode
+    {
+        WRAP_NONE = 0,
+        WRAP_SCREEN
+    };
+
+    // Returns the new body's slot, which is also written to pSlot and kept up to date as other bodies are removed
+    static int Add(int* pSlot, Point2f pos, Vector2f vel, WrapMode wrap);
+    static void Remove(int slot);
+
+    static Point2f GetPosition(int slot) { return { s_vX[slot], s_vY[slot] }; }
+    static void SetPosition(int slot, Point2f pos) { s_vX[slot] = pos.x; s_vY[slot] = pos.y; }
+    // Where the body was before the last integration, for drawing between ticks
+    static Point2f GetPrevPosition(int slot) { return { s_vPrevX[slot], s_vPrevY[slot] }; }
+    static Vector2f GetVelocity(int slot) { return { s_vVX[slot], s_vVY[slot] }; }
+    static void SetVelocity(int slot, Vector2f vel) { s_vVX[slot] = vel.x; s_vVY[slot] = vel.y; }
+
+    static int GetBodyCount() { return static_cast<int>(s_vX.size()); }
+
+    // Adds each body's velocity to its position then applies its wrapping, using SSE2 four bodies at a time
+    // The old positions are kept as the previous positions
+    static void IntegrateAll();
+    // The same with one body at a time (gives identical results)
+    static void IntegrateAllScalar();
+
+private:
+    static void IntegrateRange(int start, int end);
+
+    static std::vector< float > s_vX;
+    static std::vector< float > s_vY;
+    static std::vector< float > s_vPrevX;
+    static std::vector< float > s_vPrevY;
+    static std::vector< float > s_vVX;
+    static std::vector< float > s_vVY;
+    // All bits set for bodies which wrap, so it can be used directly as a SIMD mask
+    static std::vector< uint32_t > s_vWrapMask;
+    // Where each body's owner keeps its slot
+    static std::vector< int* > s_vSlots;
+};
@@ -0,0 +1,101 @@
+#include "ObjectPool.h"
+
+ObjectPool* ObjectPool::s_pFirstPool = nullptr;
+
+// Blocks are rounded up so every one stays aligned for any type, and has room for the free list link
+ObjectPool::ObjectPool( const char* name, size_t blockSize, int blocksPerChunk )
+{
+	PB_ASSERT( blocksPerChunk > 0 );
+	const size_t align = alignof( std::max_align_t );
+	m_name = name;
+	m_blockSize = ( std::max( blockSize, sizeof( void* ) ) + align - 1 ) & ~( align - 1 );
+	m_blocksPerChunk = blocksPerChunk;
+
+	m_pNextPool = s_pFirstPool;
+	s_pFirstPool = this;
+}
+
+ObjectPool::~ObjectPool()
+{
+	for( void* pChunk : m_vChunks )
+		free( pChunk );
+
+	ObjectPool** ppPool = &s_pFirstPool;
+	while( *ppPool != this )
+		ppPool = &( *ppPool )->m_pNextPool;
+	*ppPool = m_pNextPool;
+}
+
+void* ObjectPool::Allocate( size_t size )
+{
+	PB_ASSERT_MSG( size <= m_blockSize, "Object is too big for its pool: derived classes need a pool of their own" );
+
+	if( m_pFreeList == nullptr )
+		AddChunk();
+
+	void* p = m_pFreeList;
+	m_pFreeList = *static_cast<void**>( p );
+
+	m_liveCount++;
+	m_highWaterMark = std::max( m_highWaterMark, m_liveCount );
+	m_frameAllocations++;
+	m_totalAllocations++;
+	return p;
+}
+
+void ObjectPool::Free( void* p )
+{
+	if( p == nullptr )
+		return;
+
+	*static_cast<void**>( p ) = m_pFreeList;
+	m_pFreeList = p;
+	m_liveCount--;
+}
+
+void ObjectPool::Reserve( int capacity )
+{
+	while( m_capacity < capacity )
+		AddChunk();
+}
+
+// Threads the new blocks onto the free list in address order so fresh objects are laid out contiguously
+void ObjectPool::AddChunk()
+{
+	char* pChunk = static_cast<char*>( malloc( m_blockSize * m_blocksPerChunk ) );
+	PB_ASSERT_MSG( pChunk, "Out of memory growing object pool" );
+	m_vChunks.push_back( pChunk );
+
+	for( int n = m_blocksPerChunk - 1; n >= 0; n-- )
+	{
+		void* pBlock = pChunk + n * m_blockSize;
+		*static_cast<void**>( pBlock ) = m_pFreeList;
+		m_pFreeList = pBlock;
+	}
+
+	m_capacity += m_blocksPerChunk;
+}
+
+void ObjectPool::NewFrameAll()
+{
+	for( ObjectPool* pPool = s_pFirstPool; pPool; pPool = pPool->m_pNextPool )
+	{
+		pPool->m_lastFrameAllocations = pPool->m_frameAllocations;
+		pPool->m_peakFrameAllocations = std::max( pPool->m_peakFrameAllocations, pPool->m_frameAllocations );
+		pPool->m_frameAllocations = 0;
+	}
+}
+
+// Anything still live at exit has leaked, as pooled objects don't show up in the memory tracker
+void ObjectPool::PrintStatsAll()
+{
+	for( ObjectPool* pPool = s_pFirstPool; pPool; pPool = pPool->m_pNextPool )
+	{
+		DebugOutput( "POOL " + std::string( pPool->m_name ) +
+			": live " + std::to_string( pPool->m_liveCount ) +
+			", high-water " + std::to_string( pPool->m_highWaterMark ) +
+			", capacity " + std::to_string( pPool->m_capacity ) +
+			", peak per frame " + std::to_string( pPool->m_peakFrameAllocations ) +
+			", total " + std::to_string( pPool->m_totalAllocations ) + "\n" );
+	}
+}
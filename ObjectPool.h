@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <typeinfo>
+#include "Play.h"
+
+// A fixed-block allocator for objects which are created and destroyed in large numbers
+// Blocks are carved out of contiguous chunks and recycled through a free list, so nothing goes back to the heap until exit
+class ObjectPool
+{
+public:
+    ObjectPool(const char* name, size_t blockSize, int blocksPerChunk);
+    ~ObjectPool();
+
+    void* Allocate(size_t size);
+    void Free(void* p);
+
+    // Allocates enough chunks up front to hold the given number of objects
+    void Reserve(int capacity);
+
+    const char* GetName() const { return m_name; }
+    int GetCapacity() const { return m_capacity; }
+    int GetLiveCount() const { return m_liveCount; }
+    int GetHighWaterMark() const { return m_highWaterMark; }
+    // The number of allocations made during the previous frame
+    int GetFrameAllocations() const { return m_lastFrameAllocations; }
+    int GetPeakFrameAllocations() const { return m_peakFrameAllocations; }
+    int GetTotalAllocations() const { return m_totalAllocations; }
+
+    // Closes off the per-frame stats for every pool (call once at the start of each frame)
+    static void NewFrameAll();
+    // Prints the stats for every pool to the debug output
+    static void PrintStatsAll();
+
+private:
+    void AddChunk();
+
+    const char* m_name;
+    size_t m_blockSize;
+    int m_blocksPerChunk;
+
+    // Each free block stores a pointer to the next one in its first bytes
+    void* m_pFreeList{ nullptr };
+    std::vector< void* > m_vChunks;
+
+    int m_capacity{ 0 };
+    int m_liveCount{ 0 };
+    int m_highWaterMark{ 0 };
+    int m_frameAllocations{ 0 };
+    int m_lastFrameAllocations{ 0 };
+    int m_peakFrameAllocations{ 0 };
+    int m_totalAllocations{ 0 };
+
+    // All the pools are linked together so they can be updated as a group
+    ObjectPool* m_pNextPool{ nullptr };
+    static ObjectPool* s_pFirstPool;
+};
+
+// Gives a class its own ObjectPool by overriding its new and delete operators
+// > Use as an extra base class: class Particle : public GameObject, public PooledObject< Particle >
+// > The number of blocks in each chunk can be tuned per class, and GetPool().Reserve() pre-allocates capacity
+// The memory tracker's 'new' macro would mangle the operator declarations, so it is suspended here
+#pragma push_macro("new")
+#undef new
+
+template< class T, int BLOCKS_PER_CHUNK = 256 >
+class PooledObject
+{
+public:
+    static void* operator new(size_t size) { return GetPool().Allocate(size); }
+    static void* operator new(size_t size, const char* file, int line) { (void)file; (void)line; return GetPool().Allocate(size); }
+    static void operator delete(void* p) { GetPool().Free(p); }
+    static void operator delete(void* p, const char* file, int line) { (void)file; (void)line; GetPool().Free(p); }
+
+    static ObjectPool& GetPool()
+    {
+        static ObjectPool pool(typeid(T).name(), sizeof(T), BLOCKS_PER_CHUNK);
+        return pool;
+    }
+};
+
+#pragma pop_macro("new")
@@ -8,16 +8,16 @@ void Particle::Draw(GameState& state) const
 	switch (Particle::GetParticleState())
 	{
 	case WHITE_DUST:
-		GameObject::DrawSpecificCentred(state, "particle");
+		GameObject::DrawSpecificCentred(state, SPRITE_PARTICLE);
 		break;
 	case GREY_DUST:
-		GameObject::DrawSpecificCentred(state, "particle2");
+		GameObject::DrawSpecificCentred(state, SPRITE_PARTICLE_GREY);
 		break;
 	case WHITE:
-		GameObject::DrawSpecificCentred(state, "white_sparkle");
+		GameObject::DrawSpecificCentred(state, SPRITE_SPARKLE_WHITE);
 		break;
 	case YELLOW:
-		GameObject::DrawSpecificCentred(state, "yellow_sparkle");
+		GameObject::DrawSpecificCentred(state, SPRITE_SPARKLE_YELLOW);
 		break;
 	}
 }
@@ -39,12 +39,7 @@ void Particle::Spawn(GameObject* a, int type)
 
 void Particle::Update(GameState& state)
 {
-	Point2f currentPos = GetPosition();
-	Vector2f currentVel = GetVelocity();
-
-	Point2f idealPos = { currentPos.x + currentVel.x, currentPos.y + currentVel.y };
-	SetPosition(idealPos);
-
+	// The particle's movement is handled by the MotionStore, this just times its life
 	if (GetHasTimerRun() == false)
 	{
 		endTime = std::chrono::steady_clock::now()
@@ -1,9 +1,10 @@
 #pragma once
 #include "Play.h"
 #include "GameObject.h"
+#include "ObjectPool.h"
 
 
-class Particle : public GameObject
+class Particle : public GameObject, public PooledObject< Particle, 1024 >
 {
 protected:
 	bool m_hasTimerRun{ false };
@@ -11,11 +12,14 @@ protected:
 	int m_particleType{ 0 };
 
 public:
+	static constexpr Type TYPE = OBJ_PARTICLE;
+
 	// Constructor and destructor
 	Particle(Point2f pos, int type) : GameObject(pos)
 	{
-		SetType(OBJ_PARTICLE);
+		SetType(TYPE);
 		SetUpdateOrder(1);
+		SetKinematic(MotionStore::WRAP_NONE);
 		SetDrawOrder(6);
 
 		float randNum = GameObject::RandomNumGen(1, 2);
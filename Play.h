@@ -25,11 +25,15 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cmath> 
+#include <immintrin.h>
 
 #include <string>
 #include <sstream>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <list>
+#include <memory>
 #include <algorithm>
 #include <chrono>
 #include <iostream>
@@ -37,6 +41,9 @@
 #include <filesystem>
 #include <thread>
 #include <future>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 
 #define WIN32_LEAN_AND_MEAN // Exclude rarely-used stuff from Windows headers
@@ -101,10 +108,23 @@ constexpr float PLAY_PI	= 3.14159265358979323846f;   // pi
 // Description:	Declaration for a simple memory tracker to prevent leaks
 //********************************************************************************************************************************
 
-// Prints out all the currently allocated memory to the debug output
+// The memory tracker is on by default in debug builds and compiled out completely in release builds
+// > Define PLAY_MEMORY_TRACKING as 0 or 1 before including Play.h to override this
+#ifndef PLAY_MEMORY_TRACKING
+#ifdef _DEBUG
+#define PLAY_MEMORY_TRACKING 1
+#else
+#define PLAY_MEMORY_TRACKING 0
+#endif
+#endif
+
+#if PLAY_MEMORY_TRACKING
+
+// Prints out all the currently allocated memory to the debug output, in the order it was allocated
 void PrintAllocations( const char* tagText );
 
 // Allocate some memory with a known origin
+// > The file name must be a string literal (as __FILE__ is) as only the pointer is stored
 void* operator new(size_t size, const char* file, int line);
 // Allocate some memory with a known origin
 void* operator new[](size_t size, const char* file, int line); 
@@ -122,6 +142,13 @@ void operator delete[](void* p, const char* file, int line);
 #define new new( __FILE__ , __LINE__ )
 //#endif
 
+#else
+
+// The tracker is compiled out so there is nothing to print
+inline void PrintAllocations( const char* tagText ) { (void)tagText; }
+
+#endif // PLAY_MEMORY_TRACKING
+
 #endif
 //*******************************************************************
 // PLAY END: PlayMemory.h
@@ -596,6 +623,10 @@ private:
 	int GetDebugStringWidth( const std::string& s );
 	// Draws the offset points from the origin in all octants
 	void DrawCircleOctants( int posX, int posY, int offX, int offY, Pixel pix );
+	// Sets the colour of a pixel like DrawPixel, without marking it for the blitter
+	void BlendPixel( int posX, int posY, Pixel srcPix );
+	// Marks a rectangle (right and bottom excluded) as drawn over, if the blitter is restoring dirty parts of this buffer
+	void MarkDirty( int left, int top, int right, int bottom ) const;
 	// Ends the current timing segment and calculates the duration
 	LARGE_INTEGER EndTimingSegment();
 
@@ -672,7 +703,11 @@ public:
 	// Destroys the PlayBlitter instance
 	static void Destroy();
 	// Set the display buffer for all subsequent drawing operations
-	void SetDisplayBuffer( uint32_t* pDisplayBuffer, int bufferWidth, int bufferHeight ) { m_displayBuffer = pDisplayBuffer; m_displayBufferWidth = bufferWidth; m_displayBufferHeight = bufferHeight; }
+	void SetDisplayBuffer( uint32_t* pDisplayBuffer, int bufferWidth, int bufferHeight ) { m_displayBuffer = pDisplayBuffer; m_displayBufferWidth = bufferWidth; m_displayBufferHeight = bufferHeight; m_restoreAll = true; }
+	// Gets the display buffer the blitter draws to
+	const uint32_t* GetDisplayBuffer() const { return m_displayBuffer; }
+	// Returns true if the PlayBlitter instance has been created
+	static bool HasInstance() { return s_pInstance != nullptr; }
 
 	//********************************************************************************************************************************
 	// Loading functions
@@ -689,9 +724,31 @@ public:
 	// Sprite Getters and Setters
 	//********************************************************************************************************************************
 
-	// Gets the sprite id of the first matching sprite whose filename contains the given text
+	// The 64-bit FNV-1a hash of a sprite name, ignoring case (so it matches the upper case names sprites are stored with)
+	static constexpr uint64_t HashSpriteName( const char* spriteName )
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for( const char* p = spriteName; *p; p++ )
+		{
+			const char c = ( *p >= 'a' && *p <= 'z' ) ? static_cast<char>( *p - 'a' + 'A' ) : *p;
+			hash = ( hash ^ static_cast<uint8_t>( c ) ) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+	// A sprite's name hashed for looking up its id, so the string isn't needed each time
+	// > Declared constexpr, the hash is worked out at compile time, so the lookup in GetSpriteId does no string work at all
+	struct SpriteHandle
+	{
+		constexpr SpriteHandle( const char* spriteName ) : hash( HashSpriteName( spriteName ) ) {}
+		uint64_t hash;
+	};
+	// Gets the id of the sprite whose filename (without the extension) is the given name, ignoring case
 	// > Returns -1 if not found
-	int GetSpriteId( const char* spriteName ) const;
+	int GetSpriteId( SpriteHandle sprite ) const;
+	int GetSpriteId( const char* spriteName ) const { return GetSpriteId( SpriteHandle( spriteName ) ); }
+	// Gets the sprite id of the first matching sprite whose filename contains the given text
+	// > Returns -1 if not found. This searches every sprite's name, so it's much slower than GetSpriteId
+	int FindSpriteId( const char* partialName ) const;
 	// Gets the root filename of a specific sprite
 	const std::string& GetSpriteName( int spriteId );
 	// Gets the size of the sprite with the given id
@@ -715,16 +772,100 @@ public:
 	// Drawing functions
 	//********************************************************************************************************************************
 
+	// Settings for a single draw which would otherwise mean changing the sprite, so drawing never changes any sprite data
+	// > A tint or a flip makes the blit go through a row buffer, so they're a little slower than a plain draw
+	struct DrawParams
+	{
+		float alphaMultiply{ 1.0f }; // As DrawTransparent
+		uint32_t tint{ 0x00FFFFFF }; // Each colour channel c becomes ( c * tint ) >> 8, like ColourSprite (white leaves it alone)
+		bool useOrigin{ false }; // Whether origin is used instead of the sprite's own origin
+		Vector2f origin{ 0, 0 }; // Offset from the top left of the sprite (whole pixels only)
+		bool flipX{ false }; // Mirrors the sprite left to right about its origin
+		bool flipY{ false }; // Mirrors the sprite top to bottom about its origin
+	};
+
 	// Draw the sprite without rotation or transparency (fastest draw)
-	inline void Draw( int spriteId, Point2f pos, int frameIndex ) const { BlitSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex ); }
+	inline void Draw( int spriteId, Point2f pos, int frameIndex ) const { BlitSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex, {} ); }
 	// Draw the sprite with transparency (slower than without transparency)
-	inline void DrawTransparent( int spriteId, Point2f pos, int frameIndex, float alphaMultiply ) const { BlitSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex, alphaMultiply ); }; // This just to force people to consider when they use an explicit alpha multiply
-	// Draw the sprite rotated with transprency (slowest draw)
-	inline void DrawRotated( int spriteId, Point2f pos, int frameIndex, float angle, float scale = 1.0f, float alphaMultiply = 1.0f ) const { RotateScaleSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex, angle, scale, alphaMultiply ); }
+	inline void DrawTransparent( int spriteId, Point2f pos, int frameIndex, float alphaMultiply ) const { BlitSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex, { alphaMultiply } ); }; // This just to force people to consider when they use an explicit alpha multiply
+	// Draw the sprite rotated with transprency (slowest draw, unless the frame is in the rotation cache - see SetRotationCache)
+	inline void DrawRotated( int spriteId, Point2f pos, int frameIndex, float angle, float scale = 1.0f, float alphaMultiply = 1.0f ) const { RotateScaleSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex, angle, scale, { alphaMultiply } ); }
+	// Draw the sprite with per-draw settings
+	inline void Draw( int spriteId, Point2f pos, int frameIndex, const DrawParams& params ) const { BlitSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex, params ); }
+	// Draw the sprite rotated with per-draw settings
+	inline void DrawRotated( int spriteId, Point2f pos, int frameIndex, float angle, float scale, const DrawParams& params ) const { RotateScaleSprite( spriteId, static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), frameIndex, angle, scale, params ); }
 	// Draws a previously loaded background image
 	void DrawBackground( int backgroundIndex = 0 );
+
+	// Makes DrawBackground copy back only the parts of the background which have been drawn over since the last DrawBackground,
+	// instead of the whole background (the default)
+	// > The display buffer is split into cells of DIRTY_CELL_SIZE pixels, and the draws mark the cells they touch, which are 
+	//   merged into rectangles to copy. PlayBuffer's drawing functions mark what they draw too, but anything else which 
+	//   writes to the display buffer has to mark it with AddDirtyRect (or call RestoreAllBackground)
+	// > The whole background is copied when more than fullCopyCoverage of the cells are dirty, as one big copy is faster then
+	void SetDirtyRects( bool enable, float fullCopyCoverage = 0.5f );
+	bool GetDirtyRects() const { return m_dirtyRects; }
+	// Marks part of the display buffer as drawn over, so the next DrawBackground copies it back
+	void AddDirtyRect( Point2f topLeft, Point2f bottomRight );
+	// Makes the next DrawBackground copy the whole background, for when all (or an unknown part) of the display buffer has been drawn over
+	void RestoreAllBackground() { m_restoreAll = true; }
+	// What the last DrawBackground did: the rectangles it copied, the bytes it copied, and whether it copied everything
+	struct BackgroundRestoreStats
+	{
+		int rects{ 0 };
+		size_t bytes{ 0 };
+		bool fullCopy{ true };
+	};
+	const BackgroundRestoreStats& GetBackgroundRestoreStats() const { return m_restoreStats; }
+	// The width and height of the dirty cells (16 pixels is one 64 byte cache line per cell row)
+	static constexpr int DIRTY_CELL_SIZE = 16;
+
+	// The instruction sets the blending in BlitSprite can use (each level includes the ones before it)
+	enum SimdLevel
+	{
+		SIMD_NONE = 0, // One pixel at a time
+		SIMD_SSE2, // Four pixels at a time
+		SIMD_AVX2, // Eight pixels at a time
+	};
+	// Limits the instruction sets BlitSprite uses (the best one the CPU supports is used by default)
+	// > All the levels give exactly the same results, so this is only useful for comparing them
+	void SetSimdLevel( SimdLevel level ) { m_simdLevel = std::min( level, m_maxSimdLevel ); }
+	SimdLevel GetSimdLevel() const { return m_simdLevel; }
+
+	// Makes DrawRotated (at a scale of 1) blit copies of sprite frames rotated to the nearest of angleSteps, each made the 
+	// first time it's needed, which is much faster for sprites which don't turn much (0 angleSteps turns the cache off)
+	// > Rotated frames are blended as Draw would blend them, and their edges can be out by a pixel on large sprites
+	// > The least recently drawn frames are freed when the cache goes over the budget (in bytes)
+	void SetRotationCache( int angleSteps, size_t budgetBytes );
+	// Frees all the rotated frames in the cache
+	void ClearRotationCache();
+	// How the rotation cache is being used: draws it had the frame for, draws it didn't, frames freed to stay in the 
+	// budget, and the memory it is using
+	struct RotationCacheStats
+	{
+		uint64_t hits{ 0 }, misses{ 0 }, evictions{ 0 };
+		size_t bytes{ 0 };
+	};
+	const RotationCacheStats& GetRotationCacheStats() const { return m_rotationStats; }
+	// Gets the number of rotated frames in the cache
+	int GetRotationCacheSize() const { return static_cast<int>( m_rotatedFrames.size() ); }
+
+	// Records sprite draws (Draw, DrawTransparent, DrawRotated and the text functions) instead of making them, until EndBatch
+	// > EndBatch splits the display buffer into bands of BAND_HEIGHT rows which the draw threads share out, and each band makes 
+	//   the draws which touch it in the order they were recorded, so the result is exactly the same as drawing them straight away
+	// > The sprites' pixels are read by EndBatch, so sprites can't be recoloured (see ColourSprite) during a batch
+	void BeginBatch();
+	void EndBatch();
+	bool IsBatching() const { return m_batching; }
+	// Sets how many threads EndBatch uses, including the calling thread (1 makes every draw on the calling thread)
+	void SetDrawThreads( int threads );
+	int GetDrawThreads() const { return static_cast<int>( m_vDrawWorkers.size() ) + 1; }
+	// The height of the bands EndBatch splits the display buffer into
+	// > Full-width bands cost less than square tiles, as rows aren't split into short pieces for the blend kernels
+	static constexpr int BAND_HEIGHT = 16;
 	// Multiplies the sprite image buffer by the colour values
 	// > Applies to all subseqent drawing calls for this sprite, but can be reset by calling agin with rgb set to white
+	// > This redoes PreMultiplyAlpha over the whole sprite, so to colour a single draw use DrawParams::tint instead
 	void ColourSprite( int spriteId, int r, int g, int b );
 
 	// Draws a string using a sprite-based font exported from PlayFontTool
@@ -740,6 +881,69 @@ public:
 
 	// A pixel-based sprite collision test based on drawing
 	bool SpriteCollide( int s1Id, Point2f s1Pos, int s1FrameIndex, float s1Angle, int s1PixelColl[4], int s2Id, Point2f s2pos, int s2FrameIndex, float s2Angle, int s2PixelColl[4] ) const;
+	// A pixel-based sprite collision test using 1-bit masks, comparing 64 pixels at a time (much faster than SpriteCollide)
+	// > Sprites are placed and rotated around their origins as DrawRotated would draw them
+	// > Angles are rounded to the nearest of MASK_ANGLE_STEPS, so edges can be out by a pixel on large sprites
+	bool SpriteMaskCollide( int s1Id, Point2f s1Pos, int s1FrameIndex, float s1Angle, int s2Id, Point2f s2Pos, int s2FrameIndex, float s2Angle ) const;
+	// Frees the rotated collision masks, which are otherwise cached for each sprite frame and angle used
+	void ClearMaskCache();
+	// Sets the most memory the rotated collision masks can use (in bytes), freeing the least recently used ones to stay in it
+	// > Without a budget the cache could hold a mask for every frame of every sprite at each of MASK_ANGLE_STEPS angles
+	// > The two most recently used masks are always kept, as SpriteMaskCollide needs both of them at once
+	void SetMaskCacheBudget( size_t budgetBytes );
+	// How the mask cache is being used, counted in the same way as the rotation cache
+	const RotationCacheStats& GetMaskCacheStats() const { return m_maskStats; }
+	// Gets the number of rotated collision masks in the cache
+	int GetMaskCacheSize() const { return static_cast<int>( m_rotatedMasks.size() ); }
+	// The number of angles that rotated collision masks are made for
+	static constexpr int MASK_ANGLE_STEPS = 256;
+	// The mask cache's budget until SetMaskCacheBudget is called
+	static constexpr size_t DEFAULT_MASK_BUDGET = 16 << 20;
+
+	// A collision primitive for a sprite, loaded from its .INF file
+	// > Coordinates are in pixels from the top left of a frame, so they don't depend on where the origin is set
+	struct CollisionShape
+	{
+		enum Type : uint8_t
+		{
+			SHAPE_NONE = 0, // No shape was given, so the frame's bounding box is used
+			SHAPE_CIRCLE, // points[0] is the centre
+			SHAPE_CAPSULE, // A line from points[0] to points[1] with rounded ends
+			SHAPE_HULL, // A convex polygon with pointCount points in order (clockwise or anticlockwise)
+		};
+		Type type{ SHAPE_NONE };
+		uint8_t pointCount{ 0 };
+		uint16_t firstPoint{ 0 }; // Where the shape's points start in the shared point table
+		float radius{ 0.0f }; // The distance the shape reaches out from its points (zero for hulls)
+	};
+	static constexpr int MAX_HULL_POINTS = 8;
+
+	// Gets the collision shape of the sprite with the given id
+	const CollisionShape& GetSpriteShape( int spriteId ) const { return m_vCollisionShapes[spriteId]; }
+	// Gets the furthest the sprite's collision shape reaches from its origin (at any angle)
+	float GetSpriteShapeReach( int spriteId ) const;
+	// A collision test between the collision shapes of two sprites, placed and rotated around their origins as DrawRotated would draw them
+	bool SpriteShapeCollide( int s1Id, Point2f s1Pos, float s1Angle, int s2Id, Point2f s2Pos, float s2Angle ) const;
+
+	// A run of pixels [left, right) in a sprite row, between runs of fully transparent pixels
+	// > Copy spans are opaque enough for BlendRow to copy them straight to the display buffer. Blend spans can contain short 
+	//   runs of transparent or opaque pixels which weren't worth a span of their own
+	struct PixelSpan
+	{
+		uint16_t left{ 0 }, right{ 0 };
+		bool copy{ false };
+	};
+	// The spans of a block of rows: row n has spans pSpans[pRowStarts[n]] up to pSpans[pRowStarts[n + 1]], left to right
+	struct SpanRows
+	{
+		const uint32_t* pRowStarts{ nullptr };
+		const PixelSpan* pSpans{ nullptr };
+	};
+	// The pixels of a frame which aren't fully transparent all lie in these columns [left, right) and rows [top, bottom)
+	struct OpaqueBox
+	{
+		int left{ 0 }, top{ 0 }, right{ 0 }, bottom{ 0 };
+	};
 
 	// Internal sprite structure for storing individual sprite data
 	struct Sprite
@@ -751,12 +955,24 @@ public:
 		int hCount{ -1 }, vCount{ -1 }, totalCount{ -1 };  // The number of sprite images in the canvas horizontally and verticaally
 		int originX{ 0 }, originY{ 0 }; // The origin and centre of rotation for the sprite (whole pixels only)
 		uint32_t* pCanvasBuffer{ nullptr }; // The sprite data
-		uint32_t* pPreMultAlpha{ nullptr }; // The sprite data premultiplied with its own alpha
+		uint32_t* pPreMultAlpha{ nullptr }; // The sprite data premultiplied with its own alpha, one frame after another (see FramePixels)
+		uint32_t* pPreMultBuffer{ nullptr }; // The allocation pPreMultAlpha is aligned within
+		int frameStride{ 0 }; // The number of pixels from one row of a frame to the next (the width rounded up to whole cache lines)
+		std::vector< uint64_t > vCollisionMask; // One bit for each pixel which isn't fully transparent, row by row for each frame in turn
+		int maskWordsPerRow{ 0 }; // The number of 64-bit words in each row of the collision mask (the lowest bit is the leftmost pixel)
+		std::vector< uint32_t > vRowSpanStarts; // Where each row's spans start in vSpans, row by row for each frame in turn (and the end)
+		std::vector< PixelSpan > vSpans; // The spans of all the rows
+		std::vector< OpaqueBox > vOpaqueBoxes; // The extent of each frame
 		Sprite() = default;
+		// The top left pre-multiplied pixel of a frame
+		const uint32_t* FramePixels( int frame ) const { return pPreMultAlpha + static_cast<size_t>( frameStride ) * height * frame; }
 	};
 
 private:
 
+	// The PlayTests project checks the internal kernels and structures through this class
+	friend class PlayBlitterTests;
+
 	//********************************************************************************************************************************
 	// Constructors / destructors
 	//********************************************************************************************************************************
@@ -776,13 +992,175 @@ private:
 
 	// Draws a sprite using a direct copy of the sprite image to the display buffer
 	// > Setting AlphaMultiply < 1 forces a less optimal rendering approach in BlitSprite
-	void BlitSprite( int spriteId, int xpos, int ypos, int frameIndex, float alphaMultiply = 1.0f ) const;
+	void BlitSprite( int spriteId, int xpos, int ypos, int frameIndex, const DrawParams& params ) const;
+	// A rectangle of the display buffer which drawing is limited to (the right and bottom are exclusive)
+	struct ClipRect
+	{
+		int left{ 0 }, top{ 0 }, right{ 0 }, bottom{ 0 };
+	};
+	ClipRect GetBufferRect() const { return { 0, 0, m_displayBufferWidth, m_displayBufferHeight }; }
+	// Draws a block of pre-multiplied pixels (a sprite frame or a rotated frame) to the display buffer, or records it in the batch
+	void SubmitBlit( const uint32_t* pSrc, int srcStride, const SpanRows& spans, int width, int height, int left, int top, const DrawParams& params ) const;
+	// Draws a block of pre-multiplied pixels to the part of the display buffer inside the clip rectangle
+	void BlitPixels( const uint32_t* pSrc, int srcStride, const SpanRows& spans, int width, int height, int left, int top, const DrawParams& params, const ClipRect& clip ) const;
 	// Draws a sprite rotated and sclaed to the display buffer (much slower than Blit
 	// > AlphaMultiply isn't a signfiicant additional slow down on RotateScaleSprite
-	void RotateScaleSprite( int spriteId, int xpos, int ypos, int frameIndex, float angle, float scale, float alphaMultiply = 1.0f ) const;
+	void RotateScaleSprite( int spriteId, int xpos, int ypos, int frameIndex, float angle, float scale, const DrawParams& params ) const;
+	// Blends a row of pre-multiplied sprite pixels onto the display buffer, skipping runs of fully-transparent pixels
+	// > There's a version for each SimdLevel, and they all give the same results
+	static void BlendRow( uint32_t* destPixels, const uint32_t* srcPixels, int count );
+	static void BlendRowSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count );
+	static void BlendRowAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count );
+	// The same with a global alpha multiply (which must be from 0 to 1)
+	static void BlendRowAlpha( uint32_t* destPixels, const uint32_t* srcPixels, int count, float alphaMultiply );
+	static void BlendRowAlphaSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count, float alphaMultiply );
+	static void BlendRowAlphaAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count, float alphaMultiply );
+	// Copies a copy span (see PixelSpan) to the display buffer, which gives the same results as blending it with BlendRow
+	static void CopyRow( uint32_t* destPixels, const uint32_t* srcPixels, int count );
+	static void CopyRowSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count );
+	static void CopyRowAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count );
+	// Copies a row of pre-multiplied pixels with each colour channel multiplied by a tint (see DrawParams), leaving the 
+	// transparent pixels as they are
+	static void TintRow( uint32_t* destPixels, const uint32_t* srcPixels, int count, uint32_t tint );
+	static void TintRowSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count, uint32_t tint );
+	static void TintRowAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count, uint32_t tint );
+	// Copies a row of a block into a row buffer, tinted and mirrored as the draw parameters say
+	// > markRuns works out the transparent runs of a mirrored row again, which isn't needed for pixels that are copied
+	static void PrepareRow( uint32_t* destPixels, const uint32_t* srcPixels, int count, const DrawParams& params, SimdLevel simdLevel, bool markRuns );
+	// Where a rotated and scaled sprite lands in a buffer, and how it samples the sprite frame (see RotateScaleSprite)
+	struct RotatedRect
+	{
+		int startX{ 0 }, startY{ 0 }, endX{ 0 }, endY{ 0 }; // The pixels it covers, clipped to the buffer (the ends are exclusive)
+		float startU{ 0 }, startV{ 0 }; // The position in the sprite frame of the top left pixel
+		float dUdY{ 0 }, dVdY{ 0 }; // The change in u and v from one row to the next
+		int32_t uStep{ 0 }, vStep{ 0 }; // The change in u and v from one pixel to the next, in 16.16 fixed point
+		bool flipX{ false }; // Whether u is in the mirrored frame (see SampleU)
+		int frameWidth{ 0 }; // The width of the sprite frame, which u is mirrored across
+	};
+	static void GetRotatedRect( const Sprite& spr, int originX, int originY, bool flipX, int xpos, int ypos, float angle, float scale, int width, int height, RotatedRect& rect );
+	// Turns a 16.16 position and step along a row of a RotatedRect into ones in the sprite frame (which only differ if it's mirrored)
+	static void SampleU( const RotatedRect& rect, int32_t& u, int32_t& uStep );
+	// Works out which pixels of a row of a RotatedRect land in the opaque part of the frame, and where the first one samples it
+	static void GetRotatedSpan( const RotatedRect& rect, const OpaqueBox& box, int y, int& first, int& last, int32_t& u, int32_t& v );
+	// Draws a rotated sprite frame to the display buffer, or records it in the batch
+	void SubmitRotated( const uint32_t* pSrcBase, int srcStride, const OpaqueBox& box, const RotatedRect& rect, const DrawParams& params ) const;
+	// Marks the dirty cells a rectangle of the display buffer touches, if dirty rectangles are on
+	void MarkDirty( const ClipRect& rect ) const;
+	// Copies the dirty cells back from the background, merged into rectangles, and returns false if too many are dirty
+	bool RestoreDirtyCells( const uint32_t* pBackground );
+	// Draws a rotated sprite frame to the part of the display buffer inside the clip rectangle
+	// > Clipping doesn't change which pixels of the sprite are sampled, so a draw split up between bands matches one which isn't
+	void DrawRotatedRect( const uint32_t* pSrcBase, int srcStride, const OpaqueBox& box, const RotatedRect& rect, const DrawParams& params, const ClipRect& clip ) const;
+	// Narrows a span of pixels to where a stepped 16.16 fixed-point coordinate is within a range (see RotateScaleSprite)
+	static void ClipSpan( int64_t start, int64_t step, int64_t low, int64_t high, int& first, int& last );
+	// Copies the pixels along a line through a sprite frame into a row, ready for blending
+	static void GatherRow( const uint32_t* pSrc, int srcStride, int32_t u, int32_t v, int32_t uStep, int32_t vStep, int count, uint32_t* pDest );
+	static void GatherRowAVX2( const uint32_t* pSrc, int srcStride, int32_t u, int32_t v, int32_t uStep, int32_t vStep, int count, uint32_t* pDest );
+	// Sets the run length in each transparent pixel of a row (see PreMultiplyAlpha)
+	static void MarkTransparentRuns( uint32_t* pPixels, int count );
+	// Converts to 16.16 fixed point, rounding to nearest
+	static int32_t ToFixed( double value ) { return static_cast<int32_t>( std::floor( value * 65536.0 + 0.5 ) ); }
+	// The number of pixels RotateScaleSprite copies out of the sprite at a time
+	static constexpr int ROTATE_CHUNK = 256;
+	// Finds the best instruction set the CPU (and operating system) supports
+	static SimdLevel DetectSimdLevel();
 	// Multiplies the sprite image by its own alpha transparency values to save repeating this calculation on every draw
 	// > A colour multiplication can also be applied at this stage, which affects all subseqent drawing operations on the sprite
-	void PreMultiplyAlpha( uint32_t* source, uint32_t* dest, int width, int height, int maxSkipWidth, float alphaMultiply, uint32_t colourMultiply );
+	// > The frames are copied out of the canvas one after another, so each one is contiguous (see Sprite::FramePixels)
+	void PreMultiplyAlpha( Sprite& s, float alphaMultiply, uint32_t colourMultiply );
+	// Rows of sprite frames start on a 64-byte cache line, so the number of pixels from one row to the next is a multiple of this
+	static constexpr int FRAME_ROW_ALIGN = 64 / sizeof( uint32_t );
+
+	//********************************************************************************************************************************
+	// Internal functions relating to collision masks
+	//********************************************************************************************************************************
+
+	// A sprite frame's collision mask rotated to one of the quantized angles
+	struct RotatedMask
+	{
+		int originX{ 0 }, originY{ 0 }; // The sprite origin it was made for
+		int left{ 0 }, top{ 0 }; // The position of the top left of the mask relative to the sprite origin
+		int width{ 0 }, height{ 0 }, wordsPerRow{ 0 };
+		std::vector< uint64_t > bits;
+		std::list< uint64_t >::iterator lru; // Where it is in m_maskLru
+		size_t bytes{ 0 }; // The memory it counts against the budget
+	};
+
+	// Creates the collision mask for every frame in the sprite
+	void BuildCollisionMask( Sprite& s );
+	// Works out the spans of each row, and the opaque box of each frame, of a sprite
+	void BuildPixelSpans( Sprite& s );
+	// Adds the spans of a row of pre-multiplied pixels (with their transparent runs marked) to the vector
+	static void EncodeSpans( const uint32_t* pPixels, int width, std::vector< PixelSpan >& vSpans );
+	// Spans are only split at runs of at least this many transparent pixels, and only copy at least this many pixels
+	static constexpr int MIN_SKIP_SPAN = 16;
+	static constexpr int MIN_COPY_SPAN = 32;
+	// Blend spans are padded to a multiple of this many pixels (a group for BlendRowAVX2) when there's room
+	static constexpr int SPAN_GROUP = 8;
+	static_assert( MIN_SKIP_SPAN >= SPAN_GROUP, "Padded spans would run into the next span!" );
+	// Reads the collision shape (if there is one) following the origin in a sprite's .INF file
+	void LoadCollisionShape( int spriteId, std::istream& info );
+	// Gets a sprite's collision shape as up to MAX_HULL_POINTS points relative to the origin, returning the number of points
+	int GetShapePoints( int spriteId, Point2f* pPoints, float& radius ) const;
+	// Gets the rotated collision mask from the cache, creating it if it isn't there (or the sprite origin has moved)
+	const RotatedMask& GetRotatedMask( int spriteId, int frameIndex, int angleStep ) const;
+	// Frees the least recently used rotated masks until the cache uses no more than the limit (in bytes)
+	void TrimMaskCache( size_t limit ) const;
+
+	//********************************************************************************************************************************
+	// Internal functions relating to the rotation cache
+	//********************************************************************************************************************************
+
+	// A sprite frame rotated to one of the cached angles
+	struct RotatedFrame
+	{
+		int originX{ 0 }, originY{ 0 }; // The sprite origin it was made for (before any flip)
+		int left{ 0 }, top{ 0 }; // The position of the top left relative to the sprite origin
+		int width{ 0 }, height{ 0 };
+		std::vector< uint32_t > pixels; // Pre-multiplied with transparent runs, like Sprite::pPreMultAlpha
+		std::vector< uint32_t > rowStarts; // Where each row's spans start (and the end)
+		std::vector< PixelSpan > spans;
+		std::list< uint64_t >::iterator lru; // Where it is in m_rotationLru
+		size_t bytes{ 0 }; // The memory it counts against the budget
+	};
+
+	// Gets a rotated frame from the cache, making it if it isn't there (or it was made for another origin)
+	const RotatedFrame* GetRotatedFrame( int spriteId, int frameIndex, float angle, int originX, int originY, bool flipX ) const;
+	// Frees the least recently drawn rotated frames until the cache uses no more than the limit (in bytes)
+	void TrimRotationCache( size_t limit ) const;
+	// Frees the rotated frames of a sprite whose pixels have changed
+	void ForgetRotatedFrames( int spriteId );
+	// Frees a rotated frame, or keeps it until the end of the batch if one is being recorded (as draws may point to it)
+	void RetireRotatedFrame( RotatedFrame& frame ) const;
+
+	//********************************************************************************************************************************
+	// Internal functions relating to batches
+	//********************************************************************************************************************************
+
+	// A draw recorded in a batch, with everything about where it goes already worked out
+	struct DrawCommand
+	{
+		bool rotated{ false }; // Drawn by DrawRotatedRect rather than BlitPixels
+		DrawParams params;
+		const uint32_t* pSrc{ nullptr }; // The top left pixel of the frame
+		int srcStride{ 0 };
+		SpanRows spans; // For blits
+		int width{ 0 }, height{ 0 }, left{ 0 }, top{ 0 }; // For blits
+		OpaqueBox box; // For rotated draws
+		RotatedRect rect; // For rotated draws
+		ClipRect bounds; // The part of the display buffer it can touch
+	};
+
+	// Records a draw in the batch, unless it's completely off the display buffer
+	void RecordDraw( DrawCommand command ) const;
+	// Makes the draws in a band in order, clipped to the band
+	void DrawBand( int band ) const;
+	// Draws bands until there aren't any left (run by the calling thread and the draw threads together)
+	void DrawBands();
+	// What each draw thread runs, starting from the batch it was made during
+	void DrawWorker( int generation );
+	// Stops and joins the draw threads
+	void StopDrawWorkers();
 
 	// Count of the total number of sprites loaded
 	int m_nTotalSprites{ 0 };
@@ -795,11 +1173,64 @@ private:
 	int m_displayBufferWidth{ 0 };
 	// height of the assigned display buffer
 	int m_displayBufferHeight{ 0 };
+	// The best instruction set the CPU supports, and the one BlitSprite is using
+	SimdLevel m_maxSimdLevel{ DetectSimdLevel() };
+	SimdLevel m_simdLevel{ m_maxSimdLevel };
 
 	// A vector of all the loaded sprites
 	std::vector< Sprite > vSpriteData;
+	// The sprite ids keyed on the hashes of their names (see SpriteHandle)
+	std::unordered_map< uint64_t, int > m_spriteIds;
 	// A vector of all the loaded backgrounds
 	std::vector< uint32_t* > vBackgroundData;
+	// Rotated collision masks keyed on sprite id, frame and angle step, their keys from most to least recently used, and
+	// the memory budget they're kept to
+	mutable std::unordered_map< uint64_t, RotatedMask > m_rotatedMasks;
+	mutable std::list< uint64_t > m_maskLru;
+	mutable RotationCacheStats m_maskStats;
+	size_t m_maskBudget{ DEFAULT_MASK_BUDGET };
+	// Rotated frames keyed the same way (with a bit for whether they are flipped), and their keys from most to least recently drawn
+	mutable std::unordered_map< uint64_t, RotatedFrame > m_rotatedFrames;
+	mutable std::list< uint64_t > m_rotationLru;
+	mutable RotationCacheStats m_rotationStats;
+	// The number of angles in the rotation cache (0 when it's off), and its memory budget
+	int m_rotationSteps{ 0 };
+	size_t m_rotationBudget{ 0 };
+	// Rotated frames freed during a batch, which have to last until it's drawn
+	mutable std::vector< RotatedFrame > m_vRetiredFrames;
+
+	// Whether draws are being recorded, and the draws recorded so far
+	bool m_batching{ false };
+	mutable std::vector< DrawCommand > m_vDrawCommands;
+	// The recorded draws which touch each band, in order
+	std::vector< std::vector< int > > m_vBandCommands;
+	// The draw threads, which wait for m_drawGeneration to change, and then draw bands until m_nextBand runs out
+	std::vector< std::thread > m_vDrawWorkers;
+	std::mutex m_drawMutex;
+	std::condition_variable m_drawStart;
+	std::condition_variable m_drawDone;
+	int m_drawGeneration{ 0 };
+	int m_drawBusy{ 0 }; // The draw threads still working on the current batch
+	bool m_stopDrawWorkers{ false };
+	std::atomic< int > m_nextBand{ 0 };
+	// Whether DrawBackground only copies back the dirty cells, and the share of them which makes it copy everything
+	bool m_dirtyRects{ false };
+	float m_fullCopyCoverage{ 0.5f };
+	// One byte per cell, set when a draw touches it
+	mutable std::vector< uint8_t > m_vDirtyCells;
+	int m_dirtyColumns{ 0 };
+	int m_dirtyRows{ 0 };
+	// The background the display buffer was last cleared to, and whether it all has to be copied next time anyway
+	int m_lastBackground{ -1 };
+	bool m_restoreAll{ true };
+	BackgroundRestoreStats m_restoreStats;
+	// The rectangles being built from the dirty cells, and the ones which can still grow downwards (both in cells)
+	std::vector< ClipRect > m_vRestoreRects;
+	std::vector< int > m_vOpenRects;
+	// The collision shape of each sprite, indexed by sprite id
+	std::vector< CollisionShape > m_vCollisionShapes;
+	// The points of all the collision shapes, one after another
+	std::vector< Point2f > m_vShapePoints;
 
 	// A pointer to the static instance
 	static PlayBlitter* s_pInstance;
@@ -1058,11 +1489,11 @@ namespace Play
 	void DrawLine( Point2D start, Point2D end, Colour col );
 	// Draws a single-pixel wide circle in the given colour
 	void DrawCircle( Point2D pos, int radius, Colour col );
-	// Draws a line between two points using a sprite
-	// > Note that colouring affects subsequent DrawSprite calls using the same sprite!!
+	// The draw parameters which tint a sprite with a colour, without changing the sprite as ColourSprite does
+	PlayBlitter::DrawParams TintParams( Colour c );
+	// Draws a line between two points using a sprite, tinted with the colour
 	void DrawSpriteLine( Point2D startPos, Point2D endPos, const char* penSprite, Colour c = cWhite );
-	// Draws a circle using a sprite
-	// > Note that colouring affects subsequent DrawSprite calls using the same sprite!!
+	// Draws a circle using a sprite, tinted with the colour
 	void DrawSpriteCircle( int x, int y, int radius, const char* penSprite, Colour c = cWhite );
 	// Draws text using a sprite-based font exported from PlayFontTool
 	void DrawFontText( const char* fontId, std::string text, Point2D pos, Align justify = LEFT );
@@ -1196,27 +1627,192 @@ namespace Play
 // #TODO : Review the use of the 'new' macro it could be asking for trouble.
 #undef new
 
-constexpr int MAX_ALLOCATIONS = 8192 * 4;
+#if PLAY_MEMORY_TRACKING
+
 constexpr int MAX_FILENAME = 1024;
+// The starting number of slots in the allocation table (doubles whenever it gets half full)
+constexpr unsigned int MIN_ALLOC_TABLE_SIZE = 4096; // Must be a power of two
+// The starting number of slots in the call site table (doubles whenever it gets half full)
+constexpr unsigned int MIN_CALLSITE_TABLE_SIZE = 256; // Must be a power of two
 
 // A structure to store data on each memory allocation
 struct ALLOC
 {
-    void* address = 0;
-    char file[MAX_FILENAME] = { 0 };
-    int line = 0;
+    void* address = nullptr;
     size_t size = 0;
+    unsigned int callSite = 0; // Index into g_vCallSites
+    unsigned int sequence = 0; // The order the allocations were made in (the table itself is in no useful order)
+};
 
-    ALLOC(void* a, const char* fn, int l, size_t s) { address = a; line = l; size = s; strcpy_s(file, fn); };
-    ALLOC(void) { };
+// A structure to store each distinct file and line which has allocated memory
+// > Only the pointer to the file name is kept, which is fine for the string literals provided by __FILE__
+struct CALLSITE
+{
+    const char* file = nullptr;
+    int line = 0;
 };
 
-ALLOC g_vAllocations[MAX_ALLOCATIONS];
+// An open-addressed (linear probing) hash table of all the current allocations, keyed on their address
+ALLOC* g_vAllocations = nullptr;
+unsigned int g_vAllocTableSize = 0;
 unsigned int g_vAllocCount = 0;
+unsigned int g_allocSequence = 0;
+
+// The interned call sites, stored in the order they were first seen
+CALLSITE* g_vCallSites = nullptr;
+unsigned int g_vCallSiteCount = 0;
+unsigned int g_vCallSiteCapacity = 0;
+
+// An open-addressed hash table mapping a file and line onto its position in g_vCallSites (stored +1 so zero means empty)
+unsigned int* g_vCallSiteIndex = nullptr;
+unsigned int g_vCallSiteIndexSize = 0;
 
 
 void CreateStaticObject( void );
 
+//********************************************************************************************************************************
+// Call site functions
+//********************************************************************************************************************************
+
+// Finds the preferred slot in the call site index for a file and line
+inline unsigned int CallSiteHome( const char* file, int line, unsigned int tableSize )
+{
+    unsigned long long key = ( reinterpret_cast<unsigned long long>( file ) ^ ( static_cast<unsigned long long>( line ) << 40 ) );
+    return static_cast<unsigned int>( ( key * 0x9E3779B97F4A7C15ull ) >> 32 ) & ( tableSize - 1 );
+}
+
+// Doubles the size of the call site index and storage
+// > Uses the C allocation functions directly as we can't use new from inside new!
+void GrowCallSites( void )
+{
+    unsigned int newSize = g_vCallSiteIndexSize ? g_vCallSiteIndexSize * 2 : MIN_CALLSITE_TABLE_SIZE;
+    unsigned int* newIndex = static_cast<unsigned int*>( calloc( newSize, sizeof( unsigned int ) ) );
+    CALLSITE* newSites = static_cast<CALLSITE*>( realloc( g_vCallSites, sizeof( CALLSITE ) * ( newSize / 2 ) ) );
+    PB_ASSERT( newIndex && newSites );
+
+    for( unsigned int c = 0; c < g_vCallSiteCount; c++ )
+    {
+        unsigned int slot = CallSiteHome( newSites[c].file, newSites[c].line, newSize );
+        while( newIndex[slot] != 0 )
+            slot = ( slot + 1 ) & ( newSize - 1 );
+        newIndex[slot] = c + 1;
+    }
+
+    free( g_vCallSiteIndex );
+    g_vCallSiteIndex = newIndex;
+    g_vCallSiteIndexSize = newSize;
+    g_vCallSites = newSites;
+    g_vCallSiteCapacity = newSize / 2;
+}
+
+// Returns the id of a file and line, adding it to the call site table the first time it's seen
+unsigned int InternCallSite( const char* file, int line )
+{
+    if( g_vCallSiteCount >= g_vCallSiteCapacity )
+        GrowCallSites();
+
+    unsigned int slot = CallSiteHome( file, line, g_vCallSiteIndexSize );
+    while( g_vCallSiteIndex[slot] != 0 )
+    {
+        const CALLSITE& c = g_vCallSites[g_vCallSiteIndex[slot] - 1];
+        if( c.file == file && c.line == line )
+            return g_vCallSiteIndex[slot] - 1;
+        slot = ( slot + 1 ) & ( g_vCallSiteIndexSize - 1 );
+    }
+
+    g_vCallSites[g_vCallSiteCount] = CALLSITE{ file, line };
+    g_vCallSiteIndex[slot] = ++g_vCallSiteCount;
+    return g_vCallSiteCount - 1;
+}
+
+//********************************************************************************************************************************
+// Allocation table functions
+//********************************************************************************************************************************
+
+// Finds the preferred slot in the allocation table for an address
+inline unsigned int AllocHome( const void* p, unsigned int tableSize )
+{
+    // Allocations are at least 16 byte aligned so the low bits carry no information (Fibonacci hashing spreads the rest)
+    unsigned long long key = reinterpret_cast<unsigned long long>( p ) >> 4;
+    return static_cast<unsigned int>( ( key * 0x9E3779B97F4A7C15ull ) >> 32 ) & ( tableSize - 1 );
+}
+
+// Finds the allocation table slot holding the given address, or the empty slot where it would go
+inline unsigned int AllocFind( const void* p )
+{
+    unsigned int mask = g_vAllocTableSize - 1;
+    unsigned int slot = AllocHome( p, g_vAllocTableSize );
+    while( g_vAllocations[slot].address != nullptr && g_vAllocations[slot].address != p )
+        slot = ( slot + 1 ) & mask;
+    return slot;
+}
+
+// Doubles the size of the allocation table and rehashes the existing allocations into it
+void GrowAllocations( void )
+{
+    unsigned int oldSize = g_vAllocTableSize;
+    ALLOC* oldTable = g_vAllocations;
+
+    g_vAllocTableSize = oldSize ? oldSize * 2 : MIN_ALLOC_TABLE_SIZE;
+    g_vAllocations = static_cast<ALLOC*>( calloc( g_vAllocTableSize, sizeof( ALLOC ) ) );
+    PB_ASSERT( g_vAllocations );
+
+    for( unsigned int a = 0; a < oldSize; a++ )
+    {
+        if( oldTable[a].address != nullptr )
+            g_vAllocations[AllocFind( oldTable[a].address )] = oldTable[a];
+    }
+
+    free( oldTable );
+}
+
+// Records a new allocation
+void TrackAllocation( void* p, const char* file, int line, size_t size )
+{
+    if( p == nullptr )
+        return;
+
+    // Keep the table at most half full so that the probe sequences stay short
+    if( ( g_vAllocCount + 1 ) * 2 > g_vAllocTableSize )
+        GrowAllocations();
+
+    unsigned int slot = AllocFind( p );
+    if( g_vAllocations[slot].address == nullptr )
+        g_vAllocCount++;
+
+    g_vAllocations[slot] = ALLOC{ p, size, InternCallSite( file, line ), g_allocSequence++ };
+}
+
+// Forgets an allocation by shifting back any later entries in the same probe sequence (no tombstones needed)
+void UntrackAllocation( void* p )
+{
+    if( p == nullptr || g_vAllocCount == 0 )
+        return;
+
+    unsigned int mask = g_vAllocTableSize - 1;
+    unsigned int slot = AllocFind( p );
+    if( g_vAllocations[slot].address == nullptr )
+        return; // Not an allocation we know about
+
+    unsigned int next = slot;
+    for( ;; )
+    {
+        next = ( next + 1 ) & mask;
+        if( g_vAllocations[next].address == nullptr )
+            break;
+
+        // An entry can only move back if its preferred slot doesn't lie cyclically between the hole and its current slot
+        unsigned int home = AllocHome( g_vAllocations[next].address, g_vAllocTableSize );
+        if( ( ( next - home ) & mask ) >= ( ( next - slot ) & mask ) )
+        {
+            g_vAllocations[slot] = g_vAllocations[next];
+            slot = next;
+        }
+    }
+    g_vAllocations[slot] = ALLOC{};
+    g_vAllocCount--;
+}
+
 //********************************************************************************************************************************
 // Overrides for new operator (x4)
 //********************************************************************************************************************************
@@ -1226,37 +1822,33 @@ void CreateStaticObject( void );
 // the safest appproach. The two definitions of new without the file and line pick up any other memory allocations for completeness.
 void* operator new( size_t size, const char *file, int line )
 {
-    PB_ASSERT(g_vAllocCount < MAX_ALLOCATIONS);
     CreateStaticObject();
     void* p = malloc(size);
-    g_vAllocations[g_vAllocCount++] = ALLOC{ p, file, line, size };
+    TrackAllocation( p, file, line, size );
     return p;
 }
 
 void* operator new[](size_t size, const char* file, int line)
 {
-    PB_ASSERT(g_vAllocCount < MAX_ALLOCATIONS);
     CreateStaticObject();
     void* p = malloc(size);
-    g_vAllocations[g_vAllocCount++] = ALLOC{ p, file, line, size };
+    TrackAllocation( p, file, line, size );
     return p;
 }
 
 void* operator new(size_t size)
 {
-    PB_ASSERT(g_vAllocCount < MAX_ALLOCATIONS);
     CreateStaticObject();
     void* p = malloc(size);
-    g_vAllocations[g_vAllocCount++] = ALLOC{ p, "Unknown", 0, size };
+    TrackAllocation( p, "Unknown", 0, size );
     return p;
 }
 
 void* operator new[](size_t size)
 {
-    PB_ASSERT(g_vAllocCount < MAX_ALLOCATIONS);
     CreateStaticObject();
     void* p = malloc(size);
-    g_vAllocations[g_vAllocCount++] = ALLOC{ p, "Unknown", 0, size };
+    TrackAllocation( p, "Unknown", 0, size );
     return p;
 }
 
@@ -1275,15 +1867,7 @@ void operator delete(void* p, const char* file, int line)
 
 void operator delete(void* p)
 {
-    for (unsigned int a=0; a<g_vAllocCount; a++ )
-    {
-        if (g_vAllocations[a].address == p)
-        {
-            g_vAllocations[a] = g_vAllocations[g_vAllocCount-1];
-            g_vAllocations[g_vAllocCount-1].address = nullptr;
-            g_vAllocCount--;
-        }
-    }
+    UntrackAllocation( p );
     free(p);
 }
 
@@ -1296,15 +1880,7 @@ void operator delete[](void* p, const char* file, int line)
 
 void operator delete[](void* p)
 {
-    for (unsigned int a = 0; a < g_vAllocCount; a++)
-    {
-        if (g_vAllocations[a].address == p)
-        {
-            g_vAllocations[a] = g_vAllocations[g_vAllocCount - 1];
-            g_vAllocations[g_vAllocCount - 1].address = nullptr;
-            g_vAllocCount--;
-        }
-    }
+    UntrackAllocation( p );
     free(p);
 }
 
@@ -1334,6 +1910,16 @@ void CreateStaticObject( void )
     static DestroyedLast last;
 }
 
+// Orders allocation records by when they were made
+int CompareAllocSequence( const void* a, const void* b )
+{
+    unsigned int sa = static_cast<const ALLOC*>( a )->sequence;
+    unsigned int sb = static_cast<const ALLOC*>( b )->sequence;
+    return ( sa > sb ) - ( sa < sb );
+}
+
+// The allocations are printed in the order they were made, so the report is the same from run to run
+// > The live records are copied out of the hash table and sorted first, using the C functions as new can't be used here
 void PrintAllocations( const char* tagText )
 {
     int bytes = 0;
@@ -1341,28 +1927,38 @@ void PrintAllocations( const char* tagText )
     DebugOutput("**************************************************\n");
     DebugOutput("MEMORY ALLOCATED\n");
     DebugOutput("**************************************************\n");
-    for (ALLOC a : g_vAllocations)
+
+    ALLOC* sorted = static_cast<ALLOC*>( malloc( sizeof( ALLOC ) * ( g_vAllocCount + 1 ) ) );
+    PB_ASSERT( sorted );
+    unsigned int count = 0;
+    for( unsigned int n = 0; n < g_vAllocTableSize; n++ )
     {
-        if (a.address != nullptr)
-        {
-            char* lastSlash = strrchr(a.file, '\\' );
-            if (lastSlash)
-            {
-                strcpy_s(buffer, lastSlash+1);
-                strcpy_s(a.file, buffer);
-            }
-            // Format in such a way that VS can double click to jump to the allocation.
-            sprintf_s( buffer, "%s %s(%d): 0x%02X %d bytes\n", tagText, a.file, a.line, static_cast<int>( reinterpret_cast<long long>( a.address ) ), static_cast<int>( a.size ) );
-            DebugOutput(buffer);
-            bytes += static_cast<int>(a.size);
-       }
+        if( g_vAllocations[n].address != nullptr )
+            sorted[count++] = g_vAllocations[n];
     }
+    qsort( sorted, count, sizeof( ALLOC ), CompareAllocSequence );
+
+    for( unsigned int n = 0; n < count; n++ )
+    {
+        const ALLOC& a = sorted[n];
+        const CALLSITE& c = g_vCallSites[a.callSite];
+        const char* lastSlash = strrchr( c.file, '\\' );
+        const char* file = lastSlash ? lastSlash + 1 : c.file;
+        // Format in such a way that VS can double click to jump to the allocation.
+        sprintf_s( buffer, "%s %s(%d): 0x%02X %d bytes\n", tagText, file, c.line, static_cast<int>( reinterpret_cast<long long>( a.address ) ), static_cast<int>( a.size ) );
+        DebugOutput(buffer);
+        bytes += static_cast<int>(a.size);
+    }
+    free( sorted );
+
     sprintf_s( buffer, "%s Total = %d bytes\n", tagText, bytes );
     DebugOutput(buffer);
     DebugOutput("**************************************************\n");
 
 }
 
+#endif // PLAY_MEMORY_TRACKING
+
 
 
 //*******************************************************************
@@ -1682,6 +2278,10 @@ void PlayBuffer::ClearBuffer( Pixel colour )
 {
 	uint32_t* pBuffEnd = m_pDisplayBuffer + ( m_width * m_height );
 	for( uint32_t* pBuff = m_pDisplayBuffer; pBuff < pBuffEnd; *pBuff++ = colour.bits );
+
+	// None of the background is left, so the blitter has to copy all of it back
+	if( PlayBlitter::HasInstance() && PlayBlitter::Instance().GetDisplayBuffer() == m_pDisplayBuffer )
+		PlayBlitter::Instance().RestoreAllBackground();
 }
 
 void PlayBuffer::DrawPixel( Point2f pos, Pixel srcPix )
@@ -1691,6 +2291,15 @@ void PlayBuffer::DrawPixel( Point2f pos, Pixel srcPix )
 }
 
 void PlayBuffer::DrawPixel( int posX, int posY, Pixel srcPix )
+{
+	if( srcPix.a == 0x00 )
+		return;
+
+	MarkDirty( posX, posY, posX + 1, posY + 1 );
+	BlendPixel( posX, posY, srcPix );
+}
+
+void PlayBuffer::BlendPixel( int posX, int posY, Pixel srcPix )
 {
 	if( srcPix.a == 0x00 || posX < 0 || posX >= m_width || posY < 0 || posY >= m_height )
 		return;
@@ -1718,6 +2327,13 @@ void PlayBuffer::DrawPixel( int posX, int posY, Pixel srcPix )
 	return;
 }
 
+void PlayBuffer::MarkDirty( int left, int top, int right, int bottom ) const
+{
+	// The blitter ignores this unless SetDirtyRects is on
+	if( PlayBlitter::HasInstance() && PlayBlitter::Instance().GetDisplayBuffer() == m_pDisplayBuffer )
+		PlayBlitter::Instance().AddDirtyRect( { left, top }, { right - 1, bottom - 1 } );
+}
+
 void PlayBuffer::DrawLine( Point2f startPos, Point2f endPos, Pixel pix )
 {
 	// Convert floating point co-ordinates to pixels
@@ -1779,10 +2395,11 @@ void PlayBuffer::DrawRect( Point2f topLeft, Point2f bottomRight, Pixel pix, bool
 
 	if( fill )
 	{
+		MarkDirty( x1, y1, x2, y2 );
 		for( int x = x1; x < x2; x++ )
 		{
 			for( int y = y1; y < y2; y++ )
-				DrawPixel( x, y , pix );
+				BlendPixel( x, y , pix );
 		}
 	}
 	else
@@ -1897,13 +2514,17 @@ int PlayBuffer::DrawDebugCharacter( Point2f pos, char c, Pixel pix )
 	int sourceX = ( ( c - 0x30 ) % 16 ) * FONT_CHAR_WIDTH;
 	int sourceY = ( ( c - 0x30 ) / 16 ) * FONT_CHAR_HEIGHT;
 
+	// The glyph's pixels are rounded one at a time, as DrawPixel rounds them
+	MarkDirty( static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ),
+		static_cast<int>( pos.x + FONT_CHAR_WIDTH - 0.5f ) + 1, static_cast<int>( pos.y + FONT_CHAR_HEIGHT - 0.5f ) + 1 );
+
 	// Loop over the bounding box of the glyph
 	for( int x = 0; x < FONT_CHAR_WIDTH; x++ )
 	{
 		for( int y = 0; y < FONT_CHAR_HEIGHT; y++ )
 		{
 			if( m_pDebugFontBuffer[( ( sourceY + y ) * FONT_IMAGE_WIDTH ) + ( sourceX + x )] > 0 )
-				DrawPixel( { pos.x + x, pos.y + y }, pix );
+				BlendPixel( static_cast<int>( pos.x + x + 0.5f ), static_cast<int>( pos.y + y + 0.5f ), pix );
 		}
 	}
 
@@ -2142,7 +2763,14 @@ void TracePrintf( const char* file, int line, const char* fmt, ... )
 //********************************************************************************************************************************
 
 
-
+// The AVX2 kernels are only called once the CPU has been checked for AVX2 support
+// > MSVC allows any intrinsics in any function, but GCC and Clang have to be told which functions may use them
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PLAY_TARGET_AVX2
+#else
+#define PLAY_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
 
 PlayBlitter* PlayBlitter::s_pInstance = nullptr;
 
@@ -2172,7 +2800,13 @@ PlayBlitter::PlayBlitter( const char* path )
 			{
 				int spriteId = LoadSpriteSheet( p.path().parent_path().string() + "\\", p.path().stem().string() );
 
-				// Now we check for .inf file for each sprite and load origins
+				// Now we check for .inf file for each sprite and load origins (and collision shapes)
+				// > The file starts with a keyword (normally ORIGIN) followed by the origin x and y
+				// > A collision shape can follow, in pixels from the top left of a frame:
+				//     CIRCLE x y radius
+				//     CAPSULE x1 y1 x2 y2 radius
+				//     HULL count x1 y1 x2 y2 ... (a convex polygon of 3 to MAX_HULL_POINTS points in order)
+				// > Sprites without a collision shape use their frame's bounding box
 				int originX = 0, originY = 0;
 
 				std::string info_filename = filename.replace( filename.find( ".PNG" ), 4, ".INF" );
@@ -2189,6 +2823,7 @@ PlayBlitter::PlayBlitter( const char* path )
 						info_infile >> type;
 						info_infile >> originX;
 						info_infile >> originY;
+						LoadCollisionShape( spriteId, info_infile );
 					}
 
 					info_infile.close();
@@ -2204,13 +2839,15 @@ PlayBlitter::PlayBlitter( const char* path )
 
 PlayBlitter::~PlayBlitter()
 {
+	StopDrawWorkers();
+
 	for( Sprite& s : vSpriteData )
 	{
 		if( s.pCanvasBuffer )
 			delete[] s.pCanvasBuffer;
 
-		if( s.pPreMultAlpha )
-			delete[] s.pPreMultAlpha;
+		if( s.pPreMultBuffer )
+			delete[] s.pPreMultBuffer;
 	}
 
 	for( uint32_t*& pBgBuffer : vBackgroundData )
@@ -2314,12 +2951,24 @@ int PlayBlitter::LoadSpriteSheet( const std::string& path, const std::string& fi
 	s.width = s.canvasWidth / s.hCount;
 	s.height = s.canvasHeight / s.vCount;
 
-	// Create a separate buffer with the pre-multiplyied alpha
-	s.pPreMultAlpha = new uint32_t[static_cast<size_t>( s.canvasWidth ) * s.canvasHeight];
-	memset( s.pPreMultAlpha, 0, sizeof( uint32_t ) * s.canvasWidth * s.canvasHeight );
-	PreMultiplyAlpha( s.pCanvasBuffer, s.pPreMultAlpha, s.canvasWidth, s.canvasHeight, s.width, 1.0f, 0x00FFFFFF );
+	// Create a separate buffer with the pre-multiplyied alpha, with the padding at the end of each row left transparent
+	s.frameStride = ( s.width + FRAME_ROW_ALIGN - 1 ) & ~( FRAME_ROW_ALIGN - 1 );
+	const size_t preMultSize = static_cast<size_t>( s.frameStride ) * s.height * s.totalCount;
+	size_t preMultSpace = sizeof( uint32_t ) * ( preMultSize + FRAME_ROW_ALIGN - 1 );
+	s.pPreMultBuffer = new uint32_t[preMultSize + FRAME_ROW_ALIGN - 1];
+	void* pPreMultAligned = s.pPreMultBuffer;
+	s.pPreMultAlpha = static_cast<uint32_t*>( std::align( sizeof( uint32_t ) * FRAME_ROW_ALIGN, sizeof( uint32_t ) * preMultSize, pPreMultAligned, preMultSpace ) );
+	std::fill( s.pPreMultAlpha, s.pPreMultAlpha + preMultSize, 0xFF000000 );
+	PreMultiplyAlpha( s, 1.0f, 0x00FFFFFF );
+
+	BuildCollisionMask( s );
+	BuildPixelSpans( s );
+	m_vCollisionShapes.push_back( CollisionShape() );
 
 	// Add the sprite to our vector
+	const uint64_t nameHash = HashSpriteName( s.name.c_str() );
+	PB_ASSERT_MSG( m_spriteIds.count( nameHash ) == 0, std::string( "Two sprites with the same name hash: " + s.name ).c_str() );
+	m_spriteIds[nameHash] = s.id;
 	vSpriteData.push_back( s );
 
 	return s.id;
@@ -2365,7 +3014,13 @@ int PlayBlitter::LoadBackground( const char* fileAndPath )
 //********************************************************************************************************************************
 // Sprite Getters and Setters
 //********************************************************************************************************************************
-int PlayBlitter::GetSpriteId( const char* name ) const
+int PlayBlitter::GetSpriteId( SpriteHandle sprite ) const
+{
+	auto it = m_spriteIds.find( sprite.hash );
+	return it == m_spriteIds.end() ? -1 : it->second;
+}
+
+int PlayBlitter::FindSpriteId( const char* name ) const
 {
 	std::string tofind( name );
 	for( char& c : tofind ) c = static_cast<char>( toupper( c ) );
@@ -2458,19 +3113,168 @@ void PlayBlitter::SetSpriteOrigins( const char* rootName, Vector2f newOrigin, bo
 void PlayBlitter::DrawBackground( int backgroundId )
 {
 	PB_ASSERT_MSG( m_displayBuffer, "Trying to draw background without initialising display!" );
+	PB_ASSERT_MSG( !m_batching, "Trying to draw background during a batch!" );
 	PB_ASSERT_MSG( static_cast<int>(vBackgroundData.size()) > backgroundId, "Background image out of range!" );
+
+	// Everything drawn since the last call is on top of the same background, so only the dirty cells need copying back
+	if( m_dirtyRects && !m_restoreAll && backgroundId == m_lastBackground && RestoreDirtyCells( vBackgroundData[backgroundId] ) )
+		return;
+
 	// Takes about 1ms for 720p screen on i7-8550U
 	memcpy( m_displayBuffer, vBackgroundData[backgroundId], sizeof( uint32_t ) * m_displayBufferWidth * m_displayBufferHeight );
+
+	m_restoreStats.rects = 1;
+	m_restoreStats.bytes = sizeof( uint32_t ) * m_displayBufferWidth * m_displayBufferHeight;
+	m_restoreStats.fullCopy = true;
+	m_lastBackground = backgroundId;
+	m_restoreAll = false;
+	std::fill( m_vDirtyCells.begin(), m_vDirtyCells.end(), static_cast<uint8_t>( 0 ) );
+}
+
+//********************************************************************************************************************************
+// Function:	SetDirtyRects - turns copying back only the dirty parts of the background on or off
+// Parameters:	enable = true to only copy back the dirty cells
+//				fullCopyCoverage = the share of the cells (0 to 1) which can be dirty before the whole background is copied
+//********************************************************************************************************************************
+void PlayBlitter::SetDirtyRects( bool enable, float fullCopyCoverage )
+{
+	PB_ASSERT_MSG( !m_batching, "Trying to change dirty rectangles during a batch!" );
+	m_dirtyRects = enable;
+	m_fullCopyCoverage = fullCopyCoverage;
+	m_dirtyColumns = ( m_displayBufferWidth + DIRTY_CELL_SIZE - 1 ) / DIRTY_CELL_SIZE;
+	m_dirtyRows = ( m_displayBufferHeight + DIRTY_CELL_SIZE - 1 ) / DIRTY_CELL_SIZE;
+	m_vDirtyCells.assign( enable ? static_cast<size_t>( m_dirtyColumns ) * m_dirtyRows : 0, 0 );
+	// Nothing was marked while it was off
+	m_restoreAll = true;
+}
+
+//********************************************************************************************************************************
+// Function:	AddDirtyRect - marks part of the display buffer as drawn over
+// Parameters:	topLeft, bottomRight = the corners of the area (the bottom right pixel is included)
+//********************************************************************************************************************************
+void PlayBlitter::AddDirtyRect( Point2f topLeft, Point2f bottomRight )
+{
+	MarkDirty( { static_cast<int>( floor( topLeft.x ) ), static_cast<int>( floor( topLeft.y ) ), static_cast<int>( floor( bottomRight.x ) ) + 1, static_cast<int>( floor( bottomRight.y ) ) + 1 } );
+}
+
+//********************************************************************************************************************************
+// Function:	MarkDirty - marks the cells a rectangle touches as dirty
+// Parameters:	rect = the rectangle, which doesn't have to be on the display buffer
+//********************************************************************************************************************************
+void PlayBlitter::MarkDirty( const ClipRect& rect ) const
+{
+	if( !m_dirtyRects )
+		return;
+
+	// The display buffer can grow after SetDirtyRects, and then DrawBackground copies all of it
+	if( m_dirtyColumns * DIRTY_CELL_SIZE < m_displayBufferWidth || m_dirtyRows * DIRTY_CELL_SIZE < m_displayBufferHeight )
+		return;
+
+	int left = std::max( rect.left, 0 );
+	int top = std::max( rect.top, 0 );
+	int right = std::min( rect.right, m_displayBufferWidth );
+	int bottom = std::min( rect.bottom, m_displayBufferHeight );
+	if( left >= right || top >= bottom )
+		return;
+
+	const int firstColumn = left / DIRTY_CELL_SIZE;
+	const int lastColumn = ( right - 1 ) / DIRTY_CELL_SIZE;
+	for( int row = top / DIRTY_CELL_SIZE; row <= ( bottom - 1 ) / DIRTY_CELL_SIZE; row++ )
+		memset( &m_vDirtyCells[ static_cast<size_t>( row ) * m_dirtyColumns + firstColumn ], 1, lastColumn - firstColumn + 1 );
+}
+
+//********************************************************************************************************************************
+// Function:	RestoreDirtyCells - copies the dirty cells back from the background
+// Parameters:	pBackground = the background the display buffer was last cleared to
+// Notes:		Each row of cells is split into runs of dirty cells, and a run which lines up exactly with one in the row above 
+//				extends its rectangle downwards, so the rectangles don't overlap and each copy is as wide as it can be
+//				Returns false (having copied nothing) if more than m_fullCopyCoverage of the cells are dirty, or the display 
+//				buffer has changed size since SetDirtyRects
+//********************************************************************************************************************************
+bool PlayBlitter::RestoreDirtyCells( const uint32_t* pBackground )
+{
+	if( m_dirtyColumns * DIRTY_CELL_SIZE < m_displayBufferWidth || m_dirtyRows * DIRTY_CELL_SIZE < m_displayBufferHeight )
+		return false;
+
+	const size_t dirtyCount = std::count( m_vDirtyCells.begin(), m_vDirtyCells.end(), static_cast<uint8_t>( 1 ) );
+	if( dirtyCount > m_fullCopyCoverage * m_vDirtyCells.size() )
+		return false;
+
+	m_vRestoreRects.clear();
+	m_vOpenRects.clear();
+	for( int row = 0; row < m_dirtyRows; row++ )
+	{
+		const uint8_t* pCells = &m_vDirtyCells[ static_cast<size_t>( row ) * m_dirtyColumns ];
+		// The open rectangles are in order from left to right, as are the runs, so they can be matched up as they're found
+		size_t open = 0;
+		size_t stillOpen = 0;
+		for( int column = 0; column < m_dirtyColumns; column++ )
+		{
+			if( !pCells[column] )
+				continue;
+
+			const int runStart = column;
+			while( column < m_dirtyColumns && pCells[column] )
+				column++;
+
+			while( open < m_vOpenRects.size() && m_vRestoreRects[m_vOpenRects[open]].left < runStart )
+				open++;
+
+			if( open < m_vOpenRects.size() && m_vRestoreRects[m_vOpenRects[open]].left == runStart && m_vRestoreRects[m_vOpenRects[open]].right == column )
+			{
+				m_vRestoreRects[m_vOpenRects[open]].bottom = row + 1;
+				m_vOpenRects[stillOpen++] = m_vOpenRects[open++];
+			}
+			else
+			{
+				// Rectangles which didn't carry on are closed by now, so the new one can take a slot behind those still open
+				m_vRestoreRects.push_back( { runStart, row, column, row + 1 } );
+				if( stillOpen < open )
+				{
+					m_vOpenRects[stillOpen++] = static_cast<int>( m_vRestoreRects.size() ) - 1;
+				}
+				else
+				{
+					m_vOpenRects.insert( m_vOpenRects.begin() + stillOpen++, static_cast<int>( m_vRestoreRects.size() ) - 1 );
+					open++;
+				}
+			}
+		}
+		m_vOpenRects.resize( stillOpen );
+	}
+
+	size_t bytes = 0;
+	for( const ClipRect& cells : m_vRestoreRects )
+	{
+		const int left = cells.left * DIRTY_CELL_SIZE;
+		const int right = std::min( cells.right * DIRTY_CELL_SIZE, m_displayBufferWidth );
+		const int bottom = std::min( cells.bottom * DIRTY_CELL_SIZE, m_displayBufferHeight );
+		const size_t rowBytes = sizeof( uint32_t ) * ( right - left );
+		for( int y = cells.top * DIRTY_CELL_SIZE; y < bottom; y++ )
+		{
+			const size_t offset = static_cast<size_t>( y ) * m_displayBufferWidth + left;
+			memcpy( m_displayBuffer + offset, pBackground + offset, rowBytes );
+		}
+		bytes += rowBytes * ( bottom - cells.top * DIRTY_CELL_SIZE );
+	}
+
+	m_restoreStats.rects = static_cast<int>( m_vRestoreRects.size() );
+	m_restoreStats.bytes = bytes;
+	m_restoreStats.fullCopy = false;
+	std::fill( m_vDirtyCells.begin(), m_vDirtyCells.end(), static_cast<uint8_t>( 0 ) );
+	return true;
 }
 
 void PlayBlitter::ColourSprite( int spriteId, int r, int g, int b )
 {
 	PB_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to colour invalid sprite id" );
+	PB_ASSERT_MSG( !m_batching, "Trying to colour a sprite during a batch!" );
 
 	Sprite& s = vSpriteData[spriteId];
 	uint32_t col = ( ( r & 0xFF ) << 16 ) | ( ( g & 0xFF ) << 8 ) | ( b & 0xFF );
 
-	PreMultiplyAlpha( s.pCanvasBuffer, s.pPreMultAlpha, s.canvasWidth, s.canvasHeight, s.width, 1.0f, col );
+	PreMultiplyAlpha( s, 1.0f, col );
+	ForgetRotatedFrames( spriteId );
 }
 
 int PlayBlitter::DrawString( int fontId, Point2f pos, std::string text ) const
@@ -2503,14 +3307,14 @@ int PlayBlitter::DrawStringCentred( int fontId, Point2f pos, std::string text )
 int PlayBlitter::DrawChar( int fontId, Point2f pos, char c ) const
 {
 	PB_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
-	BlitSprite( fontId, static_cast<int>( pos.x ), static_cast<int>( pos.y ), c - 32 );
+	BlitSprite( fontId, static_cast<int>( pos.x ), static_cast<int>( pos.y ), c - 32, {} );
 	return GetFontCharWidth( fontId, c );
 }
 
 int PlayBlitter::DrawCharRotated( int fontId, Point2f pos, float angle, float scale, char c ) const
 {
 	PB_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
-	RotateScaleSprite( fontId, static_cast<int>( pos.x ), static_cast<int>( pos.y ), c - 32, angle, scale );
+	RotateScaleSprite( fontId, static_cast<int>( pos.x ), static_cast<int>( pos.y ), c - 32, angle, scale, {} );
 	return GetFontCharWidth( fontId, c );
 }
 
@@ -2590,7 +3394,6 @@ bool PlayBlitter::SpriteCollide( int id_1, Point2f pos_1, int frame_1, float ang
 
 	int s2Width = s2.width;
 	int s2Height = s2.height;
-	int s1Width = s1.width;
 
 	float cosAngleDiff = cos( angle_2 - angle_1 );
 	float sinAngleDiff = sin( angle_2 - angle_1 );
@@ -2669,14 +3472,13 @@ bool PlayBlitter::SpriteCollide( int id_1, Point2f pos_1, int frame_1, float ang
 
 		//Set up starting and finishing pointers for both the sprite 1 buffer and sprite 2 buffer 
 		//starting pointer for the sprite 1 buffer is the minu and minv.
-		int sprite1Offset = s1Width * frame_1 + iminu + iminv * s1.canvasWidth;
-		uint32_t* sprite1Src = s1.pCanvasBuffer + sprite1Offset;
+		int sprite1Offset = iminu + iminv * s1.frameStride;
+		const uint32_t* sprite1Src = s1.FramePixels( frame_1 ) + sprite1Offset;
 
-		//The base pointer for the sprite2 will just be start of the correct frame in the canvas buffer.
-		int sprite2Offset = s2Width * frame_2;
-		uint32_t* sprite2Base = s2.pCanvasBuffer + sprite2Offset;
+		//The base pointer for the sprite2 will just be start of the correct frame in the pre-multiplied buffer.
+		const uint32_t* sprite2Base = s2.FramePixels( frame_2 );
 		//Define the number which we need to add to get down a row in sprite1.
-		int sprite1ChangeRow = s1.canvasWidth - ( imaxu - iminu );
+		int sprite1ChangeRow = s1.frameStride - ( imaxu - iminu );
 
 
 		//Start of double for loop.
@@ -2695,11 +3497,11 @@ bool PlayBlitter::SpriteCollide( int id_1, Point2f pos_1, int frame_1, float ang
 				//If we are in sprite 2 then extract the look at the pixels.
 				if( a >= s2PixelCollTL[0] && b >= s2PixelCollTL[1] && a < s2PixelCollTL[2] && b < s2PixelCollTL[3] )
 				{
-					int sprite2Pixel = static_cast<int>( a ) + static_cast<int>( b ) * s2.canvasWidth;
+					int sprite2Pixel = static_cast<int>( a ) + static_cast<int>( b ) * s2.frameStride;
 					uint32_t sprite2Src = *( sprite2Base + sprite2Pixel );
 
-					//If both pixels at that position are opaque then there is a collision. 
-					if( sprite2Src > 0x00FFFFFF && *sprite1Src > 0x00FFFFFF )
+					//If both pixels at that position aren't fully transparent (see PreMultiplyAlpha) then there is a collision. 
+					if( sprite2Src < 0xFF000000 && *sprite1Src < 0xFF000000 )
 					{
 						return true;
 					}
@@ -2725,167 +3527,1316 @@ bool PlayBlitter::SpriteCollide( int id_1, Point2f pos_1, int frame_1, float ang
 
 
 //********************************************************************************************************************************
-// Function:	BlitSprite - draws a sprite with and withough a global alpha multiply
-// Parameters:	spriteId = the id of the sprite to draw
-//				xpos, ypos = the position you want to draw the sprite
-//				frameIndex = which frame of the animation to draw (wrapped)
-// Notes:		Alpha multiply approach is relatively unoptimized
+// Function:	BuildCollisionMask - creates a 1-bit mask for each frame of a sprite
+// Parameters:	s = the sprite, whose pre-multiplied pixels have already been made
+// Notes:		A pixel is set if it isn't fully transparent, which is the same test SpriteCollide uses
 //********************************************************************************************************************************
-void PlayBlitter::BlitSprite( int spriteId, int xpos, int ypos, int frameIndex, float alphaMultiply ) const
+void PlayBlitter::BuildCollisionMask( Sprite& s )
 {
-	PB_ASSERT_MSG( m_displayBuffer, "DisplayBuffer not initialised" );
-	PB_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to draw invalid sprite id" );
-
-	const Sprite& spr = vSpriteData[spriteId];
-
-	// Nothing within the display buffer to draw
-	if( ( xpos - spr.originX ) > m_displayBufferWidth || ( xpos - spr.originX ) + spr.width < 0 || ( ypos - spr.originY ) > m_displayBufferHeight || ( ypos - spr.originY ) + spr.width < 0 )
-		return;
-
-	// Work out if we need to clip to the display buffer (and by how much)
-	int xClipStart = -( xpos - spr.originX );
-	if( xClipStart < 0 ) { xClipStart = 0; }
-
-	int xClipEnd = ( ( xpos - spr.originX ) + spr.width ) - m_displayBufferWidth;
-	if( xClipEnd < 0 ) { xClipEnd = 0; }
-
-	int yClipStart = -( ypos - spr.originY );
-	if( yClipStart < 0 ) { yClipStart = 0; }
-
-	int yClipEnd = ( ( ypos - spr.originY ) + spr.height ) - m_displayBufferHeight;
-	if( yClipEnd < 0 ) { yClipEnd = 0; }
-
-	// Set up the source and destination pointers based on clipping
-	int destOffset = ( m_displayBufferWidth * ( ( ypos - spr.originY ) + yClipStart ) ) + ( ( xpos - spr.originX ) + xClipStart );
-	uint32_t* destPixels = m_displayBuffer + destOffset;
+	s.maskWordsPerRow = ( s.width + 63 ) / 64;
+	s.vCollisionMask.assign( static_cast<size_t>( s.maskWordsPerRow ) * s.height * s.totalCount, 0 );
 
-	frameIndex = frameIndex % spr.totalCount;
-	int imageX = frameIndex % spr.hCount;
-	int imageY = frameIndex / spr.hCount;
-	int pixelX = imageX * spr.width;
-	int pixelY = imageY * spr.height;
-	int frameOffset = pixelX + ( spr.canvasWidth * pixelY );
+	uint64_t* pMask = s.vCollisionMask.data();
 
-	int srcOffset = ( spr.canvasWidth * yClipStart ) + xClipStart;
-	uint32_t* srcPixels = spr.pPreMultAlpha + frameOffset + srcOffset;
+	for( int frame = 0; frame < s.totalCount; frame++ )
+	{
+		for( int y = 0; y < s.height; y++ )
+		{
+			const uint32_t* pSrc = s.FramePixels( frame ) + static_cast<size_t>( s.frameStride ) * y;
 
-	// Work out in advance how much we need to add to src and dest to reach the next row 
-	int destInc = m_displayBufferWidth - spr.width + xClipEnd + xClipStart;
-	int srcInc = spr.canvasWidth - spr.width + xClipEnd + xClipStart;
+			for( int x = 0; x < s.width; x++ )
+			{
+				if( pSrc[x] < 0xFF000000 )
+					pMask[x >> 6] |= 1ull << ( x & 63 );
+			}
 
-	//Work out final pixel in destination.
-	int destColOffset = ( m_displayBufferWidth * ( spr.height - yClipEnd - yClipStart - 1 ) ) + ( spr.width - xClipEnd - xClipStart );
-	uint32_t* destColEnd = destPixels + destColOffset;
+			pMask += s.maskWordsPerRow;
+		}
+	}
+}
 
-	//How many pixels per row in sprite.
-	int endRow = spr.width - xClipEnd - xClipStart;
+//********************************************************************************************************************************
+// Function:	BuildPixelSpans - splits each row of a sprite into spans, and finds which part of each frame isn't fully transparent
+// Parameters:	s = the sprite, whose pre-multiplied pixels have already been made
+// Notes:		The pixels in spans are the ones in the collision mask (see BuildCollisionMask), apart from padding. Colouring the 
+//				sprite doesn't change which pixels are transparent, or which can be copied, so the spans are only worked out once.
+//********************************************************************************************************************************
+void PlayBlitter::BuildPixelSpans( Sprite& s )
+{
+	PB_ASSERT_MSG( s.width <= 0xFFFF, "Sprite frame too wide for its spans!" );
+	s.vRowSpanStarts.clear();
+	s.vRowSpanStarts.reserve( static_cast<size_t>( s.height ) * s.totalCount + 1 );
+	s.vSpans.clear();
+	s.vOpaqueBoxes.assign( s.totalCount, OpaqueBox() );
 
-	if( alphaMultiply < 1.0f )
+	for( int frame = 0; frame < s.totalCount; frame++ )
 	{
-		// *******************************************************************************************************************************************************
-		// A basic (unoptimized) approach which separates the channels and performs a 'typical' alpha blending operation: (src * srcAlpha)+(dest * (1-srcAlpha))
-		// Has the advantage that a global alpha multiplication can be easily added over the top, so we use this method when a global multiply is required
-		// *******************************************************************************************************************************************************
+		OpaqueBox box{ s.width, s.height, 0, 0 };
 
-		// Slightly more optimised iterations without the additions in the loop
-		while( destPixels < destColEnd )
+		for( int y = 0; y < s.height; y++ )
 		{
-			uint32_t* destRowEnd = destPixels + endRow;
+			const uint32_t* pRow = s.FramePixels( frame ) + static_cast<size_t>( s.frameStride ) * y;
+			const size_t rowStart = s.vSpans.size();
+			s.vRowSpanStarts.push_back( static_cast<uint32_t>( rowStart ) );
+			EncodeSpans( pRow, s.width, s.vSpans );
 
-			while( destPixels < destRowEnd )
+			if( s.vSpans.size() > rowStart )
 			{
-				uint32_t src = *srcPixels++;
-				uint32_t dest = *destPixels;
+				// The last span can be padded with transparent pixels
+				int right = s.vSpans.back().right;
+				while( pRow[right - 1] >= 0xFF000000 )
+					right--;
+
+				box.left = std::min<int>( box.left, s.vSpans[rowStart].left );
+				box.right = std::max( box.right, right );
+				box.top = std::min( box.top, y );
+				box.bottom = y + 1;
+			}
+		}
 
-				// If this isn't a fully transparent pixel 
-				if( src < 0xFF000000 )
-				{
-					int srcAlpha = static_cast<int>( ( 0xFF - ( src >> 24 ) ) * alphaMultiply );
-					int constAlpha = static_cast<int>( 255 * alphaMultiply );
+		if( box.bottom > 0 )
+			s.vOpaqueBoxes[frame] = box;
+	}
 
-					// Source pixels are already multiplied by srcAlpha so we just apply the constant alpha multiplier
-					int destRed = constAlpha * ( ( src >> 16 ) & 0xFF );
-					int destGreen = constAlpha * ( ( src >> 8 ) & 0xFF );
-					int destBlue = constAlpha * ( src & 0xFF );
+	s.vRowSpanStarts.push_back( static_cast<uint32_t>( s.vSpans.size() ) );
+}
 
-					int invSrcAlpha = 0xFF - srcAlpha;
+//********************************************************************************************************************************
+// Function:	EncodeSpans - splits a row of pre-multiplied pixels into spans
+// Parameters:	pPixels = the first pixel in the row
+//				width = the number of pixels in the row
+//				vSpans = the vector to add the spans to, left to right
+// Notes:		Runs of fewer than MIN_SKIP_SPAN transparent pixels are left in blend spans (the blend kernels skip them), and 
+//				runs of fewer than MIN_COPY_SPAN opaque pixels are blended, as starting a new span would cost more than it saves.
+//				A row with nothing to copy is left as one blend span.
+//********************************************************************************************************************************
+void PlayBlitter::EncodeSpans( const uint32_t* pPixels, int width, std::vector< PixelSpan >& vSpans )
+{
+	const size_t rowStart = vSpans.size();
+	bool anyCopy = false;
 
-					// Apply a standard Alpha blend [ src*srcAlpha + dest*(1-SrcAlpha) ]
-					destRed += invSrcAlpha * ( ( dest >> 16 ) & 0xFF );
-					destGreen += invSrcAlpha * ( ( dest >> 8 ) & 0xFF );
-					destBlue += invSrcAlpha * ( dest & 0xFF );
+	int x = 0;
+	while( x < width )
+	{
+		if( pPixels[x] >= 0xFF000000 )
+		{
+			x++;
+			continue;
+		}
+		const size_t firstSpan = vSpans.size();
 
-					// Bring back to the range 0-255
-					destRed >>= 8;
-					destGreen >>= 8;
-					destBlue >>= 8;
+		// The span carries on to the next long enough run of transparent pixels, or the last pixel which isn't transparent
+		int end = x;
+		while( end < width )
+		{
+			if( pPixels[end] < 0xFF000000 )
+			{
+				end++;
+				continue;
+			}
 
-					// Put ARGB components back together again
-					*destPixels++ = 0xFF000000 | ( destRed << 16 ) | ( destGreen << 8 ) | destBlue;
-				}
-				else
-				{
-					// If this is a fully transparent pixel then the low bits store how many there are in a row
-					// This means we can skip to the next pixel which isn't fully transparent
-					uint32_t skip = std::min( src & 0x00FFFFFF, (uint32_t)( destRowEnd - destPixels - 1 ) );
-					srcPixels += skip;
-					++destPixels += skip;
-				}
+			int gapEnd = end;
+			while( gapEnd < width && pPixels[gapEnd] >= 0xFF000000 )
+				gapEnd++;
+			if( gapEnd == width || gapEnd - end >= MIN_SKIP_SPAN )
+				break;
+			end = gapEnd;
+		}
+
+		// Long enough runs of pixels which BlendRow would copy (as their inverse alpha is below 16) become copy spans
+		int blendStart = x;
+		for( int n = x; n < end; )
+		{
+			if( pPixels[n] >= 0x10000000 )
+			{
+				n++;
+				continue;
+			}
+
+			int copyEnd = n;
+			while( copyEnd < end && pPixels[copyEnd] < 0x10000000 )
+				copyEnd++;
+
+			if( copyEnd - n >= MIN_COPY_SPAN )
+			{
+				if( blendStart < n )
+					vSpans.push_back( { static_cast<uint16_t>( blendStart ), static_cast<uint16_t>( n ), false } );
+				vSpans.push_back( { static_cast<uint16_t>( n ), static_cast<uint16_t>( copyEnd ), true } );
+				blendStart = copyEnd;
+				anyCopy = true;
+			}
+			n = copyEnd;
+		}
+
+		if( blendStart < end )
+			vSpans.push_back( { static_cast<uint16_t>( blendStart ), static_cast<uint16_t>( end ), false } );
+
+		// Blend spans are padded out to whole groups of SPAN_GROUP pixels where they can be, with pixels from a copy span next 
+		// to them or the transparent pixels after them (which blend the same way), so the kernels don't finish a span a pixel 
+		// at a time. The last span is followed by at least MIN_SKIP_SPAN transparent pixels, unless the row ends first.
+		for( size_t n = firstSpan; n < vSpans.size(); n++ )
+		{
+			PixelSpan& span = vSpans[n];
+			const int pad = ( SPAN_GROUP - ( span.right - span.left ) % SPAN_GROUP ) % SPAN_GROUP;
+			if( span.copy || pad == 0 )
+				continue;
+
+			if( n + 1 < vSpans.size() && vSpans[n + 1].right - vSpans[n + 1].left - pad >= MIN_COPY_SPAN )
+			{
+				span.right += pad;
+				vSpans[n + 1].left += pad;
+			}
+			else if( n > firstSpan && vSpans[n - 1].right - vSpans[n - 1].left - pad >= MIN_COPY_SPAN )
+			{
+				span.left -= pad;
+				vSpans[n - 1].right -= pad;
 			}
-			// Increase buffers by pre-calculated amounts
-			destPixels += destInc;
-			srcPixels += srcInc;
+			else if( n + 1 == vSpans.size() && span.right + pad <= width )
+			{
+				span.right += pad;
+			}
+		}
+
+		x = end;
+	}
+
+	// Without a copy span, blending the row in one go costs less than skipping its gaps (the kernels skip them anyway)
+	if( !anyCopy && vSpans.size() > rowStart + 1 )
+	{
+		vSpans[rowStart].right = vSpans.back().right;
+		vSpans.resize( rowStart + 1 );
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	GetRotatedMask - gets a sprite frame's collision mask rotated around the sprite origin
+// Parameters:	spriteId = the id of the sprite
+//				frameIndex = which frame of the animation (wrapped)
+//				angleStep = the angle in steps of 2*PI / MASK_ANGLE_STEPS, clockwise
+// Notes:		Each pixel of the rotated mask samples the unrotated mask at its centre, so angle step zero is an exact copy
+//				A new mask may free older ones to stay in the budget, but never the mask used just before it
+//********************************************************************************************************************************
+const PlayBlitter::RotatedMask& PlayBlitter::GetRotatedMask( int spriteId, int frameIndex, int angleStep ) const
+{
+	const Sprite& spr = vSpriteData[spriteId];
+	frameIndex = frameIndex % spr.totalCount;
+
+	uint64_t key = ( static_cast<uint64_t>( spriteId ) << 32 ) | ( static_cast<uint64_t>( frameIndex ) << 16 ) | static_cast<uint64_t>( angleStep );
+	auto it = m_rotatedMasks.find( key );
+
+	if( it != m_rotatedMasks.end() )
+	{
+		m_maskLru.splice( m_maskLru.begin(), m_maskLru, it->second.lru );
+		if( it->second.originX == spr.originX && it->second.originY == spr.originY )
+		{
+			m_maskStats.hits++;
+			return it->second;
+		}
+	}
+	else
+	{
+		m_maskLru.push_front( key );
+		it = m_rotatedMasks.emplace( key, RotatedMask() ).first;
+		it->second.lru = m_maskLru.begin();
+	}
+
+	m_maskStats.misses++;
+	RotatedMask& mask = it->second;
+
+	float angle = angleStep * ( 2.0f * PLAY_PI / MASK_ANGLE_STEPS );
+	float cosAngle = cos( angle );
+	float sinAngle = sin( angle );
+
+	// The bounding box of the rotated frame relative to the origin
+	float cornersU[4] = { static_cast<float>( -spr.originX ), static_cast<float>( spr.width - spr.originX ), static_cast<float>( spr.width - spr.originX ), static_cast<float>( -spr.originX ) };
+	float cornersV[4] = { static_cast<float>( -spr.originY ), static_cast<float>( -spr.originY ), static_cast<float>( spr.height - spr.originY ), static_cast<float>( spr.height - spr.originY ) };
+
+	float minX = std::numeric_limits<float>::infinity();
+	float minY = std::numeric_limits<float>::infinity();
+	float maxX = -std::numeric_limits<float>::infinity();
+	float maxY = -std::numeric_limits<float>::infinity();
+
+	for( int i = 0; i < 4; i++ )
+	{
+		float x = cosAngle * cornersU[i] - sinAngle * cornersV[i];
+		float y = sinAngle * cornersU[i] + cosAngle * cornersV[i];
+		minX = std::min( minX, x );
+		maxX = std::max( maxX, x );
+		minY = std::min( minY, y );
+		maxY = std::max( maxY, y );
+	}
+
+	mask.originX = spr.originX;
+	mask.originY = spr.originY;
+	mask.left = static_cast<int>( floor( minX + 0.001f ) );
+	mask.top = static_cast<int>( floor( minY + 0.001f ) );
+	mask.width = std::max( 1, static_cast<int>( ceil( maxX - 0.001f ) ) - mask.left );
+	mask.height = std::max( 1, static_cast<int>( ceil( maxY - 0.001f ) ) - mask.top );
+	mask.wordsPerRow = ( mask.width + 63 ) / 64;
+	mask.bits.assign( static_cast<size_t>( mask.wordsPerRow ) * mask.height, 0 );
+
+	const uint64_t* pSrcMask = spr.vCollisionMask.data() + static_cast<size_t>( spr.maskWordsPerRow ) * spr.height * frameIndex;
+	uint64_t* pDstMask = mask.bits.data();
+
+	for( int row = 0; row < mask.height; row++ )
+	{
+		float y = mask.top + row + 0.5f;
+		float u = cosAngle * ( mask.left + 0.5f ) + sinAngle * y + spr.originX;
+		float v = -sinAngle * ( mask.left + 0.5f ) + cosAngle * y + spr.originY;
+
+		for( int column = 0; column < mask.width; column++ )
+		{
+			if( u >= 0 && v >= 0 && u < spr.width && v < spr.height )
+			{
+				int srcX = static_cast<int>( u );
+				int srcY = static_cast<int>( v );
+				if( pSrcMask[srcY * spr.maskWordsPerRow + ( srcX >> 6 )] & ( 1ull << ( srcX & 63 ) ) )
+					pDstMask[column >> 6] |= 1ull << ( column & 63 );
+			}
+
+			u += cosAngle;
+			v -= sinAngle;
+		}
+
+		pDstMask += mask.wordsPerRow;
+	}
+
+	m_maskStats.bytes -= mask.bytes;
+	mask.bytes = sizeof( RotatedMask ) + mask.bits.size() * sizeof( uint64_t );
+	m_maskStats.bytes += mask.bytes;
+	TrimMaskCache( m_maskBudget );
+	return mask;
+}
+
+//********************************************************************************************************************************
+// Function:	SetMaskCacheBudget - sets the most memory the rotated collision masks can use
+// Parameters:	budgetBytes = the budget in bytes
+//********************************************************************************************************************************
+void PlayBlitter::SetMaskCacheBudget( size_t budgetBytes )
+{
+	m_maskBudget = budgetBytes;
+	TrimMaskCache( m_maskBudget );
+}
+
+//********************************************************************************************************************************
+// Function:	ClearMaskCache - frees all the rotated collision masks
+//********************************************************************************************************************************
+void PlayBlitter::ClearMaskCache()
+{
+	m_rotatedMasks.clear();
+	m_maskLru.clear();
+	m_maskStats.bytes = 0;
+}
+
+//********************************************************************************************************************************
+// Function:	TrimMaskCache - frees the least recently used rotated masks until the cache uses no more than a limit
+// Parameters:	limit = the number of bytes the cache can keep using
+// Notes:		The two most recently used masks are kept whatever the limit, as SpriteMaskCollide holds on to both of them
+//********************************************************************************************************************************
+void PlayBlitter::TrimMaskCache( size_t limit ) const
+{
+	while( m_maskStats.bytes > limit && m_maskLru.size() > 2 )
+	{
+		auto it = m_rotatedMasks.find( m_maskLru.back() );
+		m_maskStats.bytes -= it->second.bytes;
+		m_maskStats.evictions++;
+		m_rotatedMasks.erase( it );
+		m_maskLru.pop_back();
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	SpriteMaskCollide - checks by pixel if two sprites collide, using their collision masks
+// Parameters:	s1Id, s2Id = the ids of both sprites
+//				s1Pos, s2Pos = where the sprite origins are drawn
+//				s1FrameIndex, s2FrameIndex = which frame of the animation for each sprite (wrapped)
+//				s1Angle, s2Angle = the angle of rotation for both sprites, clockwise. 0 = unrotated.
+// Returns:		true if a single pixel or more overlap between the two sprites and false if not.
+// Notes:		The rows of the mask further right are shifted into line with the other mask's words and ANDed with them
+//********************************************************************************************************************************
+bool PlayBlitter::SpriteMaskCollide( int s1Id, Point2f s1Pos, int s1FrameIndex, float s1Angle, int s2Id, Point2f s2Pos, int s2FrameIndex, float s2Angle ) const
+{
+	PB_ASSERT_MSG( s1Id >= 0 && s1Id < m_nTotalSprites && s2Id >= 0 && s2Id < m_nTotalSprites, "Trying to collide invalid sprite id" );
+
+	auto angleStep = []( float angle )
+	{
+		int step = static_cast<int>( floor( angle * ( MASK_ANGLE_STEPS / ( 2.0f * PLAY_PI ) ) + 0.5f ) ) % MASK_ANGLE_STEPS;
+		return step < 0 ? step + MASK_ANGLE_STEPS : step;
+	};
+
+	const RotatedMask* pMask1 = &GetRotatedMask( s1Id, s1FrameIndex, angleStep( s1Angle ) );
+	const RotatedMask* pMask2 = &GetRotatedMask( s2Id, s2FrameIndex, angleStep( s2Angle ) );
+
+	// Screen positions of the top left of each mask, rounded in the same way as the drawing functions
+	int left1 = static_cast<int>( s1Pos.x + 0.5f ) + pMask1->left;
+	int top1 = static_cast<int>( s1Pos.y + 0.5f ) + pMask1->top;
+	int left2 = static_cast<int>( s2Pos.x + 0.5f ) + pMask2->left;
+	int top2 = static_cast<int>( s2Pos.y + 0.5f ) + pMask2->top;
+
+	if( left2 < left1 )
+	{
+		std::swap( pMask1, pMask2 );
+		std::swap( left1, left2 );
+		std::swap( top1, top2 );
+	}
+
+	int shift = left2 - left1;
+	int startY = std::max( top1, top2 );
+	int endY = std::min( top1 + pMask1->height, top2 + pMask2->height );
+
+	if( shift >= pMask1->width || startY >= endY )
+		return false;
+
+	// Word i of mask 1 lines up with word i-wordShift of mask 2 shifted up by bitShift, plus the top bits of the word before it
+	int wordShift = shift >> 6;
+	int bitShift = shift & 63;
+	int endWord = std::min( pMask1->wordsPerRow, pMask2->wordsPerRow + wordShift + ( bitShift ? 1 : 0 ) );
+
+	for( int y = startY; y < endY; y++ )
+	{
+		const uint64_t* pRow1 = pMask1->bits.data() + static_cast<size_t>( y - top1 ) * pMask1->wordsPerRow;
+		const uint64_t* pRow2 = pMask2->bits.data() + static_cast<size_t>( y - top2 ) * pMask2->wordsPerRow;
+
+		for( int i = wordShift; i < endWord; i++ )
+		{
+			int j = i - wordShift;
+			uint64_t bits2 = j < pMask2->wordsPerRow ? pRow2[j] << bitShift : 0;
+			if( bitShift && j > 0 )
+				bits2 |= pRow2[j - 1] >> ( 64 - bitShift );
+
+			if( pRow1[i] & bits2 )
+				return true;
 		}
+	}
+
+	return false;
+}
 
+//********************************************************************************************************************************
+// Function:	LoadCollisionShape - reads a collision shape from the rest of a sprite's .INF file
+// Parameters:	spriteId = the id of the sprite
+//				info = the .INF file, just after the origin
+// Notes:		See the PlayBlitter constructor for the format. Any shape after the first is ignored
+//********************************************************************************************************************************
+void PlayBlitter::LoadCollisionShape( int spriteId, std::istream& info )
+{
+	std::string keyword;
+	if( !( info >> keyword ) )
+		return;
+
+	for( char& c : keyword ) c = static_cast<char>( toupper( c ) );
+
+	CollisionShape shape;
+	shape.firstPoint = static_cast<uint16_t>( m_vShapePoints.size() );
+	int pointCount = 0;
+
+	if( keyword == "CIRCLE" )
+	{
+		shape.type = CollisionShape::SHAPE_CIRCLE;
+		pointCount = 1;
+	}
+	else if( keyword == "CAPSULE" )
+	{
+		shape.type = CollisionShape::SHAPE_CAPSULE;
+		pointCount = 2;
+	}
+	else if( keyword == "HULL" )
+	{
+		shape.type = CollisionShape::SHAPE_HULL;
+		info >> pointCount;
+		PB_ASSERT_MSG( pointCount >= 3 && pointCount <= MAX_HULL_POINTS, std::string( "Collision hull has the wrong number of points: " + vSpriteData[spriteId].name ).c_str() );
+		pointCount = std::max( 0, std::min( pointCount, MAX_HULL_POINTS ) );
 	}
 	else
 	{
-		// *******************************************************************************************************************************************************
-		// An optimized approach which uses pre-multiplied alpha, parallel channel multiplication and pixel skipping to achieve the same 'typical' alpha 
-		// blending operation (src * srcAlpha)+(dest * (1-srcAlpha)). Not easy to apply a global alpha multiplication over the top, but used everywhere else.
-		// *******************************************************************************************************************************************************
+		PB_ASSERT_MSG( false, std::string( "Unknown collision shape in .inf file: " + vSpriteData[spriteId].name ).c_str() );
+		return;
+	}
+
+	for( int i = 0; i < pointCount; i++ )
+	{
+		Point2f point{ 0.0f, 0.0f };
+		info >> point.x >> point.y;
+		m_vShapePoints.push_back( point );
+	}
+
+	if( shape.type != CollisionShape::SHAPE_HULL )
+		info >> shape.radius;
+
+	PB_ASSERT_MSG( !info.fail(), std::string( "Badly formed collision shape in .inf file: " + vSpriteData[spriteId].name ).c_str() );
+	shape.pointCount = static_cast<uint8_t>( pointCount );
+	m_vCollisionShapes[spriteId] = shape;
+}
 
-		// Slightly more optimised iterations without the additions in the loop
-		while( destPixels < destColEnd )
+//********************************************************************************************************************************
+// Function:	GetShapePoints - gets a sprite's collision shape relative to its origin
+// Parameters:	spriteId = the id of the sprite
+//				pPoints = space for MAX_HULL_POINTS points
+//				radius = set to the distance the shape reaches out from its points
+// Returns:		The number of points
+//********************************************************************************************************************************
+int PlayBlitter::GetShapePoints( int spriteId, Point2f* pPoints, float& radius ) const
+{
+	const Sprite& spr = vSpriteData[spriteId];
+	const CollisionShape& shape = m_vCollisionShapes[spriteId];
+	Point2f origin{ spr.originX, spr.originY };
+
+	if( shape.type == CollisionShape::SHAPE_NONE )
+	{
+		pPoints[0] = Point2f( 0, 0 ) - origin;
+		pPoints[1] = Point2f( spr.width, 0 ) - origin;
+		pPoints[2] = Point2f( spr.width, spr.height ) - origin;
+		pPoints[3] = Point2f( 0, spr.height ) - origin;
+		radius = 0.0f;
+		return 4;
+	}
+
+	for( int i = 0; i < shape.pointCount; i++ )
+		pPoints[i] = m_vShapePoints[shape.firstPoint + i] - origin;
+
+	radius = shape.radius;
+	return shape.pointCount;
+}
+
+float PlayBlitter::GetSpriteShapeReach( int spriteId ) const
+{
+	PB_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to use invalid sprite id" );
+
+	Point2f points[MAX_HULL_POINTS];
+	float radius;
+	int count = GetShapePoints( spriteId, points, radius );
+
+	float reachSq = 0.0f;
+	for( int i = 0; i < count; i++ )
+		reachSq = std::max( reachSq, lengthSqr( points[i] ) );
+
+	return sqrt( reachSq ) + radius;
+}
+
+//********************************************************************************************************************************
+// Function:	SpriteShapeCollide - checks if the collision shapes of two sprites overlap
+// Parameters:	s1Id, s2Id = the ids of both sprites
+//				s1Pos, s2Pos = where the sprite origins are drawn
+//				s1Angle, s2Angle = the angle of rotation for both sprites, clockwise. 0 = unrotated.
+// Returns:		true if the shapes overlap
+// Notes:		Every shape is treated as a convex polygon (a point, line or hull) grown by its radius, so the shapes overlap
+//				if one polygon contains the other or the closest pair of edges are nearer than the radii added together
+//********************************************************************************************************************************
+bool PlayBlitter::SpriteShapeCollide( int s1Id, Point2f s1Pos, float s1Angle, int s2Id, Point2f s2Pos, float s2Angle ) const
+{
+	PB_ASSERT_MSG( s1Id >= 0 && s1Id < m_nTotalSprites && s2Id >= 0 && s2Id < m_nTotalSprites, "Trying to collide invalid sprite id" );
+
+	Point2f points1[MAX_HULL_POINTS], points2[MAX_HULL_POINTS];
+	float radius1, radius2;
+	int count1 = GetShapePoints( s1Id, points1, radius1 );
+	int count2 = GetShapePoints( s2Id, points2, radius2 );
+
+	// Rotate clockwise around the origins (as RotateScaleSprite does) and place them on the screen
+	auto place = []( Point2f* pPoints, int count, Point2f pos, float angle )
+	{
+		float cosAngle = cos( angle );
+		float sinAngle = sin( angle );
+		for( int i = 0; i < count; i++ )
 		{
-			uint32_t* destRowEnd = destPixels + endRow;
+			Point2f p = pPoints[i];
+			pPoints[i] = { pos.x + cosAngle * p.x - sinAngle * p.y, pos.y + sinAngle * p.x + cosAngle * p.y };
+		}
+	};
+	place( points1, count1, s1Pos, s1Angle );
+	place( points2, count2, s2Pos, s2Angle );
 
-			while( destPixels < destRowEnd )
+	// A point is inside a convex polygon if it is on the same side of every edge
+	auto contains = []( const Point2f* pPoints, int count, Point2f p )
+	{
+		if( count < 3 )
+			return false;
+
+		bool anyPositive = false, anyNegative = false;
+		for( int i = 0; i < count; i++ )
+		{
+			Point2f a = pPoints[i];
+			Point2f b = pPoints[( i + 1 ) % count];
+			float cross = ( b.x - a.x ) * ( p.y - a.y ) - ( b.y - a.y ) * ( p.x - a.x );
+			anyPositive |= cross > 0.0f;
+			anyNegative |= cross < 0.0f;
+		}
+		return !( anyPositive && anyNegative );
+	};
+
+	if( contains( points1, count1, points2[0] ) || contains( points2, count2, points1[0] ) )
+		return true;
+
+	// The closest distance between two segments is from an end of one of them to the other, unless they cross
+	auto pointSegmentDistSq = []( Point2f p, Point2f a, Point2f b )
+	{
+		Vector2f ab = b - a;
+		float lenSq = lengthSqr( ab );
+		float t = lenSq > 0.0f ? std::max( 0.0f, std::min( 1.0f, dot( p - a, ab ) / lenSq ) ) : 0.0f;
+		return lengthSqr( p - ( a + ab * t ) );
+	};
+	auto segmentsCross = []( Point2f a, Point2f b, Point2f c, Point2f d )
+	{
+		auto side = []( Point2f p, Point2f q, Point2f r ) { return ( q.x - p.x ) * ( r.y - p.y ) - ( q.y - p.y ) * ( r.x - p.x ); };
+		return side( a, b, c ) * side( a, b, d ) < 0.0f && side( c, d, a ) * side( c, d, b ) < 0.0f;
+	};
+
+	float reach = radius1 + radius2;
+	float reachSq = reach * reach;
+	int edges1 = count1 < 3 ? 1 : count1;
+	int edges2 = count2 < 3 ? 1 : count2;
+
+	for( int i = 0; i < edges1; i++ )
+	{
+		Point2f a = points1[i];
+		Point2f b = points1[( i + 1 ) % count1];
+
+		for( int j = 0; j < edges2; j++ )
+		{
+			Point2f c = points2[j];
+			Point2f d = points2[( j + 1 ) % count2];
+
+			if( segmentsCross( a, b, c, d ) )
+				return true;
+
+			float distSq = std::min( std::min( pointSegmentDistSq( a, c, d ), pointSegmentDistSq( b, c, d ) ),
+									 std::min( pointSegmentDistSq( c, a, b ), pointSegmentDistSq( d, a, b ) ) );
+			if( distSq < reachSq )
+				return true;
+		}
+	}
+
+	return false;
+}
+
+//********************************************************************************************************************************
+// Function:	BlitSprite - draws a sprite with and withough a global alpha multiply
+// Parameters:	spriteId = the id of the sprite to draw
+//				xpos, ypos = the position you want to draw the sprite
+//				frameIndex = which frame of the animation to draw (wrapped)
+//				params = the origin, tint and so on for this draw (see DrawParams)
+// Notes:		See BlitPixels
+//********************************************************************************************************************************
+void PlayBlitter::BlitSprite( int spriteId, int xpos, int ypos, int frameIndex, const DrawParams& params ) const
+{
+	PB_ASSERT_MSG( m_displayBuffer, "DisplayBuffer not initialised" );
+	PB_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to draw invalid sprite id" );
+
+	const Sprite& spr = vSpriteData[spriteId];
+
+	frameIndex = frameIndex % spr.totalCount;
+
+	const SpanRows spans{ spr.vRowSpanStarts.data() + ( static_cast<size_t>( spr.height ) * frameIndex ), spr.vSpans.data() };
+	const int originX = params.useOrigin ? static_cast<int>( params.origin.x ) : spr.originX;
+	const int originY = params.useOrigin ? static_cast<int>( params.origin.y ) : spr.originY;
+
+	// A flipped sprite is mirrored about its origin, so the origin is as far from its right edge as it was from its left
+	// (and from its bottom edge as it was from its top)
+	const int left = xpos - ( params.flipX ? spr.width - originX : originX );
+	const int top = ypos - ( params.flipY ? spr.height - originY : originY );
+	SubmitBlit( spr.FramePixels( frameIndex ), spr.frameStride, spans, spr.width, spr.height, left, top, params );
+}
+
+//********************************************************************************************************************************
+// Function:	SubmitBlit - draws a block of pre-multiplied pixels, or records it if a batch is being recorded
+// Parameters:	As BlitPixels
+//********************************************************************************************************************************
+void PlayBlitter::SubmitBlit( const uint32_t* pSrc, int srcStride, const SpanRows& spans, int width, int height, int left, int top, const DrawParams& params ) const
+{
+	MarkDirty( { left, top, left + width, top + height } );
+
+	if( !m_batching )
+	{
+		BlitPixels( pSrc, srcStride, spans, width, height, left, top, params, GetBufferRect() );
+		return;
+	}
+
+	DrawCommand command;
+	command.params = params;
+	command.pSrc = pSrc;
+	command.srcStride = srcStride;
+	command.spans = spans;
+	command.width = width;
+	command.height = height;
+	command.left = left;
+	command.top = top;
+	command.bounds = { left, top, left + width, top + height };
+	RecordDraw( command );
+}
+
+//********************************************************************************************************************************
+// Function:	BlitPixels - draws a block of pre-multiplied pixels with and without a global alpha multiply
+// Parameters:	pSrc = the top left pixel
+//				srcStride = the number of pixels from one row of the block to the next
+//				spans = the spans of each row
+//				width, height = the size of the block
+//				left, top = where the top left pixel goes in the display buffer
+//				params = the alpha multiply, tint and flip (the origin has already been used to work out left and top)
+//				clip = the part of the display buffer to draw to
+// Notes:		Each span is copied or blended by the kernel for the current SimdLevel, and the gaps between them are skipped.
+//				A tinted or flipped row is put together in a row buffer by PrepareRow first, and blended from there.
+//				Flipping top to bottom just reads the rows from the bottom up.
+//********************************************************************************************************************************
+void PlayBlitter::BlitPixels( const uint32_t* pSrc, int srcStride, const SpanRows& spans, int width, int height, int left, int top, const DrawParams& params, const ClipRect& clip ) const
+{
+	// Nothing within the clip rectangle to draw
+	if( left > clip.right || left + width < clip.left || top > clip.bottom || top + height < clip.top )
+		return;
+
+	// Work out if we need to clip (and by how much)
+	int xClipStart = clip.left - left;
+	if( xClipStart < 0 ) { xClipStart = 0; }
+
+	int xClipEnd = ( left + width ) - clip.right;
+	if( xClipEnd < 0 ) { xClipEnd = 0; }
+
+	int yClipStart = clip.top - top;
+	if( yClipStart < 0 ) { yClipStart = 0; }
+
+	int yClipEnd = ( top + height ) - clip.bottom;
+	if( yClipEnd < 0 ) { yClipEnd = 0; }
+
+	// Set up the destination pointer based on clipping (the source row is worked out for each row, as it may be flipped)
+	uint32_t* destPixels = m_displayBuffer + ( m_displayBufferWidth * ( top + yClipStart ) ) + ( left + xClipStart );
+
+	//How many rows in sprite, and where each row stops being visible.
+	int rows = height - yClipEnd - yClipStart;
+	int visibleRight = width - xClipEnd;
+
+	// The kernels work in 16 bits per channel, which only has room for multipliers from 0 to 1
+	const SimdLevel simdLevel = m_simdLevel;
+	const float alphaMultiply = params.alphaMultiply;
+	const SimdLevel alphaSimdLevel = alphaMultiply >= 0.0f ? simdLevel : SIMD_NONE;
+	const bool prepareRows = params.flipX || ( params.tint & 0x00FFFFFF ) != 0x00FFFFFF;
+
+	// The source columns which are visible (which are at the other end of the row when it's flipped)
+	const int srcLeft = params.flipX ? width - visibleRight : xClipStart;
+	const int srcRight = params.flipX ? width - xClipStart : visibleRight;
+
+	for( int row = 0; row < rows; row++ )
+	{
+		const int srcRow = params.flipY ? height - 1 - yClipStart - row : yClipStart + row;
+		const uint32_t* srcPixels = pSrc + ( srcStride * srcRow ) + xClipStart;
+		const PixelSpan* pSpanStart = spans.pSpans + spans.pRowStarts[srcRow];
+		const PixelSpan* pSpanEnd = spans.pSpans + spans.pRowStarts[srcRow + 1];
+
+		// A tinted or flipped row is prepared a chunk at a time in a row buffer, and drawn from there the same way as below
+		// > Neither changes which pixels are opaque, so the spans still say which chunks can be copied
+		if( prepareRows )
+		{
+			const bool wholeRow = alphaMultiply < 1.0f;
+			const PixelSpan* pSpanLast = wholeRow && pSpanStart < pSpanEnd ? pSpanStart + 1 : pSpanEnd;
+			const uint32_t* pRowSrc = srcPixels - xClipStart;
+			uint32_t* pRowDest = destPixels - xClipStart;
+			uint32_t rowPixels[ROTATE_CHUNK];
+
+			for( const PixelSpan* pSpan = pSpanStart; pSpan < pSpanLast; pSpan++ )
 			{
-				uint32_t src = *srcPixels++;
-				uint32_t dest = *destPixels;
+				const int first = std::max<int>( pSpan->left, srcLeft );
+				const int last = std::min<int>( wholeRow ? ( pSpanEnd - 1 )->right : pSpan->right, srcRight );
 
-				// If this isn't a fully transparent pixel 
-				if( src < 0xFF000000 )
+				for( int x = first; x < last; x += ROTATE_CHUNK )
 				{
-					// This performes the dest*(1-srcAlpha) calculation for all channels in parallel with minor accuracy loss in dest colour.
-					// It does this by shifting all the destination channels down by 4 bits in order to "make room" for the later multiplication.
-					// After shifting down, it masks out the bits which have shifted into the adjacent channel data.
-					// This casues the RGB data to be rounded down to their nearest 16 producing a reduction in colour accuracy.
-					// This is then multiplied by the inverse alpha (inversed in PreMultiplyAlpha), also divided by 16 (hence >> 8+8+8+4).
-					// The multiplication brings our RGB values back up to their original bit ranges (albeit rounded to the nearest 16).
-					// As the colour accuracy only affects the desination pixels behind semi-transparent source pixels and so isn't very obvious.
-					dest = ( ( ( dest >> 4 ) & 0x000F0F0F ) * ( src >> 28 ) );
-					// Add the (pre-multiplied Alpha) source to the destination and force alpha to opaque
-					*destPixels++ = ( src + dest ) | 0xFF000000;
+					const int count = std::min( ROTATE_CHUNK, last - x );
+					PrepareRow( rowPixels, pRowSrc + x, count, params, simdLevel, wholeRow || !pSpan->copy );
+
+					uint32_t* pDest = pRowDest + ( params.flipX ? width - x - count : x );
+					if( wholeRow )
+					{
+						switch( alphaSimdLevel )
+						{
+						case SIMD_AVX2: BlendRowAlphaAVX2( pDest, rowPixels, count, alphaMultiply ); break;
+						case SIMD_SSE2: BlendRowAlphaSSE2( pDest, rowPixels, count, alphaMultiply ); break;
+						default: BlendRowAlpha( pDest, rowPixels, count, alphaMultiply ); break;
+						}
+					}
+					else if( pSpan->copy )
+					{
+						switch( simdLevel )
+						{
+						case SIMD_AVX2: CopyRowAVX2( pDest, rowPixels, count ); break;
+						case SIMD_SSE2: CopyRowSSE2( pDest, rowPixels, count ); break;
+						default: CopyRow( pDest, rowPixels, count ); break;
+						}
+					}
+					else
+					{
+						switch( simdLevel )
+						{
+						case SIMD_AVX2: BlendRowAVX2( pDest, rowPixels, count ); break;
+						case SIMD_SSE2: BlendRowSSE2( pDest, rowPixels, count ); break;
+						default: BlendRow( pDest, rowPixels, count ); break;
+						}
+					}
+				}
+			}
+		}
+		// Nothing can be copied with a global alpha multiply, so the whole row is blended in one go from its first span to its last
+		else if( alphaMultiply < 1.0f )
+		{
+			if( pSpanStart < pSpanEnd )
+			{
+				const int first = std::max<int>( pSpanStart->left, xClipStart );
+				const int count = std::min<int>( ( pSpanEnd - 1 )->right, visibleRight ) - first;
+				if( count > 0 )
+				{
+					uint32_t* pDest = destPixels + ( first - xClipStart );
+					const uint32_t* pRowSrc = srcPixels + ( first - xClipStart );
+					switch( alphaSimdLevel )
+					{
+					case SIMD_AVX2: BlendRowAlphaAVX2( pDest, pRowSrc, count, alphaMultiply ); break;
+					case SIMD_SSE2: BlendRowAlphaSSE2( pDest, pRowSrc, count, alphaMultiply ); break;
+					default: BlendRowAlpha( pDest, pRowSrc, count, alphaMultiply ); break;
+					}
+				}
+			}
+		}
+		else
+		{
+			// Otherwise each span is copied or blended, and the gaps between them are skipped
+			for( const PixelSpan* pSpan = pSpanStart; pSpan < pSpanEnd && pSpan->left < visibleRight; pSpan++ )
+			{
+				const int first = std::max<int>( pSpan->left, xClipStart );
+				const int count = std::min<int>( pSpan->right, visibleRight ) - first;
+				if( count <= 0 )
+					continue;
+
+				uint32_t* pDest = destPixels + ( first - xClipStart );
+				const uint32_t* pRowSrc = srcPixels + ( first - xClipStart );
+
+				if( pSpan->copy )
+				{
+					switch( simdLevel )
+					{
+					case SIMD_AVX2: CopyRowAVX2( pDest, pRowSrc, count ); break;
+					case SIMD_SSE2: CopyRowSSE2( pDest, pRowSrc, count ); break;
+					default: CopyRow( pDest, pRowSrc, count ); break;
+					}
 				}
 				else
 				{
-					// If this is a fully transparent pixel then the low bits store how many there are in a row
-					// This means we can skip to the next pixel which isn't fully transparent
-					uint32_t skip = std::min( src & 0x00FFFFFF, (uint32_t)( destRowEnd - destPixels - 1 ) );
-					srcPixels += skip;
-					++destPixels += skip;
+					switch( simdLevel )
+					{
+					case SIMD_AVX2: BlendRowAVX2( pDest, pRowSrc, count ); break;
+					case SIMD_SSE2: BlendRowSSE2( pDest, pRowSrc, count ); break;
+					default: BlendRow( pDest, pRowSrc, count ); break;
+					}
 				}
 			}
-			// Increase buffers by pre-calculated amounts
-			destPixels += destInc;
-			srcPixels += srcInc;
 		}
 
+		destPixels += m_displayBufferWidth;
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	BlendRow - blends a row of pre-multiplied sprite pixels onto the display buffer, one pixel at a time
+// Parameters:	destPixels = the first display buffer pixel in the row
+//				srcPixels = the first pre-multiplied sprite pixel in the row
+//				count = the number of pixels in the row
+// Notes:		The reference version which the SIMD versions must match exactly
+//********************************************************************************************************************************
+void PlayBlitter::BlendRow( uint32_t* destPixels, const uint32_t* srcPixels, int count )
+{
+	// *******************************************************************************************************************************************************
+	// An optimized approach which uses pre-multiplied alpha, parallel channel multiplication and pixel skipping to achieve the same 'typical' alpha 
+	// blending operation (src * srcAlpha)+(dest * (1-srcAlpha)). Not easy to apply a global alpha multiplication over the top, but used everywhere else.
+	// *******************************************************************************************************************************************************
+	uint32_t* destRowEnd = destPixels + count;
+
+	while( destPixels < destRowEnd )
+	{
+		uint32_t src = *srcPixels++;
+		uint32_t dest = *destPixels;
+
+		// If this isn't a fully transparent pixel 
+		if( src < 0xFF000000 )
+		{
+			// This performes the dest*(1-srcAlpha) calculation for all channels in parallel with minor accuracy loss in dest colour.
+			// It does this by shifting all the destination channels down by 4 bits in order to "make room" for the later multiplication.
+			// After shifting down, it masks out the bits which have shifted into the adjacent channel data.
+			// This casues the RGB data to be rounded down to their nearest 16 producing a reduction in colour accuracy.
+			// This is then multiplied by the inverse alpha (inversed in PreMultiplyAlpha), also divided by 16 (hence >> 8+8+8+4).
+			// The multiplication brings our RGB values back up to their original bit ranges (albeit rounded to the nearest 16).
+			// As the colour accuracy only affects the desination pixels behind semi-transparent source pixels and so isn't very obvious.
+			dest = ( ( ( dest >> 4 ) & 0x000F0F0F ) * ( src >> 28 ) );
+			// Add the (pre-multiplied Alpha) source to the destination and force alpha to opaque
+			*destPixels++ = ( src + dest ) | 0xFF000000;
+		}
+		else
+		{
+			// If this is a fully transparent pixel then the low bits store how many there are in a row
+			// This means we can skip to the next pixel which isn't fully transparent
+			uint32_t skip = std::min( src & 0x00FFFFFF, (uint32_t)( destRowEnd - destPixels - 1 ) );
+			srcPixels += skip;
+			++destPixels += skip;
+		}
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	BlendRowSSE2 - blends a row of pre-multiplied sprite pixels onto the display buffer, four pixels at a time
+// Parameters:	As BlendRow
+// Notes:		Each channel's product with the 4-bit inverse alpha fits in a byte, so the 32-bit multiply in BlendRow can be done 
+//				as two 16-bit multiplies (SSE2 has no 32-bit multiply). Transparent pixels are left alone with a mask, but runs of 
+//				them are still skipped whenever one starts a group of four. The last few pixels are done by BlendRow.
+//********************************************************************************************************************************
+void PlayBlitter::BlendRowSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count )
+{
+	// SSE2 only compares signed numbers, so flipping the top bit turns (src < 0xFF000000) into a signed comparison
+	const __m128i signBit = _mm_set1_epi32( static_cast<int>( 0x80000000 ) );
+	const __m128i transparent = _mm_set1_epi32( 0x7F000000 );
+	const __m128i channelMask = _mm_set1_epi32( 0x000F0F0F );
+	const __m128i opaque = _mm_set1_epi32( static_cast<int>( 0xFF000000 ) );
+
+	int n = 0;
+	while( n + 4 <= count )
+	{
+		const uint32_t first = srcPixels[n];
+		if( first >= 0xFF000000 )
+		{
+			n += 1 + std::min( static_cast<int>( first & 0x00FFFFFF ), count - n - 1 );
+			continue;
+		}
+
+		__m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( srcPixels + n ) );
+		__m128i dest = _mm_loadu_si128( reinterpret_cast<const __m128i*>( destPixels + n ) );
+
+		// The inverse alpha in both halves of each pixel, for dest*(1-srcAlpha) as in BlendRow
+		__m128i invAlpha = _mm_srli_epi32( src, 28 );
+		invAlpha = _mm_or_si128( invAlpha, _mm_slli_epi32( invAlpha, 16 ) );
+		__m128i blended = _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi32( dest, 4 ), channelMask ), invAlpha );
+		blended = _mm_or_si128( _mm_add_epi32( src, blended ), opaque );
+
+		__m128i draw = _mm_cmplt_epi32( _mm_xor_si128( src, signBit ), transparent );
+		blended = _mm_or_si128( _mm_and_si128( draw, blended ), _mm_andnot_si128( draw, dest ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( destPixels + n ), blended );
+		n += 4;
+	}
+
+	BlendRow( destPixels + n, srcPixels + n, count - n );
+}
+
+//********************************************************************************************************************************
+// Function:	BlendRowAVX2 - blends a row of pre-multiplied sprite pixels onto the display buffer, eight pixels at a time
+// Parameters:	As BlendRow
+// Notes:		BlendRowSSE2 with twice the width. Only called when the CPU supports AVX2.
+//********************************************************************************************************************************
+PLAY_TARGET_AVX2 void PlayBlitter::BlendRowAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count )
+{
+	const __m256i signBit = _mm256_set1_epi32( static_cast<int>( 0x80000000 ) );
+	const __m256i transparent = _mm256_set1_epi32( 0x7F000000 );
+	const __m256i channelMask = _mm256_set1_epi32( 0x000F0F0F );
+	const __m256i opaque = _mm256_set1_epi32( static_cast<int>( 0xFF000000 ) );
+
+	int n = 0;
+	while( n + 8 <= count )
+	{
+		const uint32_t first = srcPixels[n];
+		if( first >= 0xFF000000 )
+		{
+			n += 1 + std::min( static_cast<int>( first & 0x00FFFFFF ), count - n - 1 );
+			continue;
+		}
+
+		__m256i src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( srcPixels + n ) );
+		__m256i dest = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( destPixels + n ) );
+
+		__m256i invAlpha = _mm256_srli_epi32( src, 28 );
+		invAlpha = _mm256_or_si256( invAlpha, _mm256_slli_epi32( invAlpha, 16 ) );
+		__m256i blended = _mm256_mullo_epi16( _mm256_and_si256( _mm256_srli_epi32( dest, 4 ), channelMask ), invAlpha );
+		blended = _mm256_or_si256( _mm256_add_epi32( src, blended ), opaque );
+
+		__m256i draw = _mm256_cmpgt_epi32( transparent, _mm256_xor_si256( src, signBit ) );
+		blended = _mm256_blendv_epi8( dest, blended, draw );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( destPixels + n ), blended );
+		n += 8;
+	}
+
+	// Mixing AVX with the (non-AVX) SSE2 code is slow unless the top halves of the registers are cleared first
+	_mm256_zeroupper();
+	BlendRowSSE2( destPixels + n, srcPixels + n, count - n );
+}
+
+//********************************************************************************************************************************
+// Function:	BlendRowAlpha - blends a row of pre-multiplied sprite pixels onto the display buffer with a global alpha multiply
+// Parameters:	destPixels = the first display buffer pixel in the row
+//				srcPixels = the first pre-multiplied sprite pixel in the row
+//				count = the number of pixels in the row
+//				alphaMultiply = the global alpha multiply
+// Notes:		The reference version which the SIMD versions must match exactly
+//********************************************************************************************************************************
+void PlayBlitter::BlendRowAlpha( uint32_t* destPixels, const uint32_t* srcPixels, int count, float alphaMultiply )
+{
+	// *******************************************************************************************************************************************************
+	// A basic approach which separates the channels and performs a 'typical' alpha blending operation: (src * srcAlpha)+(dest * (1-srcAlpha))
+	// Has the advantage that a global alpha multiplication can be easily added over the top, so we use this method when a global multiply is required
+	// *******************************************************************************************************************************************************
+	uint32_t* destRowEnd = destPixels + count;
+
+	while( destPixels < destRowEnd )
+	{
+		uint32_t src = *srcPixels++;
+		uint32_t dest = *destPixels;
+
+		// If this isn't a fully transparent pixel 
+		if( src < 0xFF000000 )
+		{
+			int srcAlpha = static_cast<int>( ( 0xFF - ( src >> 24 ) ) * alphaMultiply );
+			int constAlpha = static_cast<int>( 255 * alphaMultiply );
+
+			// Source pixels are already multiplied by srcAlpha so we just apply the constant alpha multiplier
+			int destRed = constAlpha * ( ( src >> 16 ) & 0xFF );
+			int destGreen = constAlpha * ( ( src >> 8 ) & 0xFF );
+			int destBlue = constAlpha * ( src & 0xFF );
+
+			int invSrcAlpha = 0xFF - srcAlpha;
+
+			// Apply a standard Alpha blend [ src*srcAlpha + dest*(1-SrcAlpha) ]
+			destRed += invSrcAlpha * ( ( dest >> 16 ) & 0xFF );
+			destGreen += invSrcAlpha * ( ( dest >> 8 ) & 0xFF );
+			destBlue += invSrcAlpha * ( dest & 0xFF );
+
+			// Bring back to the range 0-255
+			destRed >>= 8;
+			destGreen >>= 8;
+			destBlue >>= 8;
+
+			// Put ARGB components back together again
+			*destPixels++ = 0xFF000000 | ( destRed << 16 ) | ( destGreen << 8 ) | destBlue;
+		}
+		else
+		{
+			// If this is a fully transparent pixel then the low bits store how many there are in a row
+			// This means we can skip to the next pixel which isn't fully transparent
+			uint32_t skip = std::min( src & 0x00FFFFFF, (uint32_t)( destRowEnd - destPixels - 1 ) );
+			srcPixels += skip;
+			++destPixels += skip;
+		}
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	BlendRowAlphaSSE2 - blends a row of sprite pixels with a global alpha multiply, four pixels at a time
+// Parameters:	As BlendRowAlpha
+// Notes:		The channels are widened to 16 bits. With a multiplier from 0 to 1, src*constAlpha + dest*(255-srcAlpha) is at 
+//				most 255*256, so the sums fit without overflowing. srcAlpha is worked out with the same float multiply and 
+//				truncation as BlendRowAlpha, so it matches exactly.
+//********************************************************************************************************************************
+void PlayBlitter::BlendRowAlphaSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count, float alphaMultiply )
+{
+	const __m128i signBit = _mm_set1_epi32( static_cast<int>( 0x80000000 ) );
+	const __m128i transparent = _mm_set1_epi32( 0x7F000000 );
+	const __m128i opaque = _mm_set1_epi32( static_cast<int>( 0xFF000000 ) );
+	const __m128i maxChannel = _mm_set1_epi32( 0xFF );
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 multiply = _mm_set1_ps( alphaMultiply );
+	const __m128i constAlpha = _mm_set1_epi16( static_cast<short>( static_cast<int>( 255 * alphaMultiply ) ) );
+
+	int n = 0;
+	while( n + 4 <= count )
+	{
+		const uint32_t first = srcPixels[n];
+		if( first >= 0xFF000000 )
+		{
+			n += 1 + std::min( static_cast<int>( first & 0x00FFFFFF ), count - n - 1 );
+			continue;
+		}
+
+		__m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( srcPixels + n ) );
+		__m128i dest = _mm_loadu_si128( reinterpret_cast<const __m128i*>( destPixels + n ) );
+
+		// 255 - srcAlpha for each pixel, copied to all four of its channels
+		__m128i srcAlpha = _mm_sub_epi32( maxChannel, _mm_srli_epi32( src, 24 ) );
+		srcAlpha = _mm_cvttps_epi32( _mm_mul_ps( _mm_cvtepi32_ps( srcAlpha ), multiply ) );
+		__m128i invAlpha = _mm_sub_epi32( maxChannel, srcAlpha );
+		invAlpha = _mm_or_si128( invAlpha, _mm_slli_epi32( invAlpha, 16 ) );
+		__m128i invAlphaLo = _mm_unpacklo_epi32( invAlpha, invAlpha );
+		__m128i invAlphaHi = _mm_unpackhi_epi32( invAlpha, invAlpha );
+
+		__m128i lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( src, zero ), constAlpha ), _mm_mullo_epi16( _mm_unpacklo_epi8( dest, zero ), invAlphaLo ) );
+		__m128i hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( src, zero ), constAlpha ), _mm_mullo_epi16( _mm_unpackhi_epi8( dest, zero ), invAlphaHi ) );
+		__m128i blended = _mm_or_si128( _mm_packus_epi16( _mm_srli_epi16( lo, 8 ), _mm_srli_epi16( hi, 8 ) ), opaque );
+
+		__m128i draw = _mm_cmplt_epi32( _mm_xor_si128( src, signBit ), transparent );
+		blended = _mm_or_si128( _mm_and_si128( draw, blended ), _mm_andnot_si128( draw, dest ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( destPixels + n ), blended );
+		n += 4;
+	}
+
+	BlendRowAlpha( destPixels + n, srcPixels + n, count - n, alphaMultiply );
+}
+
+//********************************************************************************************************************************
+// Function:	BlendRowAlphaAVX2 - blends a row of sprite pixels with a global alpha multiply, eight pixels at a time
+// Parameters:	As BlendRowAlpha
+// Notes:		BlendRowAlphaSSE2 with twice the width (the unpacks and packs work within each half, so they still pair up). 
+//				Only called when the CPU supports AVX2.
+//********************************************************************************************************************************
+PLAY_TARGET_AVX2 void PlayBlitter::BlendRowAlphaAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count, float alphaMultiply )
+{
+	const __m256i signBit = _mm256_set1_epi32( static_cast<int>( 0x80000000 ) );
+	const __m256i transparent = _mm256_set1_epi32( 0x7F000000 );
+	const __m256i opaque = _mm256_set1_epi32( static_cast<int>( 0xFF000000 ) );
+	const __m256i maxChannel = _mm256_set1_epi32( 0xFF );
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256 multiply = _mm256_set1_ps( alphaMultiply );
+	const __m256i constAlpha = _mm256_set1_epi16( static_cast<short>( static_cast<int>( 255 * alphaMultiply ) ) );
+
+	int n = 0;
+	while( n + 8 <= count )
+	{
+		const uint32_t first = srcPixels[n];
+		if( first >= 0xFF000000 )
+		{
+			n += 1 + std::min( static_cast<int>( first & 0x00FFFFFF ), count - n - 1 );
+			continue;
+		}
+
+		__m256i src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( srcPixels + n ) );
+		__m256i dest = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( destPixels + n ) );
+
+		__m256i srcAlpha = _mm256_sub_epi32( maxChannel, _mm256_srli_epi32( src, 24 ) );
+		srcAlpha = _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_cvtepi32_ps( srcAlpha ), multiply ) );
+		__m256i invAlpha = _mm256_sub_epi32( maxChannel, srcAlpha );
+		invAlpha = _mm256_or_si256( invAlpha, _mm256_slli_epi32( invAlpha, 16 ) );
+		__m256i invAlphaLo = _mm256_unpacklo_epi32( invAlpha, invAlpha );
+		__m256i invAlphaHi = _mm256_unpackhi_epi32( invAlpha, invAlpha );
+
+		__m256i lo = _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpacklo_epi8( src, zero ), constAlpha ), _mm256_mullo_epi16( _mm256_unpacklo_epi8( dest, zero ), invAlphaLo ) );
+		__m256i hi = _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpackhi_epi8( src, zero ), constAlpha ), _mm256_mullo_epi16( _mm256_unpackhi_epi8( dest, zero ), invAlphaHi ) );
+		__m256i blended = _mm256_or_si256( _mm256_packus_epi16( _mm256_srli_epi16( lo, 8 ), _mm256_srli_epi16( hi, 8 ) ), opaque );
+
+		__m256i draw = _mm256_cmpgt_epi32( transparent, _mm256_xor_si256( src, signBit ) );
+		blended = _mm256_blendv_epi8( dest, blended, draw );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( destPixels + n ), blended );
+		n += 8;
+	}
+
+	_mm256_zeroupper();
+	BlendRowAlphaSSE2( destPixels + n, srcPixels + n, count - n, alphaMultiply );
+}
+
+//********************************************************************************************************************************
+// Function:	CopyRow - copies a span of opaque pre-multiplied sprite pixels to the display buffer, one pixel at a time
+// Parameters:	As BlendRow
+// Notes:		BlendRow adds nothing from the display buffer when the inverse alpha is below 16, and just sets the alpha
+//********************************************************************************************************************************
+void PlayBlitter::CopyRow( uint32_t* destPixels, const uint32_t* srcPixels, int count )
+{
+	for( int n = 0; n < count; n++ )
+		destPixels[n] = srcPixels[n] | 0xFF000000;
+}
+
+//********************************************************************************************************************************
+// Function:	CopyRowSSE2 - copies a span of opaque pre-multiplied sprite pixels to the display buffer, four pixels at a time
+// Parameters:	As BlendRow
+//********************************************************************************************************************************
+void PlayBlitter::CopyRowSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count )
+{
+	const __m128i opaque = _mm_set1_epi32( static_cast<int>( 0xFF000000 ) );
+
+	int n = 0;
+	for( ; n + 4 <= count; n += 4 )
+	{
+		__m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( srcPixels + n ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( destPixels + n ), _mm_or_si128( src, opaque ) );
+	}
+
+	// Copying a pixel twice doesn't change it, so the last few are done by copying the last group of four again
+	if( n < count && count >= 4 )
+	{
+		__m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( srcPixels + count - 4 ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( destPixels + count - 4 ), _mm_or_si128( src, opaque ) );
+		n = count;
+	}
+
+	CopyRow( destPixels + n, srcPixels + n, count - n );
+}
+
+//********************************************************************************************************************************
+// Function:	CopyRowAVX2 - copies a span of opaque pre-multiplied sprite pixels to the display buffer, eight pixels at a time
+// Parameters:	As BlendRow
+// Notes:		Only called when the CPU supports AVX2
+//********************************************************************************************************************************
+PLAY_TARGET_AVX2 void PlayBlitter::CopyRowAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count )
+{
+	const __m256i opaque = _mm256_set1_epi32( static_cast<int>( 0xFF000000 ) );
+
+	int n = 0;
+	for( ; n + 8 <= count; n += 8 )
+	{
+		__m256i src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( srcPixels + n ) );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( destPixels + n ), _mm256_or_si256( src, opaque ) );
+	}
+
+	// Copying a pixel twice doesn't change it, so the last few are done by copying the last group of eight again
+	if( n < count && count >= 8 )
+	{
+		__m256i src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( srcPixels + count - 8 ) );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( destPixels + count - 8 ), _mm256_or_si256( src, opaque ) );
+		n = count;
+	}
+
+	_mm256_zeroupper();
+	CopyRowSSE2( destPixels + n, srcPixels + n, count - n );
+}
+
+//********************************************************************************************************************************
+// Function:	TintRow - copies a row of pre-multiplied sprite pixels with each colour channel multiplied by a tint
+// Parameters:	destPixels = where the tinted pixels go (which can be srcPixels)
+//				srcPixels = the first pre-multiplied sprite pixel in the row
+//				count = the number of pixels in the row
+//				tint = the multiplier for each channel, as 0x00RRGGBB
+// Notes:		The reference version which the SIMD versions must match exactly. PreMultiplyAlpha applies ColourSprite's
+//				colour multiply after the alpha in the same way, so the pixels come out within one step per channel of a
+//				recoloured sprite (the loaded pixels were already multiplied by white). Transparent pixels hold their run
+//				length rather than a colour, so they're left alone.
+//********************************************************************************************************************************
+void PlayBlitter::TintRow( uint32_t* destPixels, const uint32_t* srcPixels, int count, uint32_t tint )
+{
+	const uint32_t tintRed = ( tint >> 16 ) & 0xFF;
+	const uint32_t tintGreen = ( tint >> 8 ) & 0xFF;
+	const uint32_t tintBlue = tint & 0xFF;
+
+	for( int n = 0; n < count; n++ )
+	{
+		uint32_t src = srcPixels[n];
+		if( src >= 0xFF000000 )
+		{
+			destPixels[n] = src;
+			continue;
+		}
+
+		uint32_t red = ( ( ( src >> 16 ) & 0xFF ) * tintRed ) >> 8;
+		uint32_t green = ( ( ( src >> 8 ) & 0xFF ) * tintGreen ) >> 8;
+		uint32_t blue = ( ( src & 0xFF ) * tintBlue ) >> 8;
+		destPixels[n] = ( src & 0xFF000000 ) | ( red << 16 ) | ( green << 8 ) | blue;
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	TintRowSSE2 - copies a row of pre-multiplied sprite pixels with a tint, four pixels at a time
+// Parameters:	As TintRow
+// Notes:		The alpha channel is multiplied by 256 so the shift back down leaves it as it was
+//********************************************************************************************************************************
+void PlayBlitter::TintRowSSE2( uint32_t* destPixels, const uint32_t* srcPixels, int count, uint32_t tint )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i transparent = _mm_set1_epi32( 0xFF );
+	const __m128i multiply = _mm_set_epi16( 256, static_cast<short>( ( tint >> 16 ) & 0xFF ), static_cast<short>( ( tint >> 8 ) & 0xFF ), static_cast<short>( tint & 0xFF ),
+											256, static_cast<short>( ( tint >> 16 ) & 0xFF ), static_cast<short>( ( tint >> 8 ) & 0xFF ), static_cast<short>( tint & 0xFF ) );
+
+	int n = 0;
+	for( ; n + 4 <= count; n += 4 )
+	{
+		__m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( srcPixels + n ) );
+
+		__m128i lo = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( src, zero ), multiply ), 8 );
+		__m128i hi = _mm_srli_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( src, zero ), multiply ), 8 );
+		__m128i tinted = _mm_packus_epi16( lo, hi );
+
+		__m128i keep = _mm_cmpeq_epi32( _mm_srli_epi32( src, 24 ), transparent );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( destPixels + n ), _mm_or_si128( _mm_and_si128( keep, src ), _mm_andnot_si128( keep, tinted ) ) );
+	}
+
+	TintRow( destPixels + n, srcPixels + n, count - n, tint );
+}
+
+//********************************************************************************************************************************
+// Function:	TintRowAVX2 - copies a row of pre-multiplied sprite pixels with a tint, eight pixels at a time
+// Parameters:	As TintRow
+// Notes:		Only called when the CPU supports AVX2
+//********************************************************************************************************************************
+PLAY_TARGET_AVX2 void PlayBlitter::TintRowAVX2( uint32_t* destPixels, const uint32_t* srcPixels, int count, uint32_t tint )
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i transparent = _mm256_set1_epi32( 0xFF );
+	const __m256i multiply = _mm256_set1_epi64x( ( 256ll << 48 ) | ( static_cast<long long>( ( tint >> 16 ) & 0xFF ) << 32 ) | ( static_cast<long long>( ( tint >> 8 ) & 0xFF ) << 16 ) | ( tint & 0xFF ) );
+
+	int n = 0;
+	for( ; n + 8 <= count; n += 8 )
+	{
+		__m256i src = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( srcPixels + n ) );
+
+		// The unpacks and the pack both work within each 128 bit lane, so the pixels come back out in the same order
+		__m256i lo = _mm256_srli_epi16( _mm256_mullo_epi16( _mm256_unpacklo_epi8( src, zero ), multiply ), 8 );
+		__m256i hi = _mm256_srli_epi16( _mm256_mullo_epi16( _mm256_unpackhi_epi8( src, zero ), multiply ), 8 );
+		__m256i tinted = _mm256_packus_epi16( lo, hi );
+
+		__m256i keep = _mm256_cmpeq_epi32( _mm256_srli_epi32( src, 24 ), transparent );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( destPixels + n ), _mm256_blendv_epi8( tinted, src, keep ) );
+	}
+
+	_mm256_zeroupper();
+	TintRowSSE2( destPixels + n, srcPixels + n, count - n, tint );
+}
+
+//********************************************************************************************************************************
+// Function:	PrepareRow - copies part of a row of a block into a row buffer, tinted and mirrored as a draw asks
+// Parameters:	destPixels = the row buffer
+//				srcPixels = the first pixel of the part of the row (the last one to be drawn if it's flipped)
+//				count = the number of pixels
+//				params = the tint and flip
+//				simdLevel = which tint kernel to use
+//				markRuns = whether the pixels are going to be blended
+// Notes:		Mirroring reverses the transparent runs too, so they're worked out again for the row buffer if it's blended
+//********************************************************************************************************************************
+void PlayBlitter::PrepareRow( uint32_t* destPixels, const uint32_t* srcPixels, int count, const DrawParams& params, SimdLevel simdLevel, bool markRuns )
+{
+	const uint32_t* pTintSrc = srcPixels;
+	if( params.flipX )
+	{
+		std::reverse_copy( srcPixels, srcPixels + count, destPixels );
+		pTintSrc = destPixels;
+	}
+
+	if( ( params.tint & 0x00FFFFFF ) != 0x00FFFFFF )
+	{
+		switch( simdLevel )
+		{
+		case SIMD_AVX2: TintRowAVX2( destPixels, pTintSrc, count, params.tint ); break;
+		case SIMD_SSE2: TintRowSSE2( destPixels, pTintSrc, count, params.tint ); break;
+		default: TintRow( destPixels, pTintSrc, count, params.tint ); break;
+		}
+	}
+	else if( !params.flipX )
+	{
+		std::copy( srcPixels, srcPixels + count, destPixels );
 	}
 
-	return;
+	if( params.flipX && markRuns )
+		MarkTransparentRuns( destPixels, count );
+}
+
+//********************************************************************************************************************************
+// Function:	DetectSimdLevel - finds the best instruction set for BlitSprite which the CPU supports
+// Notes:		AVX2 also needs the operating system to save the 256-bit registers, which XGETBV reports. 64-bit CPUs always
+//				have SSE2.
+//********************************************************************************************************************************
+PlayBlitter::SimdLevel PlayBlitter::DetectSimdLevel()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid( info, 0 );
+	const int maxLeaf = info[0];
+	__cpuid( info, 1 );
+	const bool sse2 = ( info[3] & ( 1 << 26 ) ) != 0;
+	const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+	const bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+
+	if( maxLeaf >= 7 && osxsave && avx && ( _xgetbv( 0 ) & 6 ) == 6 )
+	{
+		__cpuidex( info, 7, 0 );
+		if( info[1] & ( 1 << 5 ) )
+			return SIMD_AVX2;
+	}
+	return sse2 ? SIMD_SSE2 : SIMD_NONE;
+#else
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports( "avx2" ) )
+		return SIMD_AVX2;
+	return __builtin_cpu_supports( "sse2" ) ? SIMD_SSE2 : SIMD_NONE;
+#endif
 }
 
 
@@ -2897,32 +4848,163 @@ void PlayBlitter::BlitSprite( int spriteId, int xpos, int ypos, int frameIndex,
 //				frameIndex = which frame of the animation to draw (wrapped)
 //				angle = rotation angle
 //				scale = parameter to magnify the sprite.
-//				rotOffX, rotOffY = offset of centre of rotation to the top left of the sprite
-//				alpha = the fraction defining the amount of sprite and background that is draw. 255 = all sprite, 0 = all background.
-// Notes:		Pre-calculates roughly where the sprite will be in the display buffer and only processes those pixels. 
-//				Approx 15 times slower than not rotating.
+//				params = the origin (the centre of rotation), alpha multiply, tint and flip (see DrawParams)
+// Notes:		Pre-calculates roughly where the sprite will be in the display buffer (see GetRotatedRect), and draws it with 
+//				DrawRotatedRect, which only processes the pixels of each row that land in the opaque part of the sprite frame. 
+//				Blits the frame from the rotation cache instead if that's on.
+//				Flipping top to bottom is the same as flipping left to right and turning half way round, so that's how it's done.
 //********************************************************************************************************************************
-void PlayBlitter::RotateScaleSprite( int spriteId, int xpos, int ypos, int frameIndex, float angle, float scale, float alphaMultiply ) const
+void PlayBlitter::RotateScaleSprite( int spriteId, int xpos, int ypos, int frameIndex, float angle, float scale, const DrawParams& params ) const
 {
 	PB_ASSERT_MSG( m_displayBuffer, "DisplayBuffer not initialised" );
 	PB_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to draw invalid sprite id" );
 
 	const Sprite& spr = vSpriteData[spriteId];
-
 	frameIndex = frameIndex % spr.totalCount;
-	int imageX = frameIndex % spr.hCount;
-	int imageY = frameIndex / spr.hCount;
-	int pixelX = imageX * spr.width;
-	int pixelY = imageY * spr.height;
-	int frameOffset = pixelX + ( spr.canvasWidth * pixelY );
-
-	//pointers to start of source and destination buffers
-	uint32_t* pSrcBase = spr.pPreMultAlpha + frameOffset;
+
+	const int originX = params.useOrigin ? static_cast<int>( params.origin.x ) : spr.originX;
+	const int originY = params.useOrigin ? static_cast<int>( params.origin.y ) : spr.originY;
+	const bool flipX = params.flipX != params.flipY;
+	if( params.flipY )
+		angle += PLAY_PI;
+
+	if( m_rotationSteps > 0 && scale == 1.0f )
+	{
+		const RotatedFrame* pFrame = GetRotatedFrame( spriteId, frameIndex, angle, originX, originY, flipX );
+		if( pFrame )
+		{
+			// The flip is already in the rotated frame
+			DrawParams blitParams = params;
+			blitParams.flipX = false;
+			blitParams.flipY = false;
+			SubmitBlit( pFrame->pixels.data(), pFrame->width, { pFrame->rowStarts.data(), pFrame->spans.data() }, pFrame->width, pFrame->height, xpos + pFrame->left, ypos + pFrame->top, blitParams );
+			return;
+		}
+	}
+
+	RotatedRect rect;
+	GetRotatedRect( spr, originX, originY, flipX, xpos, ypos, angle, scale, m_displayBufferWidth, m_displayBufferHeight, rect );
+	SubmitRotated( spr.FramePixels( frameIndex ), spr.frameStride, spr.vOpaqueBoxes[frameIndex], rect, params );
+}
+
+//********************************************************************************************************************************
+// Function:	SubmitRotated - draws a rotated sprite frame, or records it if a batch is being recorded
+// Parameters:	As DrawRotatedRect
+//********************************************************************************************************************************
+void PlayBlitter::SubmitRotated( const uint32_t* pSrcBase, int srcStride, const OpaqueBox& box, const RotatedRect& rect, const DrawParams& params ) const
+{
+	MarkDirty( { rect.startX, rect.startY, rect.endX, rect.endY } );
+
+	if( !m_batching )
+	{
+		DrawRotatedRect( pSrcBase, srcStride, box, rect, params, GetBufferRect() );
+		return;
+	}
+
+	DrawCommand command;
+	command.rotated = true;
+	command.params = params;
+	command.pSrc = pSrcBase;
+	command.srcStride = srcStride;
+	command.box = box;
+	command.rect = rect;
+	command.bounds = { rect.startX, rect.startY, rect.endX, rect.endY };
+	RecordDraw( command );
+}
+
+//********************************************************************************************************************************
+// Function:	DrawRotatedRect - draws a rotated sprite frame to part of the display buffer
+// Parameters:	pSrcBase = the top left pixel of the sprite frame
+//				srcStride = the number of pixels from one row of the frame to the next
+//				box = the opaque box of the frame
+//				rect = where it goes in the display buffer, from GetRotatedRect
+//				params = the alpha multiply and tint (the origin and flip are already in rect)
+//				clip = the part of the display buffer to draw to
+// Notes:		The sampling is worked out from the whole of rect, so the pixels drawn are the same however it is clipped
+//********************************************************************************************************************************
+void PlayBlitter::DrawRotatedRect( const uint32_t* pSrcBase, int srcStride, const OpaqueBox& box, const RotatedRect& rect, const DrawParams& params, const ClipRect& clip ) const
+{
 	uint32_t* pDstBase = m_displayBuffer;
+	const float alphaMultiply = params.alphaMultiply;
+	const bool tinted = ( params.tint & 0x00FFFFFF ) != 0x00FFFFFF;
+
+	// The kernels work in 16 bits per channel, which only has room for multipliers from 0 to 1
+	const SimdLevel simdLevel = alphaMultiply >= 0.0f && alphaMultiply <= 1.0f ? m_simdLevel : SIMD_NONE;
+	uint32_t rowPixels[ROTATE_CHUNK];
+
+	const int startY = std::max( rect.startY, clip.top );
+	const int endY = std::min( rect.endY, clip.bottom );
+	const int clipFirst = clip.left - rect.startX;
+	const int clipLast = clip.right - rect.startX;
+
+	for( int y = startY; y < endY; y++ )
+	{
+		int first, last;
+		int32_t u, v;
+		GetRotatedSpan( rect, box, y, first, last, u, v );
+
+		if( first < clipFirst )
+		{
+			u += rect.uStep * ( clipFirst - first );
+			v += rect.vStep * ( clipFirst - first );
+			first = clipFirst;
+		}
+		last = std::min( last, clipLast );
+
+		int32_t uStep = rect.uStep;
+		SampleU( rect, u, uStep );
+
+		uint32_t* destPixels = pDstBase + ( static_cast<size_t>( m_displayBufferWidth ) * y ) + rect.startX;
+
+		// The span is copied out of the sprite a chunk at a time, given new transparent runs, and blended like an unrotated row
+		for( int x = first; x < last; x += ROTATE_CHUNK )
+		{
+			const int count = std::min( ROTATE_CHUNK, last - x );
+			if( simdLevel == SIMD_AVX2 )
+				GatherRowAVX2( pSrcBase, srcStride, u, v, uStep, rect.vStep, count, rowPixels );
+			else
+				GatherRow( pSrcBase, srcStride, u, v, uStep, rect.vStep, count, rowPixels );
+
+			if( tinted )
+			{
+				switch( simdLevel )
+				{
+				case SIMD_AVX2: TintRowAVX2( rowPixels, rowPixels, count, params.tint ); break;
+				case SIMD_SSE2: TintRowSSE2( rowPixels, rowPixels, count, params.tint ); break;
+				default: TintRow( rowPixels, rowPixels, count, params.tint ); break;
+				}
+			}
+			MarkTransparentRuns( rowPixels, count );
+
+			switch( simdLevel )
+			{
+			case SIMD_AVX2: BlendRowAlphaAVX2( destPixels + x, rowPixels, count, alphaMultiply ); break;
+			case SIMD_SSE2: BlendRowAlphaSSE2( destPixels + x, rowPixels, count, alphaMultiply ); break;
+			default: BlendRowAlpha( destPixels + x, rowPixels, count, alphaMultiply ); break;
+			}
+			u += uStep * count;
+			v += rect.vStep * count;
+		}
+	}
+}
 
+//********************************************************************************************************************************
+// Function:	GetRotatedRect - works out which pixels a rotated and scaled sprite covers and how they sample the sprite
+// Parameters:	spr = the sprite
+//				originX, originY = the centre of rotation relative to the top left of the sprite
+//				flipX = whether the sprite is mirrored left to right about the centre of rotation
+//				xpos, ypos = the position of the center of rotation
+//				angle, scale = as RotateScaleSprite
+//				width, height = the size of the buffer it is drawn to, which the rectangle is clipped to
+//				rect = filled in with the result
+// Notes:		Rows and columns clipped off the top and left move the sampling to match. A flipped sprite is worked out
+//				in a mirrored frame, where the centre of rotation is as far from the right edge as it was from the left.
+//********************************************************************************************************************************
+void PlayBlitter::GetRotatedRect( const Sprite& spr, int originX, int originY, bool flipX, int xpos, int ypos, float angle, float scale, int width, int height, RotatedRect& rect )
+{
 	//the centre of rotation in the sprite frame relative to the top corner
-	float fRotCentreU = static_cast<float>( spr.originX );
-	float fRotCentreV = static_cast<float>( spr.originY );
+	float fRotCentreU = static_cast<float>( flipX ? spr.width - originX : originX );
+	float fRotCentreV = static_cast<float>( originY );
 
 	//u/v are co-ordinates in the rotated sprite frame. x/y are screen buffer co-ordinates.
 	//change in u/v for a unit change in x/y.
@@ -2961,84 +5043,516 @@ void PlayBlitter::RotateScaleSprite( int spriteId, int xpos, int ypos, int frame
 	}
 
 	//clip the starting and finishing positions.
-	int startY = ypos + static_cast<int>( minY );
-	if( startY < 0 ) { startY = 0; minY = static_cast<float>( -ypos ); }
+	rect.startY = ypos + static_cast<int>( minY );
+	if( rect.startY < 0 ) { rect.startY = 0; minY = static_cast<float>( -ypos ); }
 
-	int endY = ypos + static_cast<int>( maxY );
-	if( endY > m_displayBufferHeight ) { endY = m_displayBufferHeight; }
+	rect.endY = ypos + static_cast<int>( maxY );
+	if( rect.endY > height ) { rect.endY = height; }
 
-	int startX = xpos + static_cast<int>( minX );
-	if( startX < 0 ) { startX = 0; minX = static_cast<float>( -xpos ); }
+	rect.startX = xpos + static_cast<int>( minX );
+	if( rect.startX < 0 ) { rect.startX = 0; minX = static_cast<float>( -xpos ); }
 
-	int endX = xpos + static_cast<int>( maxX );
-	if( endX > m_displayBufferWidth ) { endX = m_displayBufferWidth; }
+	rect.endX = xpos + static_cast<int>( maxX );
+	if( rect.endX > width ) { rect.endX = width; }
 
 	//rotate the basis so we get the edge of the bounding box in the sprite frame.
-	float startingU = dUdX * minX + dUdY * minY + fRotCentreU;
-	float startingV = dVdY * minY + dVdX * minX + fRotCentreV;
+	rect.startU = dUdX * minX + dUdY * minY + fRotCentreU;
+	rect.startV = dVdY * minY + dVdX * minX + fRotCentreV;
+	rect.dUdY = dUdY;
+	rect.dVdY = dVdY;
+
+	// The sprite is sampled in 16.16 fixed point along the rows
+	rect.uStep = ToFixed( dUdX );
+	rect.vStep = ToFixed( dVdX );
+	rect.flipX = flipX;
+	rect.frameWidth = spr.width;
+}
+
+//********************************************************************************************************************************
+// Function:	GetRotatedSpan - works out which pixels of a row of a RotatedRect land in the opaque part of the sprite frame
+// Parameters:	rect = from GetRotatedRect
+//				box = the opaque box of the sprite frame
+//				y = the row in the buffer
+//				first, last = set to the span of pixels from rect.startX (last is exclusive), which may be empty
+//				u, v = set to the 16.16 position in the sprite frame of the first pixel (mirrored if it's flipped, see SampleU)
+// Notes:		Each row starts from its own position worked out from the top of the rectangle (rather than by adding up 
+//				the steps), so rounding errors can't build up down the sprite. u and v of exactly zero are outside the frame.
+//********************************************************************************************************************************
+void PlayBlitter::GetRotatedSpan( const RotatedRect& rect, const OpaqueBox& box, int y, int& first, int& last, int32_t& u, int32_t& v )
+{
+	const double rowOffset = y - rect.startY;
+	u = ToFixed( rect.startU + rect.dUdY * rowOffset );
+	v = ToFixed( rect.startV + rect.dVdY * rowOffset );
 
-	float rowU = startingU;
-	float rowV = startingV;
+	// The opaque box is mirrored too when the sprite is flipped
+	const int boxLeft = rect.flipX ? rect.frameWidth - box.right : box.left;
+	const int boxRight = rect.flipX ? rect.frameWidth - box.left : box.right;
 
-	uint32_t* destPixels = pDstBase + ( static_cast<size_t>( m_displayBufferWidth ) * startY ) + startX;
-	int nextRow = m_displayBufferWidth - ( endX - startX );
+	first = 0;
+	last = rect.endX - rect.startX;
+	ClipSpan( u, rect.uStep, std::max< int64_t >( static_cast<int64_t>( boxLeft ) << 16, 1 ), static_cast<int64_t>( boxRight ) << 16, first, last );
+	ClipSpan( v, rect.vStep, std::max< int64_t >( static_cast<int64_t>( box.top ) << 16, 1 ), static_cast<int64_t>( box.bottom ) << 16, first, last );
 
-	uint32_t* srcPixels = pSrcBase;
+	u += rect.uStep * first;
+	v += rect.vStep * first;
+}
 
-	//Start of double for loop. 
-	for( int y = startY; y < endY; y++ )
+//********************************************************************************************************************************
+// Function:	SampleU - turns a position and step along a row of a RotatedRect into ones in the sprite frame
+// Parameters:	rect = from GetRotatedRect
+//				u = the 16.16 position from GetRotatedSpan, which is changed to the one to sample
+//				uStep = rect.uStep, which is changed to the one to sample with
+// Notes:		A flipped sprite's pixel n in the mirrored frame is pixel width - 1 - n in the sprite, and the fraction is 
+//				reversed with it, so the 16.16 position is ( width << 16 ) - 1 - u
+//********************************************************************************************************************************
+void PlayBlitter::SampleU( const RotatedRect& rect, int32_t& u, int32_t& uStep )
+{
+	if( rect.flipX )
 	{
-		float u = rowU;
-		float v = rowV;
+		u = ( rect.frameWidth << 16 ) - 1 - u;
+		uStep = -uStep;
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	SetRotationCache - turns the cache of pre-rotated sprite frames on or off
+// Parameters:	angleSteps = the number of angles frames are rotated to, or 0 to turn the cache off
+//				budgetBytes = the most memory the rotated frames can use
+// Notes:		Changing the number of angles (or turning the cache off) frees all the rotated frames
+//********************************************************************************************************************************
+void PlayBlitter::SetRotationCache( int angleSteps, size_t budgetBytes )
+{
+	PB_ASSERT_MSG( angleSteps >= 0 && angleSteps <= 0x10000, "Too many rotation cache angles!" );
+	PB_ASSERT_MSG( !m_batching, "Trying to change the rotation cache during a batch!" );
+
+	if( angleSteps != m_rotationSteps )
+		ClearRotationCache();
+
+	m_rotationSteps = angleSteps;
+	m_rotationBudget = budgetBytes;
+	TrimRotationCache( m_rotationBudget );
+}
 
-		for( int x = startX; x < endX; x++ )
+//********************************************************************************************************************************
+// Function:	ClearRotationCache - frees all the pre-rotated sprite frames
+//********************************************************************************************************************************
+void PlayBlitter::ClearRotationCache()
+{
+	PB_ASSERT_MSG( !m_batching, "Trying to clear the rotation cache during a batch!" );
+	m_rotatedFrames.clear();
+	m_rotationLru.clear();
+	m_rotationStats.bytes = 0;
+}
+
+//********************************************************************************************************************************
+// Function:	ForgetRotatedFrames - frees the pre-rotated frames of one sprite
+// Parameters:	spriteId = the id of the sprite, whose pixels have changed
+//********************************************************************************************************************************
+void PlayBlitter::ForgetRotatedFrames( int spriteId )
+{
+	for( auto it = m_rotatedFrames.begin(); it != m_rotatedFrames.end(); )
+	{
+		if( static_cast<int>( it->first >> 33 ) == spriteId )
 		{
-			//Check to see if u and v correspond to a valid pixel in sprite.
-			if( u > 0 && v > 0 && u < spr.width && v < spr.height )
-			{
-				srcPixels = pSrcBase + static_cast<size_t>( u ) + ( static_cast<size_t>( v ) * spr.canvasWidth );
-				uint32_t src = *srcPixels;
+			m_rotationStats.bytes -= it->second.bytes;
+			m_rotationLru.erase( it->second.lru );
+			it = m_rotatedFrames.erase( it );
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
 
-				if( src < 0xFF000000 )
-				{
-					int srcAlpha = static_cast<int>( ( 0xFF - ( src >> 24 ) ) * alphaMultiply );
-					int constAlpha = static_cast<int>( 255 * alphaMultiply );
+//********************************************************************************************************************************
+// Function:	TrimRotationCache - frees the least recently drawn rotated frames until the cache uses no more than a limit
+// Parameters:	limit = the number of bytes the cache can keep using
+//********************************************************************************************************************************
+void PlayBlitter::TrimRotationCache( size_t limit ) const
+{
+	while( m_rotationStats.bytes > limit )
+	{
+		auto it = m_rotatedFrames.find( m_rotationLru.back() );
+		m_rotationStats.bytes -= it->second.bytes;
+		m_rotationStats.evictions++;
+		RetireRotatedFrame( it->second );
+		m_rotatedFrames.erase( it );
+		m_rotationLru.pop_back();
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	RetireRotatedFrame - lets go of a rotated frame which is about to be removed from the cache
+// Parameters:	frame = the frame, whose pixels are moved out if a batch is being recorded
+// Notes:		Moving the vectors keeps their memory where it is, so the draws recorded in the batch can still use it
+//********************************************************************************************************************************
+void PlayBlitter::RetireRotatedFrame( RotatedFrame& frame ) const
+{
+	if( m_batching )
+		m_vRetiredFrames.push_back( std::move( frame ) );
+}
+
+//********************************************************************************************************************************
+// Function:	GetRotatedFrame - gets a sprite frame pre-rotated to the nearest cached angle, making it if it isn't there
+// Parameters:	spriteId = the id of the sprite
+//				frameIndex = which frame of the animation (already wrapped)
+//				angle = the angle it's being drawn at
+//				originX, originY = the centre of rotation it's being drawn with
+//				flipX = whether it's being drawn mirrored (which is kept as a separate frame)
+// Returns:		The rotated frame, or nullptr if it's too big for the budget
+// Notes:		The frame is sampled exactly as RotateScaleSprite samples it (when it isn't clipped), at the rounded angle
+//********************************************************************************************************************************
+const PlayBlitter::RotatedFrame* PlayBlitter::GetRotatedFrame( int spriteId, int frameIndex, float angle, int originX, int originY, bool flipX ) const
+{
+	const Sprite& spr = vSpriteData[spriteId];
 
-					// Source pixels are already multiplied by srcAlpha so we just apply the constant alpha multiplier
-					int destRed = constAlpha * ( ( src >> 16 ) & 0xFF );
-					int destGreen = constAlpha * ( ( src >> 8 ) & 0xFF );
-					int destBlue = constAlpha * ( src & 0xFF );
+	int angleStep = static_cast<int>( floor( angle * ( m_rotationSteps / ( 2.0f * PLAY_PI ) ) + 0.5f ) ) % m_rotationSteps;
+	if( angleStep < 0 )
+		angleStep += m_rotationSteps;
 
-					uint32_t dest = *destPixels;
-					int invSrcAlpha = 0xFF - srcAlpha;
+	uint64_t key = ( static_cast<uint64_t>( spriteId ) << 33 ) | ( static_cast<uint64_t>( flipX ) << 32 ) | ( static_cast<uint64_t>( frameIndex ) << 16 ) | static_cast<uint64_t>( angleStep );
+	auto it = m_rotatedFrames.find( key );
 
-					// Apply a standard Alpha blend [ src*srcAlpha + dest*(1-SrcAlpha) ]
-					destRed += invSrcAlpha * ( ( dest >> 16 ) & 0xFF );
-					destGreen += invSrcAlpha * ( ( dest >> 8 ) & 0xFF );
-					destBlue += invSrcAlpha * ( dest & 0xFF );
+	if( it != m_rotatedFrames.end() )
+	{
+		if( it->second.originX == originX && it->second.originY == originY )
+		{
+			m_rotationStats.hits++;
+			m_rotationLru.splice( m_rotationLru.begin(), m_rotationLru, it->second.lru );
+			return &it->second;
+		}
 
-					// Bring back to the range 0-255
-					destRed >>= 8;
-					destGreen >>= 8;
-					destBlue >>= 8;
+		// Made for an old origin
+		m_rotationStats.bytes -= it->second.bytes;
+		m_rotationLru.erase( it->second.lru );
+		RetireRotatedFrame( it->second );
+		m_rotatedFrames.erase( it );
+	}
 
-					// Put ARGB components back together again
-					*destPixels = 0xFF000000 | ( destRed << 16 ) | ( destGreen << 8 ) | destBlue;
-				}
-			}
+	m_rotationStats.misses++;
+
+	// Drawn well away from the edges of an imaginary buffer, so nothing is clipped
+	const int centre = 0x10000;
+	RotatedRect rect;
+	GetRotatedRect( spr, originX, originY, flipX, centre, centre, angleStep * ( 2.0f * PLAY_PI / m_rotationSteps ), 1.0f, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), rect );
+
+	const int width = std::max( 0, rect.endX - rect.startX );
+	const int height = std::max( 0, rect.endY - rect.startY );
+	// The spans aren't known until the frame is made, so they're added to its size afterwards
+	const size_t bytes = sizeof( RotatedFrame ) + static_cast<size_t>( width ) * height * sizeof( uint32_t ) + ( height + 1 ) * sizeof( uint32_t );
+	if( bytes > m_rotationBudget )
+		return nullptr;
+
+	TrimRotationCache( m_rotationBudget - bytes );
+	m_rotationStats.bytes += bytes;
+	m_rotationLru.push_front( key );
+
+	RotatedFrame& frame = m_rotatedFrames[key];
+	frame.lru = m_rotationLru.begin();
+	frame.originX = originX;
+	frame.originY = originY;
+	frame.left = rect.startX - centre;
+	frame.top = rect.startY - centre;
+	frame.width = width;
+	frame.height = height;
+	frame.bytes = bytes;
+	frame.pixels.assign( static_cast<size_t>( width ) * height, 0xFF000000 );
+	frame.rowStarts.resize( height + 1 );
+
+	const uint32_t* pSrcBase = spr.FramePixels( frameIndex );
+	const OpaqueBox& box = spr.vOpaqueBoxes[frameIndex];
+
+	for( int row = 0; row < height; row++ )
+	{
+		int first, last;
+		int32_t u, v;
+		GetRotatedSpan( rect, box, rect.startY + row, first, last, u, v );
 
-			destPixels++;
+		int32_t uStep = rect.uStep;
+		SampleU( rect, u, uStep );
 
-			//change the position in the sprite frame for changing X in the display
-			u += dUdX;
-			v += dVdX;
+		uint32_t* pRow = frame.pixels.data() + static_cast<size_t>( width ) * row;
+		if( first < last )
+			GatherRow( pSrcBase, spr.frameStride, u, v, uStep, rect.vStep, last - first, pRow + first );
+		MarkTransparentRuns( pRow, width );
+
+		frame.rowStarts[row] = static_cast<uint32_t>( frame.spans.size() );
+		if( first < last )
+			EncodeSpans( pRow, width, frame.spans );
+	}
+	frame.rowStarts[height] = static_cast<uint32_t>( frame.spans.size() );
+
+	frame.bytes += frame.spans.size() * sizeof( PixelSpan );
+	m_rotationStats.bytes += frame.spans.size() * sizeof( PixelSpan );
+
+	// The spans can take the cache over the budget, so older frames are freed to make room, unless the frame doesn't fit 
+	// on its own (in which case it's drawn directly, as if it had been too big to begin with)
+	if( frame.bytes > m_rotationBudget )
+	{
+		m_rotationStats.bytes -= frame.bytes;
+		m_rotationLru.pop_front();
+		m_rotatedFrames.erase( key );
+		return nullptr;
+	}
+	TrimRotationCache( m_rotationBudget );
+	return &frame;
+}
+
+//********************************************************************************************************************************
+// Function:	BeginBatch - starts recording sprite draws instead of making them
+//********************************************************************************************************************************
+void PlayBlitter::BeginBatch()
+{
+	PB_ASSERT_MSG( !m_batching, "Trying to begin a batch during a batch!" );
+	m_batching = true;
+}
+
+//********************************************************************************************************************************
+// Function:	EndBatch - makes all the draws recorded since BeginBatch
+// Notes:		The draws are binned by the bands they touch, keeping them in order, and then the bands are shared out between 
+//				the calling thread and the draw threads. Bands don't overlap, so no two threads write the same pixel.
+//********************************************************************************************************************************
+void PlayBlitter::EndBatch()
+{
+	PB_ASSERT_MSG( m_batching, "Trying to end a batch which hasn't begun!" );
+	m_batching = false;
+
+	m_vBandCommands.resize( ( m_displayBufferHeight + BAND_HEIGHT - 1 ) / BAND_HEIGHT );
+	for( std::vector< int >& vCommands : m_vBandCommands )
+		vCommands.clear();
+
+	for( int n = 0; n < static_cast<int>( m_vDrawCommands.size() ); n++ )
+	{
+		const ClipRect& bounds = m_vDrawCommands[n].bounds;
+		for( int band = bounds.top / BAND_HEIGHT; band <= ( bounds.bottom - 1 ) / BAND_HEIGHT; band++ )
+			m_vBandCommands[band].push_back( n );
+	}
+
+	if( m_vDrawWorkers.empty() )
+	{
+		for( int band = 0; band < static_cast<int>( m_vBandCommands.size() ); band++ )
+			DrawBand( band );
+	}
+	else
+	{
+		{
+			std::lock_guard< std::mutex > lock( m_drawMutex );
+			m_nextBand = 0;
+			m_drawBusy = static_cast<int>( m_vDrawWorkers.size() );
+			m_drawGeneration++;
 		}
+		m_drawStart.notify_all();
+
+		DrawBands();
+
+		std::unique_lock< std::mutex > lock( m_drawMutex );
+		m_drawDone.wait( lock, [this]() { return m_drawBusy == 0; } );
+	}
+
+	m_vDrawCommands.clear();
+	m_vRetiredFrames.clear();
+	TrimRotationCache( m_rotationBudget );
+}
+
+//********************************************************************************************************************************
+// Function:	RecordDraw - adds a draw to the batch
+// Parameters:	command = the draw, with its bounds set to where it would draw on an unlimited display buffer
+//********************************************************************************************************************************
+void PlayBlitter::RecordDraw( DrawCommand command ) const
+{
+	ClipRect& bounds = command.bounds;
+	bounds.left = std::max( bounds.left, 0 );
+	bounds.top = std::max( bounds.top, 0 );
+	bounds.right = std::min( bounds.right, m_displayBufferWidth );
+	bounds.bottom = std::min( bounds.bottom, m_displayBufferHeight );
+
+	if( bounds.left < bounds.right && bounds.top < bounds.bottom )
+		m_vDrawCommands.push_back( command );
+}
+
+//********************************************************************************************************************************
+// Function:	DrawBand - makes the recorded draws which touch a band, in order
+// Parameters:	band = the index of the band, from the top
+//********************************************************************************************************************************
+void PlayBlitter::DrawBand( int band ) const
+{
+	const int top = band * BAND_HEIGHT;
+	const ClipRect clip{ 0, top, m_displayBufferWidth, std::min( top + BAND_HEIGHT, m_displayBufferHeight ) };
+
+	for( int n : m_vBandCommands[band] )
+	{
+		const DrawCommand& command = m_vDrawCommands[n];
+		if( command.rotated )
+			DrawRotatedRect( command.pSrc, command.srcStride, command.box, command.rect, command.params, clip );
+		else
+			BlitPixels( command.pSrc, command.srcStride, command.spans, command.width, command.height, command.left, command.top, command.params, clip );
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	DrawBands - draws the next band nobody has started on, until there are none left
+//********************************************************************************************************************************
+void PlayBlitter::DrawBands()
+{
+	const int bandCount = static_cast<int>( m_vBandCommands.size() );
+	for( int band = m_nextBand++; band < bandCount; band = m_nextBand++ )
+		DrawBand( band );
+}
+
+//********************************************************************************************************************************
+// Function:	DrawWorker - what each draw thread runs until StopDrawWorkers
+// Parameters:	generation = the value of m_drawGeneration when the thread was made
+//********************************************************************************************************************************
+void PlayBlitter::DrawWorker( int generation )
+{
+	std::unique_lock< std::mutex > lock( m_drawMutex );
+	while( true )
+	{
+		m_drawStart.wait( lock, [this, generation]() { return m_stopDrawWorkers || m_drawGeneration != generation; } );
+		if( m_stopDrawWorkers )
+			return;
+
+		generation = m_drawGeneration;
+		lock.unlock();
+		DrawBands();
+		lock.lock();
+
+		if( --m_drawBusy == 0 )
+			m_drawDone.notify_one();
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	SetDrawThreads - sets how many threads EndBatch shares the bands between
+// Parameters:	threads = the number of threads, including the one calling EndBatch
+//********************************************************************************************************************************
+void PlayBlitter::SetDrawThreads( int threads )
+{
+	PB_ASSERT_MSG( !m_batching, "Trying to change the draw threads during a batch!" );
+
+	StopDrawWorkers();
+	m_stopDrawWorkers = false;
+
+	for( int n = 1; n < threads; n++ )
+		m_vDrawWorkers.emplace_back( &PlayBlitter::DrawWorker, this, m_drawGeneration );
+}
+
+//********************************************************************************************************************************
+// Function:	StopDrawWorkers - tells the draw threads to finish and waits for them
+//********************************************************************************************************************************
+void PlayBlitter::StopDrawWorkers()
+{
+	{
+		std::lock_guard< std::mutex > lock( m_drawMutex );
+		m_stopDrawWorkers = true;
+	}
+	m_drawStart.notify_all();
+
+	for( std::thread& worker : m_vDrawWorkers )
+		worker.join();
+	m_vDrawWorkers.clear();
+}
+
+//********************************************************************************************************************************
+// Function:	ClipSpan - narrows a span of pixels to the ones where a stepped 16.16 coordinate is within a range
+// Parameters:	start = the coordinate at the first pixel (pixel 0)
+//				step = the change in the coordinate from one pixel to the next
+//				low, high = the range in 16.16 fixed point, which includes low but not high
+//				first, last = the span (last is exclusive), which is narrowed to where low <= start + step * pixel < high
+// Notes:		Uses exact integer division, so it agrees with stepping the coordinate pixel by pixel. This is the 
+//				intersection of a display row with one pair of edges of the rotated rectangle.
+//********************************************************************************************************************************
+void PlayBlitter::ClipSpan( int64_t start, int64_t step, int64_t low, int64_t high, int& first, int& last )
+{
+	// Rounds towards minus infinity (for a positive divisor)
+	auto floorDiv = []( int64_t a, int64_t b ) { return a >= 0 ? a / b : -( ( -a + b - 1 ) / b ); };
+
+	int64_t lowest, highest;
+	if( step > 0 )
+	{
+		lowest = -floorDiv( start - low, step );
+		highest = -floorDiv( start - high, step );
+	}
+	else if( step < 0 )
+	{
+		lowest = floorDiv( start - high, -step ) + 1;
+		highest = floorDiv( start - low, -step ) + 1;
+	}
+	else
+	{
+		lowest = 0;
+		highest = ( start >= low && start < high ) ? last : 0;
+	}
+
+	first = static_cast<int>( std::max< int64_t >( first, lowest ) );
+	last = static_cast<int>( std::min< int64_t >( last, highest ) );
+}
+
+//********************************************************************************************************************************
+// Function:	GatherRow - copies the pixels along a line through a sprite frame into a row, one pixel at a time
+// Parameters:	pSrc = the top left of the sprite frame
+//				srcStride = the number of pixels from one row of the frame to the next
+//				u, v = the 16.16 position in the frame of the first pixel
+//				uStep, vStep = the change in u and v from one pixel to the next
+//				count = the number of pixels to copy
+//				pDest = where to put them
+// Notes:		The transparent run lengths are for the unrotated rows, so they need redoing with MarkTransparentRuns
+//********************************************************************************************************************************
+void PlayBlitter::GatherRow( const uint32_t* pSrc, int srcStride, int32_t u, int32_t v, int32_t uStep, int32_t vStep, int count, uint32_t* pDest )
+{
+	for( int n = 0; n < count; n++ )
+	{
+		pDest[n] = pSrc[( u >> 16 ) + ( v >> 16 ) * srcStride];
+		u += uStep;
+		v += vStep;
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	GatherRowAVX2 - copies the pixels along a line through a sprite frame into a row, eight pixels at a time
+// Parameters:	As GatherRow
+// Notes:		Uses the AVX2 gather instruction. Only called when the CPU supports AVX2.
+//********************************************************************************************************************************
+PLAY_TARGET_AVX2 void PlayBlitter::GatherRowAVX2( const uint32_t* pSrc, int srcStride, int32_t u, int32_t v, int32_t uStep, int32_t vStep, int count, uint32_t* pDest )
+{
+	const __m256i lanes = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	const __m256i width = _mm256_set1_epi32( srcStride );
+	const __m256i uStep8 = _mm256_set1_epi32( uStep * 8 );
+	const __m256i vStep8 = _mm256_set1_epi32( vStep * 8 );
+	__m256i us = _mm256_add_epi32( _mm256_set1_epi32( u ), _mm256_mullo_epi32( lanes, _mm256_set1_epi32( uStep ) ) );
+	__m256i vs = _mm256_add_epi32( _mm256_set1_epi32( v ), _mm256_mullo_epi32( lanes, _mm256_set1_epi32( vStep ) ) );
+
+	int n = 0;
+	for( ; n + 8 <= count; n += 8 )
+	{
+		__m256i index = _mm256_add_epi32( _mm256_srai_epi32( us, 16 ), _mm256_mullo_epi32( _mm256_srai_epi32( vs, 16 ), width ) );
+		__m256i src = _mm256_i32gather_epi32( reinterpret_cast<const int*>( pSrc ), index, 4 );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( pDest + n ), src );
+		us = _mm256_add_epi32( us, uStep8 );
+		vs = _mm256_add_epi32( vs, vStep8 );
+	}
+
+	_mm256_zeroupper();
+	GatherRow( pSrc, srcStride, u + uStep * n, v + vStep * n, uStep, vStep, count - n, pDest + n );
+}
 
-		//work out the change in the sprite frame for changing Y in the display
-		rowU += dUdY;
-		rowV += dVdY;
-		//next row
-		destPixels += nextRow;
+//********************************************************************************************************************************
+// Function:	MarkTransparentRuns - sets the run length in each transparent pixel of a row
+// Parameters:	pPixels = the row of pre-multiplied pixels
+//				count = the number of pixels in the row
+// Notes:		A transparent pixel holds the number of transparent pixels straight after it (the same as in 
+//				PreMultiplyAlpha), which the blend kernels use to skip over them
+//********************************************************************************************************************************
+void PlayBlitter::MarkTransparentRuns( uint32_t* pPixels, int count )
+{
+	uint32_t run = 0;
+	for( int n = count - 1; n >= 0; n-- )
+	{
+		if( pPixels[n] >= 0xFF000000 )
+			pPixels[n] = 0xFF000000 | run++;
+		else
+			run = 0;
 	}
 }
 
@@ -3046,54 +5560,61 @@ void PlayBlitter::RotateScaleSprite( int spriteId, int xpos, int ypos, int frame
 // Function:	PreMultiplyAlpha - calculates the (src*srcAlpha) alpha blending calculation in advance as it doesn't change
 // Parameters:	s = the sprite to precalculate data for
 // Notes:		Also inverts the alpha ready for the (dest*(1-srcAlpha)) calculation and stores information in the new
-//				buffer which provides the number of fully-transparent pixels in a row (so they can be skipped)
+//				buffer which provides the number of fully-transparent pixels in a row (so they can be skipped).
+//				Each frame is copied out of the canvas to its own block of pPreMultAlpha (see Sprite::FramePixels).
 //********************************************************************************************************************************
-void PlayBlitter::PreMultiplyAlpha( uint32_t* source, uint32_t* dest, int width, int height, int maxSkipWidth, float alphaMultiply = 1.0f, uint32_t colourMultiply = 0x00FFFFFF )
+void PlayBlitter::PreMultiplyAlpha( Sprite& s, float alphaMultiply = 1.0f, uint32_t colourMultiply = 0x00FFFFFF )
 {
-	uint32_t* pSourcePixels = source;
-	uint32_t* pDestPixels = dest;
-
-	// Iterate through all the pixels in the entire canvas
-	for( int bh = 0; bh < height; bh++ )
+	// Iterate through all the pixels in each frame of the canvas
+	for( int frame = 0; frame < s.totalCount; frame++ )
 	{
-		for( int bw = 0; bw < width; bw++ )
-		{
-			uint32_t src = *pSourcePixels;
+		const uint32_t* pFrameSource = s.pCanvasBuffer + ( frame % s.hCount ) * s.width + static_cast<size_t>( s.canvasWidth ) * ( ( frame / s.hCount ) * s.height );
+		uint32_t* pFrameDest = s.pPreMultAlpha + static_cast<size_t>( s.frameStride ) * s.height * frame;
 
-			// Separate the channels and calculate src*srcAlpha
-			int srcAlpha = static_cast<int>( ( src >> 24 ) * alphaMultiply );
+		for( int bh = 0; bh < s.height; bh++ )
+		{
+			const uint32_t* pSourcePixels = pFrameSource + static_cast<size_t>( s.canvasWidth ) * bh;
+			uint32_t* pDestPixels = pFrameDest + static_cast<size_t>( s.frameStride ) * bh;
 
-			int destRed = ( srcAlpha * ( ( src >> 16 ) & 0xFF ) ) >> 8;
-			int destGreen = ( srcAlpha * ( ( src >> 8 ) & 0xFF ) ) >> 8;
-			int destBlue = ( srcAlpha * ( src & 0xFF ) ) >> 8;
+			for( int bw = 0; bw < s.width; bw++ )
+			{
+				uint32_t src = *pSourcePixels;
 
-			destRed = ( destRed * ( ( colourMultiply >> 16 ) & 0xFF ) ) >> 8;
-			destGreen = ( destGreen * ( ( colourMultiply >> 8 ) & 0xFF ) ) >> 8;
-			destBlue = ( destBlue * ( colourMultiply & 0xFF ) ) >> 8;
+				// Separate the channels and calculate src*srcAlpha
+				int srcAlpha = static_cast<int>( ( src >> 24 ) * alphaMultiply );
 
-			srcAlpha = 0xFF - srcAlpha; // invert the alpha ready to multiply with the destination pixels
-			*pDestPixels = ( srcAlpha << 24 ) | ( destRed << 16 ) | ( destGreen << 8 ) | destBlue;
+				int destRed = ( srcAlpha * ( ( src >> 16 ) & 0xFF ) ) >> 8;
+				int destGreen = ( srcAlpha * ( ( src >> 8 ) & 0xFF ) ) >> 8;
+				int destBlue = ( srcAlpha * ( src & 0xFF ) ) >> 8;
 
-			if( srcAlpha == 0xFF ) // Completely transparent pixel
-			{
-				int repeats = 0;
+				destRed = ( destRed * ( ( colourMultiply >> 16 ) & 0xFF ) ) >> 8;
+				destGreen = ( destGreen * ( ( colourMultiply >> 8 ) & 0xFF ) ) >> 8;
+				destBlue = ( destBlue * ( colourMultiply & 0xFF ) ) >> 8;
 
-				// We can only skip to the end of the row because the sprite frames are arranged on a continuous canvas
-				int maxSkip = maxSkipWidth - ( bw % maxSkipWidth );
+				srcAlpha = 0xFF - srcAlpha; // invert the alpha ready to multiply with the destination pixels
+				*pDestPixels = ( srcAlpha << 24 ) | ( destRed << 16 ) | ( destGreen << 8 ) | destBlue;
 
-				for( int zw = 1; zw < maxSkip; zw++ )
+				if( srcAlpha == 0xFF ) // Completely transparent pixel
 				{
-					if( *( pSourcePixels + zw ) >> 24 == 0x00 ) // Another transparent pixel
-						repeats++;
-					else
-						break;
+					int repeats = 0;
+
+					// We can only skip to the end of the frame's row, as the padding after it isn't drawn
+					int maxSkip = s.width - bw;
+
+					for( int zw = 1; zw < maxSkip; zw++ )
+					{
+						if( *( pSourcePixels + zw ) >> 24 == 0x00 ) // Another transparent pixel
+							repeats++;
+						else
+							break;
+					}
+
+					*pDestPixels = 0xFF000000 | repeats; // Doesn't matter what the colour was so we use it to store the skip value
 				}
 
-				*pDestPixels = 0xFF000000 | repeats; // Doesn't matter what the colour was so we use it to store the skip value
+				pDestPixels++;
+				pSourcePixels++;
 			}
-
-			pDestPixels++;
-			pSourcePixels++;
 		}
 	}
 }
@@ -3437,7 +5958,7 @@ namespace Play
 
 	int GetSpriteId( const char* spriteName )
 	{
-		return PlayBlitter::Instance().GetSpriteId( spriteName );
+		return PlayBlitter::Instance().FindSpriteId( spriteName );
 	}
 
 	int GetSpriteHeight( const char* spriteName )
@@ -3457,21 +5978,21 @@ namespace Play
 
 	void ColourSprite( const char* spriteName, Colour c )
 	{
-		int spriteId = PlayBlitter::Instance().GetSpriteId( spriteName );
+		int spriteId = PlayBlitter::Instance().FindSpriteId( spriteName );
 		PlayBlitter::Instance().ColourSprite( spriteId, static_cast<int>( c.red * 2.55f ), static_cast<int>( c.green * 2.55f), static_cast<int>( c.blue * 2.55f ) );
 	}
 
 	void CentreSpriteOrigin( const char* spriteName )
 	{
 		PlayBlitter& pblt = PlayBlitter::Instance();
-		int spriteId = pblt.GetSpriteId( spriteName );
+		int spriteId = pblt.FindSpriteId( spriteName );
 		pblt.SetSpriteOrigin( spriteId, pblt.GetSpriteSize( spriteId ) / 2, false );
 	}
 
 	void CentreMatchingSpriteOrigins( const char* rootName )
 	{
 		PlayBlitter& pblt = PlayBlitter::Instance();
-		int spriteId = pblt.GetSpriteId( rootName ); // Finds the first matching sprite and assumes same dimensions
+		int spriteId = pblt.FindSpriteId( rootName ); // Finds the first matching sprite and assumes same dimensions
 		pblt.SetSpriteOrigins( rootName, pblt.GetSpriteSize( spriteId ) / 2, false );
 	}
 
@@ -3486,7 +6007,7 @@ namespace Play
 	void MoveSpriteOrigin( const char* spriteName, int xoffset, int yoffset )
 	{
 		PlayBlitter& pblt = PlayBlitter::Instance();
-		int spriteId = pblt.GetSpriteId( spriteName );
+		int spriteId = pblt.FindSpriteId( spriteName );
 		pblt.SetSpriteOrigin( spriteId, { xoffset, yoffset }, true ); // relative option set
 	}
 
@@ -3506,7 +6027,7 @@ namespace Play
 
 	void DrawSprite( const char* spriteName, Point2D pos, int frameIndex )
 	{
-		PlayBlitter::Instance().Draw( PlayBlitter::Instance().GetSpriteId( spriteName ), pos, frameIndex );
+		PlayBlitter::Instance().Draw( PlayBlitter::Instance().FindSpriteId( spriteName ), pos, frameIndex );
 	}
 
 	void DrawSprite( int spriteID, Point2D pos, int frameIndex )
@@ -3516,7 +6037,7 @@ namespace Play
 
 	void DrawSpriteTransparent( const char* spriteName, Point2D pos, int frameIndex, float opacity )
 	{
-		PlayBlitter::Instance().DrawTransparent( PlayBlitter::Instance().GetSpriteId( spriteName ), pos, frameIndex, opacity );
+		PlayBlitter::Instance().DrawTransparent( PlayBlitter::Instance().FindSpriteId( spriteName ), pos, frameIndex, opacity );
 	}
 
 	void DrawSpriteTransparent( int spriteID, Point2D pos, int frameIndex, float opacity )
@@ -3526,7 +6047,7 @@ namespace Play
 
 	void DrawSpriteRotated( const char* spriteName, Point2D pos, int frameIndex, float angle, float scale, float opacity )
 	{
-		PlayBlitter::Instance().DrawRotated( PlayBlitter::Instance().GetSpriteId( spriteName ), pos, frameIndex, angle, scale, opacity );
+		PlayBlitter::Instance().DrawRotated( PlayBlitter::Instance().FindSpriteId( spriteName ), pos, frameIndex, angle, scale, opacity );
 	}
 
 	void DrawSpriteRotated( int spriteID, Point2D pos, int frameIndex, float angle, float scale, float opacity )
@@ -3544,10 +6065,19 @@ namespace Play
 		PlayBuffer::Instance().DrawCircle( pos, radius, { c.red * 2.55f, c.green * 2.55f, c.blue * 2.55f } );
 	}
 
+	// The draw parameters which tint a sprite with a colour, without changing the sprite as ColourSprite does
+	PlayBlitter::DrawParams TintParams( Colour c )
+	{
+		PlayBlitter::DrawParams params;
+		params.tint = ( ( static_cast<int>( c.red * 2.55f ) & 0xFF ) << 16 ) | ( ( static_cast<int>( c.green * 2.55f ) & 0xFF ) << 8 ) | ( static_cast<int>( c.blue * 2.55f ) & 0xFF );
+		return params;
+	}
+
 	void DrawSpriteLine( Point2f startPos, Point2f endPos, const char* penSprite, Colour c )
 	{
-		int spriteId = PlayBlitter::Instance().GetSpriteId( penSprite );
-		ColourSprite( penSprite, c );
+		PlayBlitter& pblt = PlayBlitter::Instance();
+		int spriteId = pblt.FindSpriteId( penSprite );
+		const PlayBlitter::DrawParams params = TintParams( c );
 
 		//Draws a line in any angle
 		int x1 = static_cast<int>( startPos.x );
@@ -3570,7 +6100,7 @@ namespace Play
 
 		while( true )
 		{
-			Play::DrawSprite( spriteId, { x1, y1 }, 0 );
+			pblt.Draw( spriteId, Point2D( x1, y1 ), 0, params );
 			
 			if( x1 == x2 && y1 == y2 )
 				break;
@@ -3589,27 +6119,29 @@ namespace Play
 		}
 	}
 
-	void DrawCircleOctants( int spriteId, int x, int y, int ox, int oy )
+	void DrawCircleOctants( int spriteId, int x, int y, int ox, int oy, const PlayBlitter::DrawParams& params )
 	{
+		PlayBlitter& pblt = PlayBlitter::Instance();
+
 		//displaying all 8 coordinates of(x,y) residing in 8-octants
-		Play::DrawSprite( spriteId, { x + ox, y + oy }, 0 );
-		Play::DrawSprite( spriteId, { x - ox, y + oy }, 0 );
-		Play::DrawSprite( spriteId, { x + ox, y - oy }, 0 );
-		Play::DrawSprite( spriteId, { x - ox, y - oy }, 0 );
-		Play::DrawSprite( spriteId, { x + oy, y + ox }, 0 );
-		Play::DrawSprite( spriteId, { x - oy, y + ox }, 0 );
-		Play::DrawSprite( spriteId, { x + oy, y - ox }, 0 );
-		Play::DrawSprite( spriteId, { x - oy, y - ox }, 0 );
+		pblt.Draw( spriteId, Point2D( x + ox, y + oy ), 0, params );
+		pblt.Draw( spriteId, Point2D( x - ox, y + oy ), 0, params );
+		pblt.Draw( spriteId, Point2D( x + ox, y - oy ), 0, params );
+		pblt.Draw( spriteId, Point2D( x - ox, y - oy ), 0, params );
+		pblt.Draw( spriteId, Point2D( x + oy, y + ox ), 0, params );
+		pblt.Draw( spriteId, Point2D( x - oy, y + ox ), 0, params );
+		pblt.Draw( spriteId, Point2D( x + oy, y - ox ), 0, params );
+		pblt.Draw( spriteId, Point2D( x - oy, y - ox ), 0, params );
 	}
 
 	void DrawSpriteCircle( int x, int y, int radius, const char* penSprite, Colour c )
 	{
-		int spriteId = PlayBlitter::Instance().GetSpriteId( penSprite );
-		ColourSprite( penSprite, c );
+		int spriteId = PlayBlitter::Instance().FindSpriteId( penSprite );
+		const PlayBlitter::DrawParams params = TintParams( c );
 
 		int ox = 0, oy = radius;
 		int d = 3 - 2 * radius;
-		DrawCircleOctants( spriteId, x, y, ox, oy );
+		DrawCircleOctants( spriteId, x, y, ox, oy, params );
 
 		while( oy >= ox )
 		{
@@ -3623,13 +6155,13 @@ namespace Play
 			{
 				d = d + 4 * ox + 6;
 			}
-			DrawCircleOctants( spriteId, x, y, ox, oy );
+			DrawCircleOctants( spriteId, x, y, ox, oy, params );
 		}
 	};
 
 	void DrawFontText( const char* fontId, std::string text, Point2D pos, Align justify )
 	{
-		int font = PlayBlitter::Instance().GetSpriteId( fontId );
+		int font = PlayBlitter::Instance().FindSpriteId( fontId );
 
 		int totalWidth{ 0 };
 		for( char c : text )
@@ -3656,7 +6188,7 @@ namespace Play
 
 	int CreateGameObject( int type, Point2f newPos, int collisionRadius, const char* spriteName )
 	{
-		int spriteId = PlayBlitter::Instance().GetSpriteId( spriteName );
+		int spriteId = PlayBlitter::Instance().FindSpriteId( spriteName );
 		// Deletion is handled in DestroyGameObject()
 		GameObject* pObj = new GameObject( type, newPos, collisionRadius, spriteId );
 		int id = pObj->GetId();
@@ -3837,7 +6369,7 @@ namespace Play
 
 	void SetSprite( GameObject& obj, const char* spriteName, float animSpeed )
 	{
-		int newSprite = PlayBlitter::Instance().GetSpriteId( spriteName );
+		int newSprite = PlayBlitter::Instance().FindSpriteId( spriteName );
 		// Only reset the animation back to the start when it is new
 		if( newSprite != obj.spriteId )
 			obj.frame = 0;
@@ -5,6 +5,10 @@
 #include "Gem.h"
 #include "Particle.h"
 #include "Player.h"
+#include "Collision.h"
+
+// Reused every tick so they don't allocate
+static std::vector< CollisionGrid::Contact > s_vContacts;
 
 Point2f Player::CalcOffset(float angle)
 {
@@ -22,26 +26,20 @@ Vector2f Player::CalcVelocity(float angle)
 
 void Player::Spawn(GameState& state)
 {
-	if (!GameObject::s_vUpdateList.size() == 0)
+	if (GameObject::GetObjectCount(OBJ_ALL) != 0)
 	{
-		std::vector<GameObject*> asteroidList = GameObject::GetTypeList(OBJ_ASTEROID);
-		if (GameObject::GetTypeList(OBJ_ASTEROID).size() != 0)
+		for (Asteroid* a : GameObject::GetTypeView<Asteroid>())
 		{
-			for (GameObject* g : asteroidList)
+			if (a->GetActive())
 			{
-				Asteroid* a = dynamic_cast<Asteroid*>(g);
-
-				if (a != nullptr && a->GetActive())
+				//Player constructor
+				if (GameObject::GetObjectCount(GameObject::OBJ_PLAYER) < 1)
 				{
-					//Player constructor
-					if (GameObject::GetObjectCount(GameObject::OBJ_PLAYER) < 1)
-					{
-						Point2f pos = a->GetPosition();
-						Vector2f currentVel = a->GetVelocity();
-						// Construct player
-						GameObject* p = new Player(pos, a);
-						p->SetVelocity(currentVel);
-					}
+					Point2f pos = a->GetPosition();
+					Vector2f currentVel = a->GetVelocity();
+					// Construct player
+					GameObject* p = new Player(pos, a);
+					p->SetVelocity(currentVel);
 				}
 			}
 		}
@@ -50,6 +48,7 @@ void Player::Spawn(GameState& state)
 
 void Player::Update(GameState& state)
 {
+	m_flewThisTick = false;
 	//Switch
 	switch (GetPlayerState())
 	{
@@ -76,6 +75,8 @@ void Player::FlyingUpdate(GameState& state)
 	//Flies in direction they are facing
 	// Slight control of trajectory using left and right arrow keys
 
+	// Collisions are found along the whole move by the collision stage, and handled in HandleContacts
+	m_flewThisTick = true;
 	SetPosition(GetPosition() + GetVelocity());
 	float angle = GetRotation();
 	if (PlayBuffer::Instance().KeyDown(VK_LEFT))
@@ -109,118 +110,125 @@ void Player::FlyingUpdate(GameState& state)
 		SetPlayerState(STATE_DEAD);
 	}
 
-	if (!GameObject::s_vUpdateList.size() == 0)
+	if (GetHasTimerRun() == true && std::chrono::steady_clock::now() > endTime)
+	{
+		SetHasTimerRun(false);
+		SetPlayerState(STATE_FLYING);
+	}
+}
+
+// The player is always pA in its contacts, as it has the lowest type
+void Player::HandleContacts(GameState& state)
+{
+	if (!m_flewThisTick)
+	{
+		return;
+	}
+
+	// if collides with meteor, state changes to dead
+	bool hitMeteor = false;
+	CollisionGrid::GetContacts(CollisionGrid::PairBit(OBJ_PLAYER, OBJ_METEOR), s_vContacts);
+	for (const CollisionGrid::Contact& contact : s_vContacts)
+	{
+		if (contact.pA == this)
+		{
+			hitMeteor = true;
+			break;
+		}
+	}
+	if (hitMeteor)
 	{
-		// if collides with meteor, state changes to dead
-		if (GameObject::GetTypeList(OBJ_METEOR).size() != 0)
+		if (GetPlayerState() != STATE_SHIELD)
 		{
-			std::vector<GameObject*> meteorList = GameObject::GetTypeList(OBJ_METEOR);
-			for (GameObject* g : meteorList)
+			PlaySpeaker::Instance().StartSound("combust", false);
+			SetPlayerState(STATE_DEAD);
+		}
+		if (GetPlayerState() == STATE_SHIELD)
+		{
+			// need iframes
+			if (GetHasTimerRun() == false)
 			{
-				Meteor* m = dynamic_cast<Meteor*>(g);
-				if (GameObject::CheckCollisions(this, m))
-				{
-					if (GetPlayerState() != STATE_SHIELD)
-					{
-						PlaySpeaker::Instance().StartSound("combust", false);
-						SetPlayerState(STATE_DEAD);
-					}
-					if (GetPlayerState() == STATE_SHIELD)
-					{
-						// need iframes
-						if (GetHasTimerRun() == false)
-						{
-							endTime = std::chrono::steady_clock::now()
-								+ std::chrono::seconds(1);
-							PlaySpeaker::Instance().StartSound("clang", false);
-							SetHasTimerRun(true);
-						}
-					}
-				}
+				endTime = std::chrono::steady_clock::now()
+					+ std::chrono::seconds(1);
+				PlaySpeaker::Instance().StartSound("clang", false);
+				SetHasTimerRun(true);
 			}
 		}
+	}
 
-		if (GetHasTimerRun() == true && std::chrono::steady_clock::now() > endTime)
+	// Attach to the new asteroid (the first one reached)
+	Asteroid* a = nullptr;
+	float firstTime = 2;
+	CollisionGrid::GetContacts(CollisionGrid::PairBit(OBJ_PLAYER, OBJ_ASTEROID), s_vContacts);
+	for (const CollisionGrid::Contact& contact : s_vContacts)
+	{
+		if (contact.pA == this && contact.pB->GetActive() && contact.time < firstTime)
 		{
-			SetHasTimerRun(false);
-			SetPlayerState(STATE_FLYING);
+			a = static_cast<Asteroid*>(contact.pB);
+			firstTime = contact.time;
 		}
-
-		// Attach to the new asteroid
-		if (GameObject::GetTypeList(OBJ_ASTEROID).size() != 0)
+	}
+	if (a != nullptr)
+	{
+		//Point2f offset = { radius * cos(angle), radius * sin(angle) };
+		Point2f pos = a->GetPosition();
+		Vector2f currentVel = a->GetVelocity();
+		SetPosition(pos);
+		SetVelocity(currentVel);
+		currentAst = a;
+		a->SetDrawOrder(1);
+		MAX_S_AGENT8 = sqrt(49);
+		SetPlayerState(STATE_ATTACHED);
+	}
+	// Pickup gem
+	CollisionGrid::GetContacts(CollisionGrid::PairBit(OBJ_PLAYER, OBJ_GEM), s_vContacts);
+	for (const CollisionGrid::Contact& contact : s_vContacts)
+	{
+		if (contact.pA != this || !contact.pB->GetActive())
 		{
-			std::vector<GameObject*> asteroidList = GameObject::GetTypeList(OBJ_ASTEROID);
-			for (GameObject* g : asteroidList)
-			{
-				Asteroid* a = dynamic_cast<Asteroid*>(g);
-				if (GameObject::CheckCollisions(this, a))
-				{
-					//Point2f offset = { radius * cos(angle), radius * sin(angle) };
-					Point2f pos = a->GetPosition();
-					Vector2f currentVel = a->GetVelocity();
-					SetPosition(pos);
-					SetVelocity(currentVel);
-					currentAst = a;
-					a->SetDrawOrder(1);
-					MAX_S_AGENT8 = sqrt(49);
-					SetPlayerState(STATE_ATTACHED);
-
-				}
-			}
+			continue;
 		}
-		// Pickup gem
-		if (GameObject::GetTypeList(OBJ_GEM).size() != 0)
+		Gem* gem = static_cast<Gem*>(contact.pB);
+		switch (gem->GetGemState())
 		{
-			std::vector<GameObject*> gemList = GameObject::GetTypeList(OBJ_GEM);
-			for (GameObject* g : gemList)
+		case gem->STATE_BASE:
+			state.score++;
+			// Spawn sparkles
+			Particle::Spawn(gem, Particle::SPARKLE);
+			gem->SetActive(false);
+			break;
+		case gem->STATE_FIVE:
+			state.score += 5;
+			// Spawn sparkles
+			Particle::Spawn(gem, Particle::SPARKLE);
+			gem->SetActive(false);
+			break;
+		case gem->STATE_SHIELD:
+			if (GetPlayerState() == STATE_FLYING)
 			{
-				Gem* gem = dynamic_cast<Gem*>(g);
-				if (GameObject::CheckCollisions(this, gem))
-				{
-					switch (gem->GetGemState())
-					{
-					case gem->STATE_BASE:
-						state.score++;
-						// Spawn sparkles
-						Particle::Spawn(gem, Particle::SPARKLE);
-						gem->SetActive(false);
-						break;
-					case gem->STATE_FIVE:
-						state.score += 5;
-						// Spawn sparkles
-						Particle::Spawn(gem, Particle::SPARKLE);
-						gem->SetActive(false);
-						break;
-					case gem->STATE_SHIELD:
-						if (GetPlayerState() == STATE_FLYING)
-						{
-							SetPlayerState(STATE_SHIELD);
-						}
-						state.score++;
-						// Spawn sparkles
-						Particle::Spawn(gem, Particle::SPARKLE);
-						gem->SetActive(false);
-						break;
-					case gem->STATE_SPEED:
-						if (GetPlayerState() == STATE_FLYING)
-						{
-							MAX_S_AGENT8 *= 1.5;
-							Vector2f playerVel = CalcVelocity(GetRotation());
-							SetVelocity(playerVel);
-							SetPlayerState(STATE_SPEED);
-						}
-						state.score++;
-						// Spawn sparkles
-						Particle::Spawn(gem, Particle::SPARKLE);
-						gem->SetActive(false);
-						break;
-					}
-					PlaySpeaker::Instance().StartSound("reward", false);
-				}
+				SetPlayerState(STATE_SHIELD);
+			}
+			state.score++;
+			// Spawn sparkles
+			Particle::Spawn(gem, Particle::SPARKLE);
+			gem->SetActive(false);
+			break;
+		case gem->STATE_SPEED:
+			if (GetPlayerState() == STATE_FLYING)
+			{
+				MAX_S_AGENT8 *= 1.5;
+				Vector2f playerVel = CalcVelocity(GetRotation());
+				SetVelocity(playerVel);
+				SetPlayerState(STATE_SPEED);
 			}
+			state.score++;
+			// Spawn sparkles
+			Particle::Spawn(gem, Particle::SPARKLE);
+			gem->SetActive(false);
+			break;
 		}
+		PlaySpeaker::Instance().StartSound("reward", false);
 	}
-
 }
 
 void Player::AttachedUpdate(GameState& state)
@@ -305,50 +313,54 @@ void Player::Draw(GameState& state) const
 	}
 }
 
+// Only used while flying, so it matches FlyingDraw and SpeedDraw
+bool Player::GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const
+{
+	spriteId = PlayBlitter::Instance().GetSpriteId(GetPlayerState() == STATE_SPEED ? SPRITE_AGENT8_SPEED : SPRITE_AGENT8_FLY);
+	frame = static_cast<int>(2 * state.time);
+	angle = static_cast<float>(GetRotation() + pi / 2);
+	return true;
+}
+
 void Player::FlyingDraw(GameState& state) const
 {
-	const int playerID = PlayBlitter::Instance().GetSpriteId("agent8_fly");
-	PlayBlitter::Instance().CentreSpriteOrigin(playerID);
-	PlayBlitter::Instance().DrawRotated(playerID, GetPosition(), 2 * state.time, GetRotation() + pi / 2);
+	const int playerID = PlayBlitter::Instance().GetSpriteId(SPRITE_AGENT8_FLY);
+	PlayBlitter::Instance().DrawRotated(playerID, GetDrawPosition(state), 2 * state.time, GetRotation() + pi / 2);
 }
 
 void Player::ShieldDraw(GameState& state) const
 {
-	const int playerID = PlayBlitter::Instance().GetSpriteId("shield_ring");
-	PlayBlitter::Instance().CentreSpriteOrigin(playerID);
-	PlayBlitter::Instance().DrawRotated(playerID, GetPosition(), 2 * state.time, GetRotation() + pi / 2);
+	const int playerID = PlayBlitter::Instance().GetSpriteId(SPRITE_SHIELD_RING);
+	PlayBlitter::Instance().DrawRotated(playerID, GetDrawPosition(state), 2 * state.time, GetRotation() + pi / 2);
 }
 
 void Player::SpeedDraw(GameState& state) const
 {
-	const int playerID = PlayBlitter::Instance().GetSpriteId("agent8_spd");
-	PlayBlitter::Instance().CentreSpriteOrigin(playerID);
-	PlayBlitter::Instance().DrawRotated(playerID, GetPosition(), 2 * state.time, GetRotation() + pi / 2);
+	const int playerID = PlayBlitter::Instance().GetSpriteId(SPRITE_AGENT8_SPEED);
+	PlayBlitter::Instance().DrawRotated(playerID, GetDrawPosition(state), 2 * state.time, GetRotation() + pi / 2);
 }
 
 void Player::AttachedDraw(GameState& state) const
 {
-	int playerID = PlayBlitter::Instance().GetSpriteId("agent8_left_7");
+	int playerID = PlayBlitter::Instance().GetSpriteId(SPRITE_AGENT8_LEFT);
 	int frame = 0;
 
 	if (PlayBuffer::Instance().KeyDown(VK_LEFT))
 	{
-		playerID = PlayBlitter::Instance().GetSpriteId("agent8_left_7");
+		playerID = PlayBlitter::Instance().GetSpriteId(SPRITE_AGENT8_LEFT);
 		frame = 2 * state.time;
 	}
 	else if (PlayBuffer::Instance().KeyDown(VK_RIGHT))
 	{
-		playerID = PlayBlitter::Instance().GetSpriteId("agent8_right_7");
+		playerID = PlayBlitter::Instance().GetSpriteId(SPRITE_AGENT8_RIGHT);
 		frame = 2 * state.time;
 	}
 
-	PlayBlitter::Instance().SetSpriteOrigin(playerID, attachedCentre);
-	PlayBlitter::Instance().DrawRotated(playerID, GetPosition(), frame, GetRotation() + pi / 2);
+	PlayBlitter::Instance().DrawRotated(playerID, GetDrawPosition(state), frame, GetRotation() + pi / 2);
 }
 
 void Player::DeadDraw(GameState& state) const
 {
-	const int playerID = PlayBlitter::Instance().GetSpriteId("agent8_dead_2");
-	PlayBlitter::Instance().CentreSpriteOrigin(playerID);
-	PlayBlitter::Instance().DrawRotated(playerID, GetPosition(), 2 * state.time, GetRotation() + pi / 2);
+	const int playerID = PlayBlitter::Instance().GetSpriteId(SPRITE_AGENT8_DEAD);
+	PlayBlitter::Instance().DrawRotated(playerID, GetDrawPosition(state), 2 * state.time, GetRotation() + pi / 2);
 }
\ No newline at end of file
@@ -5,9 +5,9 @@
 class Player : public GameObject
 {
 public:
-	// Origins relevant to the different states
-	Point2f attachedCentre = {65, 110};
-	Point2f deadCentre = { 65, 40 };
+	// Origins relevant to the different states (the attached one is set once at startup)
+	static inline const Point2f attachedCentre{ 65, 110 };
+	static inline const Point2f deadCentre{ 65, 40 };
 	float radius = 70;
 	GameObject* currentAst;
 	GameObject* refPlayer;
@@ -23,10 +23,12 @@ public:
 		STATE_DEAD
 	};
 
+	static constexpr Type TYPE = OBJ_PLAYER;
+
 	// Constructor and destructor
 	Player(Point2f pos, GameObject* a) : GameObject(pos)
 	{
-		SetType(OBJ_PLAYER);
+		SetType(TYPE);
 		SetUpdateOrder(0);
 		SetDrawOrder(0);
 		currentAst = a;
@@ -48,7 +50,10 @@ public:
 	void FlyingUpdate(GameState& state);
 	void AttachedUpdate(GameState& state);
 	void DeadUpdate(GameState& state);
+	// Reacts to the contacts the collision stage found for the player this tick (called after GameObject::UpdateAll)
+	void HandleContacts(GameState& state);
 	void Draw(GameState& state) const override;
+	bool GetCollisionSprite(const GameState& state, int& spriteId, int& frame, float& angle) const override;
 	void FlyingDraw(GameState& state) const;
 	void AttachedDraw(GameState& state) const;
 	void ShieldDraw(GameState& state) const;
@@ -70,4 +75,6 @@ private:
 	int m_playerState{ 0 };
 	bool m_isDead{ false };
 	bool m_hasTimerRun{ false };
+	// Contacts only count for ticks the player spent flying
+	bool m_flewThisTick{ false };
 };
\ No newline at end of file
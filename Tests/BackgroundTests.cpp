@@ -0,0 +1,178 @@
+//********************************************************************************************************************************
+// File:		BackgroundTests.cpp
+// Description:	Checks that DrawBackground with dirty rectangles puts back exactly the background (after sprites and PlayBuffer's
+//				drawing functions), and benchmarks how much it copies in game and stress scenes
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+namespace
+{
+	// The game's background, loaded the first time it is needed
+	int Background()
+	{
+		static int background = PlayTests::Blitter().LoadBackground( "Data\\Backgrounds\\Background.png" );
+		return background;
+	}
+
+	// The numbers of each kind of sprite in a scene
+	struct SceneCounts
+	{
+		int asteroids, meteors, gems, particles;
+		bool player;
+	};
+
+	// A scene of sprites drifting around the display buffer, drawn as the game draws them
+	class Scene
+	{
+	public:
+		Scene( const SceneCounts& counts, int seed ) : m_random( seed )
+		{
+			PlayBlitter& blit = PlayTests::Blitter();
+			Add( blit.GetSpriteId( "asteroid_2" ), counts.asteroids, DRAW_ROTATED );
+			Add( blit.GetSpriteId( "meteor_2" ), counts.meteors, DRAW_ROTATED );
+			Add( blit.GetSpriteId( "gem" ), counts.gems, DRAW_ROTATED );
+			Add( blit.GetSpriteId( "particle" ), counts.particles, DRAW_TRANSPARENT );
+			Add( blit.GetSpriteId( "agent8_fly" ), counts.player ? 1 : 0, DRAW_ROTATED );
+			m_score = counts.player;
+		}
+
+		// Moves everything on and draws it
+		void DrawFrame()
+		{
+			PlayBlitter& blit = PlayTests::Blitter();
+			const float width = static_cast<float>( PlayTests::DISPLAY_WIDTH ), height = static_cast<float>( PlayTests::DISPLAY_HEIGHT );
+			for( Placed& p : m_vPlaced )
+			{
+				p.pos += p.velocity;
+				p.pos.x = p.pos.x < 0.0f ? p.pos.x + width : p.pos.x > width ? p.pos.x - width : p.pos.x;
+				p.pos.y = p.pos.y < 0.0f ? p.pos.y + height : p.pos.y > height ? p.pos.y - height : p.pos.y;
+				if( p.how == DRAW_ROTATED )
+					blit.DrawRotated( p.spriteId, p.pos, 0, p.angle );
+				else
+					blit.DrawTransparent( p.spriteId, p.pos, 0, 0.5f );
+			}
+			if( m_score )
+				blit.DrawStringCentred( blit.GetSpriteId( "font64px_10x10" ), { width / 2, 50.0f }, "SCORE: 1234" );
+		}
+
+	private:
+		enum DrawType { DRAW_ROTATED, DRAW_TRANSPARENT };
+		struct Placed
+		{
+			int spriteId;
+			Point2f pos;
+			Vector2f velocity;
+			float angle;
+			DrawType how;
+		};
+
+		void Add( int spriteId, int count, DrawType how )
+		{
+			std::uniform_real_distribution< float > x( 0.0f, static_cast<float>( PlayTests::DISPLAY_WIDTH ) );
+			std::uniform_real_distribution< float > y( 0.0f, static_cast<float>( PlayTests::DISPLAY_HEIGHT ) );
+			std::uniform_real_distribution< float > speed( -3.0f, 3.0f );
+			std::uniform_real_distribution< float > angle( 0.0f, 2 * PLAY_PI );
+			for( int n = 0; n < count; n++ )
+				m_vPlaced.push_back( { spriteId, { x( m_random ), y( m_random ) }, { speed( m_random ), speed( m_random ) }, angle( m_random ), how } );
+		}
+
+		PlayTests::Random m_random;
+		std::vector< Placed > m_vPlaced;
+		bool m_score;
+	};
+
+	// The game's scene, one with a few more hazards, and a stress scene
+	const SceneCounts GAME_SCENE = { 6, 2, 4, 20, true };
+	const SceneCounts BUSY_SCENE = { 10, 4, 0, 40, true };
+	const SceneCounts STRESS_SCENE = { 500, 200, 300, 3000, false };
+}
+
+PT_TEST( DirtyRestoreMatchesBackground )
+{
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int pixels = PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT;
+	blit.SetDirtyRects( false );
+	blit.DrawBackground( Background() );
+	const std::vector< uint32_t > background( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + pixels );
+
+	// Frames drawn straight away and batched, some with pixels written directly which are marked with AddDirtyRect, and some 
+	// cleared with ClearBuffer
+	PlayBuffer& buff = PlayBuffer::Instance();
+	blit.SetDirtyRects( true );
+	Scene scene( GAME_SCENE, 21 );
+	int partialCopies = 0;
+	for( int frame = 0; frame < 60; frame++ )
+	{
+		blit.DrawBackground( Background() );
+		PT_CHECK( std::equal( background.begin(), background.end(), PlayTests::DisplayBuffer() ) );
+		partialCopies += !blit.GetBackgroundRestoreStats().fullCopy;
+
+		if( frame % 2 )
+			blit.BeginBatch();
+		scene.DrawFrame();
+		if( frame % 2 )
+			blit.EndBatch();
+
+		if( frame % 3 == 0 )
+		{
+			const int left = frame * 17 % PlayTests::DISPLAY_WIDTH, top = frame * 11 % PlayTests::DISPLAY_HEIGHT;
+			for( int y = top; y < std::min( top + 20, PlayTests::DISPLAY_HEIGHT ); y++ )
+				std::fill( PlayTests::DisplayBuffer() + y * PlayTests::DISPLAY_WIDTH + left, PlayTests::DisplayBuffer() + y * PlayTests::DISPLAY_WIDTH + std::min( left + 30, PlayTests::DISPLAY_WIDTH ), 0xFFFF00FF );
+			blit.AddDirtyRect( { static_cast<float>( left ), static_cast<float>( top ) }, { left + 29.0f, top + 19.0f } );
+		}
+
+		// PlayBuffer's drawing functions (which the F1 debug overlay uses) mark what they draw themselves
+		const float x = static_cast<float>( frame * 23 % PlayTests::DISPLAY_WIDTH ), y = static_cast<float>( frame * 13 % PlayTests::DISPLAY_HEIGHT );
+		buff.DrawLine( { x, y }, { x + 90.0f, y + 40.0f }, PlayBuffer::pixRed );
+		buff.DrawCircle( { x, y }, 25, PlayBuffer::pixBlue );
+		buff.DrawRect( { x - 10.0f, y + 30.0f }, { x + 20.0f, y + 45.0f }, { 128, 0, 255, 0 }, frame % 2 == 0 );
+		buff.DrawDebugString( { x, y - 20.0f }, "DEBUG " + std::to_string( frame ), PlayBuffer::pixWhite, frame % 2 == 0 );
+		buff.DrawTimingBar( { x, y + 60.0f }, { 80.0f, 6.0f } );
+		if( frame % 20 == 19 )
+			buff.ClearBuffer( PlayBuffer::pixGrey );
+	}
+	PT_CHECK( partialCopies > 0 );
+	blit.SetDirtyRects( false );
+}
+
+PT_BENCHMARK( DirtyRestoreBytes )
+{
+	// The bytes DrawBackground copies and the time it takes, averaged over the frames of each scene, against copying the
+	// whole background every frame
+	PlayBlitter& blit = PlayTests::Blitter();
+	const double fullBytes = sizeof( uint32_t ) * PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT;
+	const struct { const char* name; SceneCounts counts; } scenes[] = { { "game", GAME_SCENE }, { "busy", BUSY_SCENE }, { "stress", STRESS_SCENE } };
+	const int frames = 120;
+
+	for( const auto& s : scenes )
+	{
+		double bytes = 0.0, rects = 0.0, restoreTime[2] = { 0.0, 0.0 };
+		int fullCopies = 0;
+		for( bool dirty : { false, true } )
+		{
+			blit.SetDirtyRects( dirty );
+			Scene scene( s.counts, 22 );
+			for( int frame = 0; frame < frames; frame++ )
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				blit.DrawBackground( Background() );
+				restoreTime[dirty] += std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - start ).count();
+				scene.DrawFrame();
+
+				// The first frame always copies everything, so it isn't counted
+				if( dirty && frame > 0 )
+				{
+					const PlayBlitter::BackgroundRestoreStats& stats = blit.GetBackgroundRestoreStats();
+					bytes += static_cast<double>( stats.bytes );
+					rects += stats.rects;
+					fullCopies += stats.fullCopy;
+				}
+			}
+		}
+
+		PlayTests::Report( "%-6s %5.0f KB copied of %.0f KB (%2.0f%% saved) in %5.1f rects, %3d of %d full copies, restore %.2f ms against %.2f ms",
+			s.name, bytes / ( frames - 1 ) / 1024.0, fullBytes / 1024.0, 100.0 * ( 1.0 - bytes / ( frames - 1 ) / fullBytes ), rects / ( frames - 1 ),
+			fullCopies, frames - 1, restoreTime[1] / frames / 1000.0, restoreTime[0] / frames / 1000.0 );
+	}
+	blit.SetDirtyRects( false );
+}
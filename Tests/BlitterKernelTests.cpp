@@ -0,0 +1,204 @@
+//********************************************************************************************************************************
+// File:		BlitterKernelTests.cpp
+// Description:	Checks the SSE2 and AVX2 row kernels in PlayBlitter against the scalar ones, and benchmarks their fill rate
+// Notes:		The scalar kernels are the reference: the SIMD ones must give exactly the same pixels
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+namespace
+{
+	using RowKernel = void (*)( uint32_t* destPixels, const uint32_t* srcPixels, int count );
+	using AlphaRowKernel = void (*)( uint32_t* destPixels, const uint32_t* srcPixels, int count, float alphaMultiply );
+
+	// Pre-multiplies a pixel and inverts its alpha in the same way as PlayBlitter::PreMultiplyAlpha
+	uint32_t PreMultiply( uint32_t argb )
+	{
+		const uint32_t alpha = argb >> 24;
+		const uint32_t red = ( alpha * ( ( argb >> 16 ) & 0xFF ) ) >> 8;
+		const uint32_t green = ( alpha * ( ( argb >> 8 ) & 0xFF ) ) >> 8;
+		const uint32_t blue = ( alpha * ( argb & 0xFF ) ) >> 8;
+		return ( ( 0xFF - alpha ) << 24 ) | ( red << 16 ) | ( green << 8 ) | blue;
+	}
+
+	// Fills a row with runs of random pre-multiplied sprite pixels, with the transparent runs marked as in a sprite
+	// > Each run is transparent, opaque, part transparent or a mixture, and from one pixel long to a few SIMD groups
+	void RandomSpriteRow( PlayTests::Random& random, uint32_t* pRow, int count )
+	{
+		int n = 0;
+		while( n < count )
+		{
+			const int kind = random() % 4;
+			const int end = std::min( count, n + 1 + static_cast<int>( random() % 24 ) );
+			for( ; n < end; n++ )
+			{
+				uint32_t alpha = random() & 0xFF;
+				if( kind == 0 )
+					alpha = 0;
+				else if( kind == 1 )
+					alpha = 0xFF;
+				else if( kind == 2 )
+					alpha = 1 + random() % 254;
+				pRow[n] = PreMultiply( ( alpha << 24 ) | ( random() & 0x00FFFFFF ) );
+			}
+		}
+		PlayBlitterTests::MarkTransparentRuns( pRow, count );
+	}
+
+	// Fills a row with random pixels opaque enough to be in a copy span (see PlayBlitter::PixelSpan)
+	void RandomCopyRow( PlayTests::Random& random, uint32_t* pRow, int count )
+	{
+		for( int n = 0; n < count; n++ )
+			pRow[n] = PreMultiply( ( ( 0xF0 + random() % 16 ) << 24 ) | ( random() & 0x00FFFFFF ) );
+	}
+
+	// The rows are long enough for several AVX2 groups followed by every possible tail, and start at every alignment
+	constexpr int MAX_ROW = 80;
+	constexpr int ROWS = 4000;
+
+	// Runs the reference kernel and another one on the same random rows, and returns the number of rows they differ on
+	// > makeRow fills in the sprite row and blend runs one of the kernels on it, so this works for any kind of kernel
+	template< class MakeRow, class Blend >
+	int CountDifferentRows( MakeRow makeRow, Blend blend, int seed )
+	{
+		PlayTests::Random random( seed );
+		std::vector< uint32_t > src( MAX_ROW + 8 ), destReference( MAX_ROW + 8 ), destKernel( MAX_ROW + 8 );
+
+		int differences = 0;
+		for( int row = 0; row < ROWS; row++ )
+		{
+			const int count = row % ( MAX_ROW + 1 );
+			const int offset = random() % 8;
+			makeRow( random, src.data() + offset, count );
+			for( uint32_t& pixel : destReference )
+				pixel = random() | 0xFF000000;
+			destKernel = destReference;
+
+			blend( true, destReference.data() + offset, src.data() + offset, count );
+			blend( false, destKernel.data() + offset, src.data() + offset, count );
+			differences += destReference != destKernel;
+		}
+		return differences;
+	}
+
+	// Whether the CPU can run the AVX2 kernels (they aren't tested if it can't)
+	bool HasAVX2()
+	{
+		return PlayBlitterTests::GetMaxSimdLevel( PlayTests::Blitter() ) >= PlayBlitter::SIMD_AVX2;
+	}
+
+	// Checks a SIMD blend kernel against the reference one
+	int CompareBlend( RowKernel reference, RowKernel kernel, int seed )
+	{
+		return CountDifferentRows( RandomSpriteRow, [=]( bool useReference, uint32_t* pDest, const uint32_t* pSrc, int count )
+		{
+			( useReference ? reference : kernel )( pDest, pSrc, count );
+		}, seed );
+	}
+
+	// Checks a SIMD global alpha blend kernel against the reference one
+	int CompareBlendAlpha( AlphaRowKernel reference, AlphaRowKernel kernel, float alphaMultiply, int seed )
+	{
+		return CountDifferentRows( RandomSpriteRow, [=]( bool useReference, uint32_t* pDest, const uint32_t* pSrc, int count )
+		{
+			( useReference ? reference : kernel )( pDest, pSrc, count, alphaMultiply );
+		}, seed );
+	}
+
+	// Checks a SIMD copy kernel against the reference one
+	int CompareCopy( RowKernel reference, RowKernel kernel, int seed )
+	{
+		return CountDifferentRows( RandomCopyRow, [=]( bool useReference, uint32_t* pDest, const uint32_t* pSrc, int count )
+		{
+			( useReference ? reference : kernel )( pDest, pSrc, count );
+		}, seed );
+	}
+}
+
+PT_TEST( BlendRowSIMDMatchesScalar )
+{
+	PT_CHECK( CompareBlend( PlayBlitterTests::BlendRow, PlayBlitterTests::BlendRowSSE2, 1 ) == 0 );
+	if( HasAVX2() )
+		PT_CHECK( CompareBlend( PlayBlitterTests::BlendRow, PlayBlitterTests::BlendRowAVX2, 2 ) == 0 );
+}
+
+PT_TEST( BlendRowAlphaSIMDMatchesScalar )
+{
+	// Zero and one are the ends of the range the kernels take
+	const float alphas[] = { 0.0f, 0.5f, 1.0f, 0.3f, 0.77f };
+	for( float alpha : alphas )
+	{
+		PT_CHECK( CompareBlendAlpha( PlayBlitterTests::BlendRowAlpha, PlayBlitterTests::BlendRowAlphaSSE2, alpha, 3 ) == 0 );
+		if( HasAVX2() )
+			PT_CHECK( CompareBlendAlpha( PlayBlitterTests::BlendRowAlpha, PlayBlitterTests::BlendRowAlphaAVX2, alpha, 4 ) == 0 );
+	}
+}
+
+PT_TEST( CopyRowSIMDMatchesScalar )
+{
+	PT_CHECK( CompareCopy( PlayBlitterTests::CopyRow, PlayBlitterTests::CopyRowSSE2, 5 ) == 0 );
+	if( HasAVX2() )
+		PT_CHECK( CompareCopy( PlayBlitterTests::CopyRow, PlayBlitterTests::CopyRowAVX2, 6 ) == 0 );
+	// Copy spans are only made where copying gives the same result as blending
+	PT_CHECK( CompareCopy( PlayBlitterTests::BlendRow, PlayBlitterTests::CopyRow, 7 ) == 0 );
+}
+
+PT_TEST( BlendRowSkipsTransparentRuns )
+{
+	// A row which is all one transparent run, and one with a single opaque pixel at each end, leave the rest alone
+	const int count = 37;
+	std::vector< uint32_t > src( count, 0xFF000000 ), dest( count, 0xFF123456 );
+	PlayBlitterTests::MarkTransparentRuns( src.data(), count );
+
+	const RowKernel kernels[] = { PlayBlitterTests::BlendRow, PlayBlitterTests::BlendRowSSE2, PlayBlitterTests::BlendRowAVX2 };
+	for( int k = 0; k < ( HasAVX2() ? 3 : 2 ); k++ )
+	{
+		std::vector< uint32_t > result = dest;
+		kernels[k]( result.data(), src.data(), count );
+		PT_CHECK( result == dest );
+
+		std::vector< uint32_t > ends = src;
+		ends.front() = 0x00ABCDEF;
+		ends.back() = 0x00FEDCBA;
+		PlayBlitterTests::MarkTransparentRuns( ends.data(), count );
+		result = dest;
+		kernels[k]( result.data(), ends.data(), count );
+		PT_CHECK( result.front() == 0xFFABCDEF && result.back() == 0xFFFEDCBA );
+		PT_CHECK( std::equal( result.begin() + 1, result.end() - 1, dest.begin() + 1 ) );
+	}
+}
+
+PT_BENCHMARK( BlendRowFillRate )
+{
+	// Square blocks of pixels like a sprite's, blended with each kernel (the game draws mostly with BlendRow)
+	PlayTests::Random random( 8 );
+	std::vector< uint32_t > src( 512 * 512 ), dest( 512 * 512, 0xFF000000 );
+	for( int row = 0; row < 512; row++ )
+		RandomSpriteRow( random, src.data() + row * 512, 512 );
+
+	const char* names[] = { "scalar", "SSE2", "AVX2" };
+	const RowKernel blends[] = { PlayBlitterTests::BlendRow, PlayBlitterTests::BlendRowSSE2, PlayBlitterTests::BlendRowAVX2 };
+	const AlphaRowKernel alphaBlends[] = { PlayBlitterTests::BlendRowAlpha, PlayBlitterTests::BlendRowAlphaSSE2, PlayBlitterTests::BlendRowAlphaAVX2 };
+
+	// Each timing blends the same number of pixels, as enough blocks of the size to make up 512x512
+	const double pixels = 512.0 * 512.0;
+	for( int size = 16; size <= 512; size *= 2 )
+	{
+		const int blocks = ( 512 * 512 ) / ( size * size );
+		for( int k = 0; k < ( HasAVX2() ? 3 : 2 ); k++ )
+		{
+			const double blendTime = PlayTests::BestTime( [&]
+			{
+				for( int block = 0; block < blocks; block++ )
+					for( int row = 0; row < size; row++ )
+						blends[k]( dest.data() + row * 512, src.data() + row * 512, size );
+			} );
+			const double alphaTime = PlayTests::BestTime( [&]
+			{
+				for( int block = 0; block < blocks; block++ )
+					for( int row = 0; row < size; row++ )
+						alphaBlends[k]( dest.data() + row * 512, src.data() + row * 512, size, 0.5f );
+			} );
+			PlayTests::Report( "%3dx%-3d %-6s  blend %7.0f Mpixels/s   alpha blend %7.0f Mpixels/s", size, size, names[k], pixels / blendTime, pixels / alphaTime );
+		}
+	}
+}
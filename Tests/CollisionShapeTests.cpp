@@ -0,0 +1,191 @@
+//********************************************************************************************************************************
+// File:		CollisionShapeTests.cpp
+// Description:	Checks the collision shapes loaded from the .INF files in Data/Sprites, and SpriteShapeCollide against a
+//				reference which samples points in both shapes
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+namespace
+{
+	using Shape = PlayBlitter::CollisionShape;
+
+	// A sprite's origin and collision shape as its .INF file gives them, in pixels from the top left of a frame
+	struct ExpectedShape
+	{
+		const char* name;
+		int originX, originY;
+		Shape::Type type;
+		std::vector< Point2f > vPoints;
+		float radius;
+	};
+
+	// The shipped shapes the game collides with, and a sprite without a shape (whose points are filled in from its size)
+	std::vector< ExpectedShape > ExpectedShapes()
+	{
+		const PlayBlitter::Sprite& saucer = PlayBlitterTests::GetSprite( PlayTests::Blitter(), PlayTests::Blitter().GetSpriteId( "saucer" ) );
+		const float width = static_cast<float>( saucer.width ), height = static_cast<float>( saucer.height );
+		return
+		{
+			{ "asteroid_2", 75, 80, Shape::SHAPE_CIRCLE, { { 74, 74 } }, 60.0f },
+			{ "meteor_2", 64, 45, Shape::SHAPE_HULL, { { 20, 44 }, { 40, 16 }, { 71, 5 }, { 97, 25 }, { 108, 86 }, { 92, 138 }, { 51, 197 }, { 21, 66 } }, 0.0f },
+			{ "agent8_fly", 64, 54, Shape::SHAPE_CAPSULE, { { 65, 52 }, { 65, 72 } }, 28.0f },
+			{ "gem", 23, 24, Shape::SHAPE_CIRCLE, { { 23, 23 } }, 22.0f },
+			{ "saucer", saucer.originX, saucer.originY, Shape::SHAPE_NONE, { { 0, 0 }, { width, 0 }, { width, height }, { 0, height } }, 0.0f },
+		};
+	}
+
+	// A shape rotated clockwise around the sprite origin and placed on the screen, as SpriteShapeCollide places it
+	struct PlacedShape
+	{
+		std::vector< Point2f > vPoints;
+		float radius;
+		float left, top, right, bottom;
+	};
+
+	PlacedShape Place( const ExpectedShape& shape, Point2f pos, float angle )
+	{
+		PlacedShape placed{ {}, shape.radius, 1e30f, 1e30f, -1e30f, -1e30f };
+		for( const Point2f& point : shape.vPoints )
+		{
+			const float x = point.x - shape.originX, y = point.y - shape.originY;
+			const Point2f p = { pos.x + cos( angle ) * x - sin( angle ) * y, pos.y + sin( angle ) * x + cos( angle ) * y };
+			placed.vPoints.push_back( p );
+			placed.left = std::min( placed.left, p.x - shape.radius );
+			placed.top = std::min( placed.top, p.y - shape.radius );
+			placed.right = std::max( placed.right, p.x + shape.radius );
+			placed.bottom = std::max( placed.bottom, p.y + shape.radius );
+		}
+		return placed;
+	}
+
+	// The distance from a point to a line segment
+	float SegmentDistance( Point2f p, Point2f a, Point2f b )
+	{
+		const Vector2f ab = b - a;
+		const float t = std::max( 0.0f, std::min( 1.0f, dot( p - a, ab ) / lengthSqr( ab ) ) );
+		return length( p - ( a + ab * t ) );
+	}
+
+	// Whether a point is within the given distance of a placed shape (which counts its radius)
+	bool Within( const PlacedShape& shape, Point2f p, float distance )
+	{
+		const std::vector< Point2f >& v = shape.vPoints;
+		if( v.size() == 1 )
+			return length( p - v[0] ) <= shape.radius + distance;
+		if( v.size() == 2 )
+			return SegmentDistance( p, v[0], v[1] ) <= shape.radius + distance;
+
+		bool anyPositive = false, anyNegative = false;
+		float nearest = 1e30f;
+		for( size_t i = 0; i < v.size(); i++ )
+		{
+			const Point2f a = v[i], b = v[( i + 1 ) % v.size()];
+			const float cross = ( b.x - a.x ) * ( p.y - a.y ) - ( b.y - a.y ) * ( p.x - a.x );
+			anyPositive |= cross > 0.0f;
+			anyNegative |= cross < 0.0f;
+			nearest = std::min( nearest, SegmentDistance( p, a, b ) );
+		}
+		return !( anyPositive && anyNegative ) || nearest <= shape.radius + distance;
+	}
+
+	enum SampledResult { SAMPLED_APART, SAMPLED_OVERLAP, SAMPLED_UNSURE };
+
+	// Samples every pixel where the two shapes could overlap
+	// > They overlap if a sample is in both. If they overlap anywhere, a sample within half a pixel diagonal of that point
+	//   is within that distance of both, so when no sample is they are apart. Otherwise they only just touch or miss
+	SampledResult SampleOverlap( const PlacedShape& a, const PlacedShape& b )
+	{
+		const float margin = 0.75f;
+		const float left = std::floor( std::max( a.left, b.left ) ) - 1.0f, right = std::min( a.right, b.right ) + 1.0f;
+		const float top = std::floor( std::max( a.top, b.top ) ) - 1.0f, bottom = std::min( a.bottom, b.bottom ) + 1.0f;
+		bool near = false;
+		for( float y = top; y <= bottom; y += 1.0f )
+		{
+			for( float x = left; x <= right; x += 1.0f )
+			{
+				if( !Within( a, { x, y }, margin ) || !Within( b, { x, y }, margin ) )
+					continue;
+				if( Within( a, { x, y }, 0.0f ) && Within( b, { x, y }, 0.0f ) )
+					return SAMPLED_OVERLAP;
+				near = true;
+			}
+		}
+		return near ? SAMPLED_UNSURE : SAMPLED_APART;
+	}
+}
+
+PT_TEST( CollisionShapesLoadFromInfFiles )
+{
+	PlayBlitter& blit = PlayTests::Blitter();
+	for( const ExpectedShape& expected : ExpectedShapes() )
+	{
+		const int id = blit.GetSpriteId( expected.name );
+		const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( blit, id );
+		PT_CHECK( spr.originX == expected.originX && spr.originY == expected.originY );
+		PT_CHECK( blit.GetSpriteShape( id ).type == expected.type );
+
+		Point2f points[PlayBlitter::MAX_HULL_POINTS];
+		float radius = -1.0f;
+		const int count = PlayBlitterTests::GetShapePoints( blit, id, points, radius );
+		PT_CHECK( count == static_cast<int>( expected.vPoints.size() ) );
+		PT_CHECK( radius == expected.radius );
+
+		float reach = 0.0f;
+		for( int i = 0; i < count && i < static_cast<int>( expected.vPoints.size() ); i++ )
+		{
+			const Point2f relative = { expected.vPoints[i].x - expected.originX, expected.vPoints[i].y - expected.originY };
+			PT_CHECK( points[i].x == relative.x && points[i].y == relative.y );
+			reach = std::max( reach, length( relative ) + expected.radius );
+		}
+		PT_CHECK( std::abs( blit.GetSpriteShapeReach( id ) - reach ) < 0.001f );
+	}
+
+	// An .INF file which ends after the origin leaves the sprite with its bounding box
+	const int saucer = blit.GetSpriteId( "saucer" );
+	for( const char* rest : { "", "  \n\n" } )
+	{
+		std::istringstream info( rest );
+		PlayBlitterTests::LoadCollisionShape( blit, saucer, info );
+		PT_CHECK( blit.GetSpriteShape( saucer ).type == Shape::SHAPE_NONE );
+	}
+}
+
+PT_TEST( SpriteShapeCollideMatchesSampledShapes )
+{
+	PlayBlitter& blit = PlayTests::Blitter();
+	const std::vector< ExpectedShape > vShapes = ExpectedShapes();
+	const ExpectedShape& meteor = vShapes[1];
+	const ExpectedShape& gem = vShapes[3];
+
+	// A gem wholly inside the meteor's hull, touching none of its edges
+	const Point2f meteorPos = { 640.0f, 360.0f };
+	PT_CHECK( blit.SpriteShapeCollide( blit.GetSpriteId( gem.name ), meteorPos + Vector2f( 0.0f, 36.0f ), 0.0f, blit.GetSpriteId( meteor.name ), meteorPos, 0.0f ) );
+	PT_CHECK( SampleOverlap( Place( gem, meteorPos + Vector2f( 0.0f, 36.0f ), 0.0f ), Place( meteor, meteorPos, 0.0f ) ) == SAMPLED_OVERLAP );
+
+	// Random pairs of every kind of shape (the meteor's hull against itself as well), rotated and close enough to touch
+	PlayTests::Random random( 15 );
+	std::uniform_real_distribution< float > unit( -1.0f, 1.0f );
+	std::uniform_real_distribution< float > angle( 0.0f, 2 * PLAY_PI );
+	const int pairs = 300;
+	int hits = 0, unsure = 0, failures = 0;
+	for( int n = 0; n < pairs; n++ )
+	{
+		const ExpectedShape& a = vShapes[random() % vShapes.size()];
+		const ExpectedShape& b = vShapes[random() % vShapes.size()];
+		const int idA = blit.GetSpriteId( a.name ), idB = blit.GetSpriteId( b.name );
+		const float range = 0.8f * ( blit.GetSpriteShapeReach( idA ) + blit.GetSpriteShapeReach( idB ) );
+		const Point2f posA = { 640.0f, 360.0f };
+		const Point2f posB = posA + Vector2f( range * unit( random ), range * unit( random ) );
+		const float angleA = angle( random ), angleB = angle( random );
+
+		const bool hit = blit.SpriteShapeCollide( idA, posA, angleA, idB, posB, angleB );
+		const SampledResult sampled = SampleOverlap( Place( a, posA, angleA ), Place( b, posB, angleB ) );
+		hits += hit;
+		unsure += sampled == SAMPLED_UNSURE;
+		failures += ( sampled == SAMPLED_OVERLAP && !hit ) || ( sampled == SAMPLED_APART && hit );
+	}
+	PlayTests::Report( "%d of %d pairs overlap, %d too close to call by sampling", hits, pairs, unsure );
+	PT_CHECK( failures == 0 );
+	PT_CHECK( hits > pairs / 10 && hits < pairs * 9 / 10 );
+	PT_CHECK( unsure < pairs / 20 );
+}
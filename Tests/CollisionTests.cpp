@@ -0,0 +1,516 @@
+//********************************************************************************************************************************
+// File:		CollisionTests.cpp
+// Description:	Checks the collision grid's queries, including the swept ones which stop fast movers tunnelling through
+//				things, and the contact stage, and benchmarks them
+//********************************************************************************************************************************
+#include "PlayTests.h"
+#include "../Collision.h"
+
+namespace
+{
+	// An object which sits in the collision grid and nothing else, having moved from one position to another this tick
+	class TestTarget : public GameObject
+	{
+	public:
+		TestTarget( Point2f prevPos, Point2f pos, Type type ) : GameObject( pos )
+		{
+			SetType( type );
+			m_prevPos = prevPos;
+		}
+		void Draw( GameState& state ) const override { (void)state; }
+	};
+
+	TestTarget* AddTarget( Point2f pos, GameObject::Type type = GameObject::OBJ_GEM )
+	{
+		return new TestTarget( pos, pos, type );
+	}
+
+	// The player's collision radius in the game
+	constexpr float RADIUS = static_cast<float>( S_SCREEN_LIMIT );
+
+	// The time a swept query finds an object at, or -1 if it isn't found
+	float QueryTime( Point2f from, Point2f to, const GameObject* pTarget )
+	{
+		std::vector< CollisionGrid::SweptHit > vHits;
+		CollisionGrid::QuerySwept( from, to, RADIUS, CollisionGrid::INDEXED_TYPES, vHits );
+		for( const CollisionGrid::SweptHit& hit : vHits )
+		{
+			if( hit.pObject == pTarget )
+				return hit.time;
+		}
+		return -1.0f;
+	}
+
+	// Every contact between the objects in pairs of types in the mask, found by testing every pair against each other
+	// > Each is given the way round FindContacts gives it: pA has the lower type, or the lower address for the same type
+	std::vector< CollisionGrid::Contact > BruteForceContacts( const std::vector< GameObject* >& vObjects, uint64_t pairMask )
+	{
+		std::vector< CollisionGrid::Contact > vContacts;
+		for( size_t a = 0; a < vObjects.size(); a++ )
+		{
+			for( size_t b = a + 1; b < vObjects.size(); b++ )
+			{
+				GameObject* pA = vObjects[a];
+				GameObject* pB = vObjects[b];
+				const uint64_t pairBit = CollisionGrid::PairBit( pA->GetType(), pB->GetType() );
+				if( !( pairBit & pairMask ) )
+					continue;
+				if( pA->GetType() > pB->GetType() || ( pA->GetType() == pB->GetType() && pA > pB ) )
+					std::swap( pA, pB );
+
+				const float time = CollisionGrid::SweptCircleTime( pA->GetPrevPosition(), pA->GetPosition() - pA->GetPrevPosition(),
+					pB->GetPrevPosition(), pB->GetPosition() - pB->GetPrevPosition(), RADIUS );
+				if( time >= 0.0f )
+					vContacts.push_back( { pA, pB, pairBit, time } );
+			}
+		}
+		return vContacts;
+	}
+
+	// Sorts contacts by their pair of objects, so lists found in different orders can be compared
+	void SortContacts( std::vector< CollisionGrid::Contact >& vContacts )
+	{
+		std::sort( vContacts.begin(), vContacts.end(), []( const CollisionGrid::Contact& a, const CollisionGrid::Contact& b )
+		{
+			return a.pA != b.pA ? std::less< GameObject* >()( a.pA, b.pA ) : std::less< GameObject* >()( a.pB, b.pB );
+		} );
+	}
+}
+
+PT_TEST( SweptQueryDoesntTunnel )
+{
+	// A gem just inside the radius of the middle of each move, so the end positions are both too far away to touch it
+	// > These are speeds the player reaches by stacking speed gems, each of which multiplies its top speed by 1.5
+	const float speeds[] = { 23.6f, 60.0f, 99.0f };
+	const Vector2f directions[] = { { 1.0f, 0.0f }, { 0.0f, -1.0f }, { 0.6f, 0.8f } };
+	const float offset = RADIUS - 1.0f;
+
+	for( float speed : speeds )
+	{
+		for( Vector2f direction : directions )
+		{
+			const Point2f middle = { 640.0f, 360.0f };
+			const Point2f from = middle - direction * ( speed * 0.5f );
+			const Point2f to = middle + direction * ( speed * 0.5f );
+			const Vector2f side = { -direction.y, direction.x };
+			const GameObject* pGem = AddTarget( middle + side * offset );
+			CollisionGrid::Build();
+
+			// The first touch is where the distance along the move from the middle is sqrt( RADIUS^2 - offset^2 )
+			const float expectedTime = ( speed * 0.5f - std::sqrt( RADIUS * RADIUS - offset * offset ) ) / speed;
+			PT_CHECK( CollisionGrid::TorusDistanceSq( to, pGem->GetPosition() ) >= RADIUS * RADIUS );
+			PT_CHECK( std::fabs( QueryTime( from, to, pGem ) - expectedTime ) < 1e-3f );
+			GameObject::DestroyAll();
+		}
+	}
+}
+
+PT_TEST( SweptQueryFindsMovingTargets )
+{
+	// A meteor crossing the player's path during the tick, which is nowhere near it at the start or the end
+	// > Moves have to stay within the ghost margin (see CollisionGrid::GatherSwept), so it moves a little under two cells
+	const Point2f from = { 400.0f, 300.0f }, to = { 500.0f, 300.0f };
+	const GameObject* pMeteor = new TestTarget( { 450.0f, 345.0f }, { 450.0f, 255.0f }, GameObject::OBJ_METEOR );
+	CollisionGrid::Build();
+
+	// Both move steadily and meet in the middle of the tick, so they first touch well before that
+	const float time = QueryTime( from, to, pMeteor );
+	PT_CHECK( time > 0.0f && time < 0.5f );
+	PT_CHECK( time == CollisionGrid::SweptCircleTime( from, to - from, pMeteor->GetPrevPosition(), pMeteor->GetPosition() - pMeteor->GetPrevPosition(), RADIUS ) );
+
+	// Crossing just beyond where the meteor stops misses it
+	PT_CHECK( QueryTime( { 400.0f, 220.0f }, { 500.0f, 220.0f }, pMeteor ) < 0.0f );
+	GameObject::DestroyAll();
+}
+
+PT_TEST( SweptQueryStartingInContact )
+{
+	// Circles which already touch at the start of the tick hit at time 0, whichever way they move
+	const GameObject* pGem = AddTarget( { 640.0f, 360.0f } );
+	CollisionGrid::Build();
+
+	PT_CHECK( QueryTime( { 620.0f, 360.0f }, { 700.0f, 360.0f }, pGem ) == 0.0f );
+	PT_CHECK( QueryTime( { 620.0f, 360.0f }, { 540.0f, 360.0f }, pGem ) == 0.0f );
+	PT_CHECK( QueryTime( { 620.0f, 360.0f }, { 620.0f, 360.0f }, pGem ) == 0.0f );
+	PT_CHECK( CollisionGrid::SweptCircleTime( { 0.0f, 0.0f }, { 0.0f, 0.0f }, { 10.0f, 0.0f }, { 0.0f, 0.0f }, RADIUS ) == 0.0f );
+	GameObject::DestroyAll();
+}
+
+PT_TEST( SweptQueryAcrossTheSeam )
+{
+	// Moves which cross an edge of the torus find targets just the other side of it, and ones near the edge they start from
+	const float right = CollisionGrid::TORUS_LEFT + CollisionGrid::TORUS_WIDTH;
+	const float bottom = CollisionGrid::TORUS_TOP + CollisionGrid::TORUS_HEIGHT;
+
+	const GameObject* pLeft = AddTarget( { CollisionGrid::TORUS_LEFT + 60.0f, 300.0f } );
+	const GameObject* pRight = AddTarget( { right - 60.0f, 500.0f } );
+	const GameObject* pTop = AddTarget( { 200.0f, CollisionGrid::TORUS_TOP + 60.0f } );
+	CollisionGrid::Build();
+
+	// Off the right edge, off the left edge and off the bottom edge (the moves end past the edge, before they are wrapped)
+	PT_CHECK( QueryTime( { right - 40.0f, 300.0f }, { right + 40.0f, 300.0f }, pLeft ) > 0.0f );
+	PT_CHECK( QueryTime( { CollisionGrid::TORUS_LEFT + 40.0f, 500.0f }, { CollisionGrid::TORUS_LEFT - 40.0f, 500.0f }, pRight ) > 0.0f );
+	PT_CHECK( QueryTime( { 200.0f, bottom - 40.0f }, { 200.0f, bottom + 40.0f }, pTop ) > 0.0f );
+
+	// The same hits between the pair alone, with the positions either side of the seam
+	const float time = CollisionGrid::SweptCircleTime( { right - 40.0f, 300.0f }, { 80.0f, 0.0f }, pLeft->GetPosition(), { 0.0f, 0.0f }, RADIUS );
+	PT_CHECK( std::fabs( time - ( 100.0f - RADIUS ) / 80.0f ) < 1e-4f );
+
+	// A target on the far side of the screen isn't hit just because the move crosses the seam
+	PT_CHECK( QueryTime( { 200.0f, bottom - 40.0f }, { 200.0f, bottom + 40.0f }, pLeft ) < 0.0f );
+	GameObject::DestroyAll();
+}
+
+PT_TEST( SweptCircleTimesMatchesScalar )
+{
+	// Random circles all over the torus (including across the seams) with random moves, in batches with every tail length
+	PlayTests::Random random( 12 );
+	std::uniform_real_distribution< float > x( CollisionGrid::TORUS_LEFT, CollisionGrid::TORUS_LEFT + CollisionGrid::TORUS_WIDTH );
+	std::uniform_real_distribution< float > y( CollisionGrid::TORUS_TOP, CollisionGrid::TORUS_TOP + CollisionGrid::TORUS_HEIGHT );
+	std::uniform_real_distribution< float > move( -100.0f, 100.0f );
+
+	int failures = 0, hits = 0;
+	for( int batch = 0; batch < 2000; batch++ )
+	{
+		const int count = batch % 40;
+		const Point2f a = { x( random ), y( random ) };
+		const Vector2f aMove = { move( random ), move( random ) };
+		std::vector< float > vX( count ), vY( count ), vMoveX( count ), vMoveY( count ), vTimes( count );
+		for( int n = 0; n < count; n++ )
+		{
+			// Half of them near enough to a to have a chance of touching it
+			vX[n] = n % 2 ? x( random ) : a.x + move( random );
+			vY[n] = n % 2 ? y( random ) : a.y + move( random );
+			vMoveX[n] = move( random );
+			vMoveY[n] = move( random );
+		}
+
+		CollisionGrid::SweptCircleTimes( a, aMove, RADIUS, vX.data(), vY.data(), vMoveX.data(), vMoveY.data(), count, vTimes.data() );
+		for( int n = 0; n < count; n++ )
+		{
+			const float time = CollisionGrid::SweptCircleTime( a, aMove, { vX[n], vY[n] }, { vMoveX[n], vMoveY[n] }, RADIUS );
+			failures += std::fabs( time - vTimes[n] ) > 1e-5f;
+			hits += time >= 0.0f;
+		}
+	}
+	PT_CHECK( hits > 0 );
+	PT_CHECK( failures == 0 );
+}
+
+PT_TEST( ContactsMatchEveryPairTested )
+{
+	// Meteors, asteroids and gems drifting over the torus, with a pair of gems and a meteor and asteroid which only touch
+	// across a seam, and circle tests between meteors and asteroids, asteroids and gems, and gems and gems
+	PlayTests::Random random( 16 );
+	std::uniform_real_distribution< float > x( CollisionGrid::TORUS_LEFT, CollisionGrid::TORUS_LEFT + CollisionGrid::TORUS_WIDTH );
+	std::uniform_real_distribution< float > y( CollisionGrid::TORUS_TOP, CollisionGrid::TORUS_TOP + CollisionGrid::TORUS_HEIGHT );
+	std::uniform_real_distribution< float > speed( -5.0f, 5.0f );
+	const GameObject::Type types[] = { GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM };
+	const float right = CollisionGrid::TORUS_LEFT + CollisionGrid::TORUS_WIDTH;
+	const float bottom = CollisionGrid::TORUS_TOP + CollisionGrid::TORUS_HEIGHT;
+
+	std::vector< GameObject* > vObjects;
+	for( int n = 0; n < 600; n++ )
+	{
+		const Point2f pos = { x( random ), y( random ) };
+		vObjects.push_back( new TestTarget( pos - Vector2f( speed( random ), speed( random ) ), pos, types[n % 3] ) );
+	}
+	GameObject* pLeftGem = AddTarget( { CollisionGrid::TORUS_LEFT + 10.0f, 200.0f } );
+	GameObject* pRightGem = AddTarget( { right - 10.0f, 200.0f } );
+	GameObject* pTopMeteor = AddTarget( { 600.0f, CollisionGrid::TORUS_TOP + 10.0f }, GameObject::OBJ_METEOR );
+	GameObject* pBottomAsteroid = AddTarget( { 600.0f, bottom - 10.0f }, GameObject::OBJ_ASTEROID );
+	vObjects.insert( vObjects.end(), { pLeftGem, pRightGem, pTopMeteor, pBottomAsteroid } );
+
+	CollisionGrid::ClearContactPairs();
+	CollisionGrid::SetContactPair( GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID, CollisionGrid::NARROW_CIRCLE );
+	CollisionGrid::SetContactPair( GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM, CollisionGrid::NARROW_CIRCLE );
+	CollisionGrid::SetContactPair( GameObject::OBJ_GEM, GameObject::OBJ_GEM, CollisionGrid::NARROW_CIRCLE );
+	const uint64_t meteorAsteroid = CollisionGrid::PairBit( GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID );
+	const uint64_t asteroidGem = CollisionGrid::PairBit( GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM );
+	const uint64_t gemGem = CollisionGrid::PairBit( GameObject::OBJ_GEM, GameObject::OBJ_GEM );
+
+	GameState state;
+	CollisionGrid::Build();
+	CollisionGrid::FindContacts( state );
+
+	// Each mask gets exactly the contacts of its pairs, each once, the right way round and at the same time
+	const uint64_t masks[] = { meteorAsteroid | asteroidGem | gemGem, meteorAsteroid, gemGem, asteroidGem | gemGem };
+	for( uint64_t mask : masks )
+	{
+		std::vector< CollisionGrid::Contact > vFound;
+		CollisionGrid::GetContacts( mask, vFound );
+		std::vector< CollisionGrid::Contact > vExpected = BruteForceContacts( vObjects, mask );
+		SortContacts( vFound );
+		SortContacts( vExpected );
+
+		PT_CHECK( vFound.size() == vExpected.size() );
+		int failures = 0;
+		for( size_t n = 0; n < std::min( vFound.size(), vExpected.size() ); n++ )
+		{
+			const CollisionGrid::Contact& found = vFound[n];
+			const CollisionGrid::Contact& expected = vExpected[n];
+			failures += found.pA != expected.pA || found.pB != expected.pB || found.pairBit != expected.pairBit || std::fabs( found.time - expected.time ) > 1e-5f;
+		}
+		PT_CHECK( failures == 0 );
+	}
+	PT_CHECK( CollisionGrid::GetContactCount() == static_cast<int>( BruteForceContacts( vObjects, masks[0] ).size() ) );
+
+	// The pairs which only touch across a seam are among them
+	std::vector< CollisionGrid::Contact > vFound;
+	CollisionGrid::GetContacts( masks[0], vFound );
+	auto found = [&]( const GameObject* pA, const GameObject* pB )
+	{
+		return std::count_if( vFound.begin(), vFound.end(), [&]( const CollisionGrid::Contact& c ) { return ( c.pA == pA && c.pB == pB ) || ( c.pA == pB && c.pB == pA ); } );
+	};
+	PT_CHECK( found( pLeftGem, pRightGem ) == 1 );
+	PT_CHECK( found( pTopMeteor, pBottomAsteroid ) == 1 );
+
+	CollisionGrid::ClearContactPairs();
+	GameObject::DestroyAll();
+}
+
+PT_BENCHMARK( SweptQueryCost )
+{
+	// Point and swept queries at the player's top speed with one speed gem, among gems spread over the torus
+	PlayTests::Random random( 13 );
+	std::uniform_real_distribution< float > x( CollisionGrid::TORUS_LEFT, CollisionGrid::TORUS_LEFT + CollisionGrid::TORUS_WIDTH );
+	std::uniform_real_distribution< float > y( CollisionGrid::TORUS_TOP, CollisionGrid::TORUS_TOP + CollisionGrid::TORUS_HEIGHT );
+	const int queries = 1000;
+	std::vector< Point2f > vFrom( queries );
+	for( Point2f& from : vFrom )
+		from = { x( random ), y( random ) };
+	const Vector2f move = { 10.5f, 0.0f };
+
+	const int counts[] = { 100, 1000, 10000 };
+	for( int count : counts )
+	{
+		for( int n = 0; n < count; n++ )
+			AddTarget( { x( random ), y( random ) } );
+		CollisionGrid::Build();
+
+		std::vector< GameObject* > vResults;
+		std::vector< CollisionGrid::SweptHit > vHits;
+		const double pointTime = PlayTests::BestTime( [&]
+		{
+			for( const Point2f& from : vFrom )
+				CollisionGrid::Query( from + move, RADIUS, CollisionGrid::INDEXED_TYPES, vResults );
+		} );
+		const double sweptTime = PlayTests::BestTime( [&]
+		{
+			for( const Point2f& from : vFrom )
+				CollisionGrid::QuerySwept( from, from + move, RADIUS, CollisionGrid::INDEXED_TYPES, vHits );
+		} );
+		PlayTests::Report( "%5d objects: point query %.2f us, swept query %.2f us", count, pointTime / queries, sweptTime / queries );
+		GameObject::DestroyAll();
+	}
+
+	// The pair test on its own, batched and one at a time
+	const int pairs = 10000;
+	std::vector< float > vX( pairs ), vY( pairs ), vMoveX( pairs ), vMoveY( pairs ), vTimes( pairs );
+	std::uniform_real_distribution< float > speed( -10.0f, 10.0f );
+	for( int n = 0; n < pairs; n++ )
+	{
+		vX[n] = x( random );
+		vY[n] = y( random );
+		vMoveX[n] = speed( random );
+		vMoveY[n] = speed( random );
+	}
+	const double batchedTime = PlayTests::BestTime( [&]
+	{
+		CollisionGrid::SweptCircleTimes( { 640.0f, 360.0f }, move, RADIUS, vX.data(), vY.data(), vMoveX.data(), vMoveY.data(), pairs, vTimes.data() );
+	} );
+	const double scalarTime = PlayTests::BestTime( [&]
+	{
+		for( int n = 0; n < pairs; n++ )
+			vTimes[n] = CollisionGrid::SweptCircleTime( { 640.0f, 360.0f }, move, { vX[n], vY[n] }, { vMoveX[n], vMoveY[n] }, RADIUS );
+	} );
+	PlayTests::Report( "pair test: batched %.2f ns, one at a time %.2f ns", batchedTime * 1000.0 / pairs, scalarTime * 1000.0 / pairs );
+}
+
+PT_BENCHMARK( GridQueryRate )
+{
+	// Queries at the player's radius among meteors, asteroids and gems spread over the torus, against testing every one of
+	// them as the game did before the grid
+	PlayTests::Random random( 10 );
+	std::uniform_real_distribution< float > x( CollisionGrid::TORUS_LEFT, CollisionGrid::TORUS_LEFT + CollisionGrid::TORUS_WIDTH );
+	std::uniform_real_distribution< float > y( CollisionGrid::TORUS_TOP, CollisionGrid::TORUS_TOP + CollisionGrid::TORUS_HEIGHT );
+	const int queries = 1000;
+	std::vector< Point2f > vPos( queries );
+	for( Point2f& pos : vPos )
+		pos = { x( random ), y( random ) };
+	const GameObject::Type types[] = { GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM };
+
+	const int counts[] = { 1000, 10000, 100000 };
+	for( int count : counts )
+	{
+		for( int n = 0; n < count; n++ )
+			AddTarget( { x( random ), y( random ) }, types[n % 3] );
+		const double buildTime = PlayTests::BestTime( [] { CollisionGrid::Build(); } );
+
+		int gridHits = 0, scanHits = 0;
+		std::vector< GameObject* > vResults;
+		const double gridTime = PlayTests::BestTime( [&]
+		{
+			gridHits = 0;
+			for( const Point2f& pos : vPos )
+				gridHits += CollisionGrid::Query( pos, RADIUS, CollisionGrid::INDEXED_TYPES, vResults );
+		} );
+		const double scanTime = PlayTests::BestTime( [&]
+		{
+			scanHits = 0;
+			for( const Point2f& pos : vPos )
+			{
+				for( GameObject::Type type : types )
+				{
+					for( GameObject* p : GameObject::GetTypeView( type ) )
+						scanHits += CollisionGrid::TorusDistanceSq( pos, p->GetPosition() ) < RADIUS * RADIUS;
+				}
+			}
+		}, 3 );
+
+		PlayTests::Report( "%6d objects: build %.2f ms, grid %7.1fk queries/s, linear scan %7.1fk queries/s",
+			count, buildTime / 1000.0, queries * 1000.0 / gridTime, queries * 1000.0 / scanTime );
+		PT_CHECK( gridHits == scanHits );
+		GameObject::DestroyAll();
+	}
+}
+
+PT_BENCHMARK( SeamCost )
+{
+	// What wrapping round the torus adds: the ghost entries, queries which reach across a seam against ones which don't,
+	// and the torus distance against a plain one
+	PlayTests::Random random( 11 );
+	const float left = CollisionGrid::TORUS_LEFT, top = CollisionGrid::TORUS_TOP;
+	const float width = CollisionGrid::TORUS_WIDTH, height = CollisionGrid::TORUS_HEIGHT;
+	std::uniform_real_distribution< float > x( left, left + width );
+	std::uniform_real_distribution< float > y( top, top + height );
+	std::uniform_real_distribution< float > unit( 0.0f, 1.0f );
+
+	// Half the seam queries are near a left or right edge and half near a top or bottom one
+	const int queries = 1000;
+	std::vector< Point2f > vSeam( queries ), vMiddle( queries );
+	for( int n = 0; n < queries; n++ )
+	{
+		const float edge = unit( random ) * RADIUS;
+		const bool far = random() % 2 == 0;
+		if( n % 2 )
+			vSeam[n] = { far ? left + width - edge : left + edge, y( random ) };
+		else
+			vSeam[n] = { x( random ), far ? top + height - edge : top + edge };
+		vMiddle[n] = { left + 2 * RADIUS + unit( random ) * ( width - 4 * RADIUS ), top + 2 * RADIUS + unit( random ) * ( height - 4 * RADIUS ) };
+	}
+
+	const int counts[] = { 1000, 10000, 100000 };
+	for( int count : counts )
+	{
+		for( int n = 0; n < count; n++ )
+			AddTarget( { x( random ), y( random ) } );
+		CollisionGrid::Build();
+
+		std::vector< GameObject* > vResults;
+		const double seamTime = PlayTests::BestTime( [&]
+		{
+			for( const Point2f& pos : vSeam )
+				CollisionGrid::Query( pos, RADIUS, CollisionGrid::INDEXED_TYPES, vResults );
+		} );
+		const double middleTime = PlayTests::BestTime( [&]
+		{
+			for( const Point2f& pos : vMiddle )
+				CollisionGrid::Query( pos, RADIUS, CollisionGrid::INDEXED_TYPES, vResults );
+		} );
+		PlayTests::Report( "%6d objects: %6d entries with ghosts, query across a seam %.2f us, away from the seams %.2f us",
+			count, CollisionGrid::GetEntryCount(), seamTime / queries, middleTime / queries );
+		GameObject::DestroyAll();
+	}
+
+	// The pair test on its own
+	const int pairs = 10000;
+	std::vector< Point2f > vA( pairs ), vB( pairs );
+	std::vector< float > vDistances( pairs );
+	for( int n = 0; n < pairs; n++ )
+	{
+		vA[n] = { x( random ), y( random ) };
+		vB[n] = { x( random ), y( random ) };
+	}
+	const double plainTime = PlayTests::BestTime( [&]
+	{
+		for( int n = 0; n < pairs; n++ )
+		{
+			const Vector2f d = vB[n] - vA[n];
+			vDistances[n] = d.x * d.x + d.y * d.y;
+		}
+	} );
+	const double torusTime = PlayTests::BestTime( [&]
+	{
+		for( int n = 0; n < pairs; n++ )
+			vDistances[n] = CollisionGrid::TorusDistanceSq( vA[n], vB[n] );
+	} );
+	PlayTests::Report( "squared distance: plain %.2f ns, torus %.2f ns", plainTime * 1000.0 / pairs, torusTime * 1000.0 / pairs );
+}
+
+PT_BENCHMARK( ContactStageCost )
+{
+	// Meteors, asteroids and gems spread over the torus and drifting at up to asteroid speed, with circle tests between
+	// meteors and asteroids, meteors and meteors, asteroids and gems, and gems and gems
+	PlayTests::Random random( 15 );
+	std::uniform_real_distribution< float > x( CollisionGrid::TORUS_LEFT, CollisionGrid::TORUS_LEFT + CollisionGrid::TORUS_WIDTH );
+	std::uniform_real_distribution< float > y( CollisionGrid::TORUS_TOP, CollisionGrid::TORUS_TOP + CollisionGrid::TORUS_HEIGHT );
+	std::uniform_real_distribution< float > speed( -5.0f, 5.0f );
+	const GameObject::Type types[] = { GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM };
+
+	CollisionGrid::ClearContactPairs();
+	CollisionGrid::SetContactPair( GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID, CollisionGrid::NARROW_CIRCLE );
+	CollisionGrid::SetContactPair( GameObject::OBJ_METEOR, GameObject::OBJ_METEOR, CollisionGrid::NARROW_CIRCLE );
+	CollisionGrid::SetContactPair( GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM, CollisionGrid::NARROW_CIRCLE );
+	CollisionGrid::SetContactPair( GameObject::OBJ_GEM, GameObject::OBJ_GEM, CollisionGrid::NARROW_CIRCLE );
+	const uint64_t pairMask = CollisionGrid::PairBit( GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID ) |
+		CollisionGrid::PairBit( GameObject::OBJ_METEOR, GameObject::OBJ_METEOR ) |
+		CollisionGrid::PairBit( GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM ) |
+		CollisionGrid::PairBit( GameObject::OBJ_GEM, GameObject::OBJ_GEM );
+
+	GameState state;
+	const int counts[] = { 500, 1000, 2000, 5000 };
+	for( int count : counts )
+	{
+		std::vector< GameObject* > vObjects( count );
+		for( int n = 0; n < count; n++ )
+		{
+			const Point2f pos = { x( random ), y( random ) };
+			vObjects[n] = new TestTarget( pos - Vector2f( speed( random ), speed( random ) ), pos, types[n % 3] );
+		}
+
+		const double stageTime = PlayTests::BestTime( [&]
+		{
+			CollisionGrid::Build();
+			CollisionGrid::FindContacts( state );
+		} );
+		PlayTests::Report( "%4d objects: build and find contacts %.2f ms, %d contacts", count, stageTime / 1000.0, CollisionGrid::GetContactCount() );
+
+		// Every pair tested against each other with no grid, once as it takes so long
+		if( count == 5000 )
+		{
+			int bruteContacts = 0;
+			const double bruteTime = PlayTests::BestTime( [&]
+			{
+				for( int a = 0; a < count; a++ )
+				{
+					const GameObject* pA = vObjects[a];
+					for( int b = a + 1; b < count; b++ )
+					{
+						const GameObject* pB = vObjects[b];
+						if( !( CollisionGrid::PairBit( pA->GetType(), pB->GetType() ) & pairMask ) )
+							continue;
+						const float time = CollisionGrid::SweptCircleTime( pA->GetPrevPosition(), pA->GetPosition() - pA->GetPrevPosition(),
+							pB->GetPrevPosition(), pB->GetPosition() - pB->GetPrevPosition(), RADIUS );
+						bruteContacts += time >= 0.0f;
+					}
+				}
+			}, 1 );
+			PlayTests::Report( "%4d objects: every pair tested %.2f ms, %d contacts", count, bruteTime / 1000.0, bruteContacts );
+			PT_CHECK( bruteContacts == CollisionGrid::GetContactCount() );
+		}
+		GameObject::DestroyAll();
+	}
+
+	CollisionGrid::ClearContactPairs();
+}
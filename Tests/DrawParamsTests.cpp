@@ -0,0 +1,173 @@
+//********************************************************************************************************************************
+// File:		DrawParamsTests.cpp
+// Description:	Checks that tinted draws leave the sprite's pixels alone and match recoloured ones, and that flips and origin
+//				overrides move the pixels where they should, and benchmarks a tinted DrawSpriteLine against recolouring the pen
+//				sprite with ColourSprite as it used to
+//********************************************************************************************************************************
+
+// Play::DrawSpriteLine is part of the PlayManager, so this file uses the manager as PlayTests.cpp does
+#define PLAY_USING_GAMEOBJECT_MANAGER
+#define GameObject PlayManagerObject
+#include "PlayTests.h"
+#undef GameObject
+
+namespace
+{
+	// A copy of all of a sprite's pre-multiplied pixels
+	std::vector< uint32_t > PreMultipliedPixels( int spriteId )
+	{
+		const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( PlayTests::Blitter(), spriteId );
+		return std::vector< uint32_t >( spr.pPreMultAlpha, spr.pPreMultAlpha + static_cast<size_t>( spr.frameStride ) * spr.height * spr.totalCount );
+	}
+
+	// A copy of the whole display buffer
+	std::vector< uint32_t > DisplayPixels()
+	{
+		return std::vector< uint32_t >( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT );
+	}
+
+	// A copy of a rectangle of the display buffer, row by row
+	std::vector< uint32_t > DisplayBlock( int left, int top, int width, int height )
+	{
+		std::vector< uint32_t > vBlock;
+		for( int y = top; y < top + height; y++ )
+			vBlock.insert( vBlock.end(), PlayTests::DisplayBuffer() + y * PlayTests::DISPLAY_WIDTH + left, PlayTests::DisplayBuffer() + y * PlayTests::DISPLAY_WIDTH + left + width );
+		return vBlock;
+	}
+
+	// Fills the display buffer with one colour, so a draw can be compared with another one in a different place
+	void FillDisplayBuffer( uint32_t colour )
+	{
+		std::fill( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT, colour );
+	}
+}
+
+PT_TEST( TintedSpriteLineLeavesSpriteAlone )
+{
+	// DrawSpriteLine finds its pen with FindSpriteId, so the pen is looked up the same way here
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int pen = blit.FindSpriteId( "particle" );
+	const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( blit, pen );
+	const uint32_t* pPixelsBefore = spr.pPreMultAlpha;
+	const std::vector< uint32_t > pixelsBefore = PreMultipliedPixels( pen );
+
+	PlayTests::ClearDisplayBuffer();
+	const std::vector< uint32_t > empty( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT );
+	Play::DrawSpriteLine( { 100.0f, 100.0f }, { 500.0f, 300.0f }, "particle", Play::cRed );
+
+	PT_CHECK( !std::equal( empty.begin(), empty.end(), PlayTests::DisplayBuffer() ) );
+	PT_CHECK( spr.pPreMultAlpha == pPixelsBefore );
+	PT_CHECK( PreMultipliedPixels( pen ) == pixelsBefore );
+}
+
+PT_TEST( TintedDrawMatchesColourSprite )
+{
+	// A tinted draw must come out within one step per channel of the same sprite recoloured with ColourSprite (see TintRow)
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int id = blit.GetSpriteId( "gem" );
+	const Point2f pos = { 300.0f, 200.0f };
+	const Play::Colour colours[] = { Play::cRed, Play::cOrange, Play::cCyan, { 30.0f, 60.0f, 90.0f } };
+
+	PlayTests::ClearDisplayBuffer();
+	blit.Draw( id, pos, 0 );
+	const std::vector< uint32_t > plain = DisplayPixels();
+
+	int worst = 0, unchanged = 0;
+	for( const Play::Colour& c : colours )
+	{
+		PlayTests::ClearDisplayBuffer();
+		blit.Draw( id, pos, 0, Play::TintParams( c ) );
+		const std::vector< uint32_t > tinted = DisplayPixels();
+		unchanged += tinted == plain;
+
+		blit.ColourSprite( id, static_cast<int>( c.red * 2.55f ), static_cast<int>( c.green * 2.55f ), static_cast<int>( c.blue * 2.55f ) );
+		PlayTests::ClearDisplayBuffer();
+		blit.Draw( id, pos, 0 );
+		blit.ColourSprite( id, 255, 255, 255 );
+
+		const uint32_t* pRecoloured = PlayTests::DisplayBuffer();
+		for( size_t p = 0; p < tinted.size(); p++ )
+		{
+			for( int shift : { 0, 8, 16 } )
+				worst = std::max( worst, std::abs( static_cast<int>( ( tinted[p] >> shift ) & 0xFF ) - static_cast<int>( ( pRecoloured[p] >> shift ) & 0xFF ) ) );
+		}
+	}
+	PT_CHECK( unchanged == 0 );
+	PT_CHECK( worst <= 1 );
+}
+
+PT_TEST( FlippedAndOriginDrawsMovePixels )
+{
+	// An unrotated draw flipped either way (or both) must be the plain draw mirrored about the origin, and one with an origin
+	// override must be the plain draw moved by the difference between the origins
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int id = blit.GetSpriteId( "meteor_2" );
+	const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( blit, id );
+	const int width = spr.width, height = spr.height;
+	const int posX = 640, posY = 360;
+	const uint32_t background = 0xFF203040;
+
+	PlayBlitter::DrawParams params;
+	params.useOrigin = true;
+	params.origin = { 30.0f, 170.0f };
+	FillDisplayBuffer( background );
+	blit.Draw( id, { static_cast<float>( posX ), static_cast<float>( posY ) }, 0, params );
+	const std::vector< uint32_t > overridden = DisplayPixels();
+	const std::vector< uint32_t > plain = DisplayBlock( posX - 30, posY - 170, width, height );
+
+	int failures = 0;
+	for( int flips = 1; flips < 4; flips++ )
+	{
+		params.flipX = ( flips & 1 ) != 0;
+		params.flipY = ( flips & 2 ) != 0;
+		FillDisplayBuffer( background );
+		blit.Draw( id, { static_cast<float>( posX ), static_cast<float>( posY ) }, 0, params );
+
+		// The origin is as far from the right and bottom of the flipped sprite as it was from the left and top
+		const int left = posX - ( params.flipX ? width - 30 : 30 );
+		const int top = posY - ( params.flipY ? height - 170 : 170 );
+		const std::vector< uint32_t > flipped = DisplayBlock( left, top, width, height );
+		for( int y = 0; y < height; y++ )
+		{
+			for( int x = 0; x < width; x++ )
+			{
+				const int plainX = params.flipX ? width - 1 - x : x;
+				const int plainY = params.flipY ? height - 1 - y : y;
+				failures += flipped[y * width + x] != plain[plainY * width + plainX];
+			}
+		}
+	}
+	PT_CHECK( failures == 0 );
+
+	// The same draw with the sprite's own origin, moved to put the sprite in the same place
+	FillDisplayBuffer( background );
+	blit.Draw( id, { static_cast<float>( posX - 30 + spr.originX ), static_cast<float>( posY - 170 + spr.originY ) }, 0 );
+	PT_CHECK( DisplayPixels() == overridden );
+	PT_CHECK( std::count( overridden.begin(), overridden.end(), background ) < static_cast<int>( overridden.size() ) );
+}
+
+PT_BENCHMARK( TintedSpriteLineCost )
+{
+	// A 400 pixel wide line drawn with a tint, against recolouring the pen and drawing the line untinted, which is what
+	// DrawSpriteLine used to do on every call
+	PlayBlitter& blit = PlayTests::Blitter();
+	const char* pens[] = { "particle", "gem", "asteroid_2" };
+	const Point2f start = { 200.0f, 100.0f }, end = { 600.0f, 350.0f };
+
+	for( const char* pen : pens )
+	{
+		const int id = blit.FindSpriteId( pen );
+		const double plain = PlayTests::BestTime( [&] { Play::DrawSpriteLine( start, end, pen, Play::cWhite ); } );
+		const double tinted = PlayTests::BestTime( [&] { Play::DrawSpriteLine( start, end, pen, Play::cRed ); } );
+		const double recolour = PlayTests::BestTime( [&] { blit.ColourSprite( id, 255, 0, 0 ); } );
+		const double recoloured = PlayTests::BestTime( [&]
+		{
+			blit.ColourSprite( id, 255, 0, 0 );
+			Play::DrawSpriteLine( start, end, pen, Play::cWhite );
+		} );
+		blit.ColourSprite( id, 255, 255, 255 );
+
+		PlayTests::Report( "%-10s line %7.1f us, tinted %7.1f us, ColourSprite then line %7.1f us (ColourSprite alone %7.1f us)",
+			pen, plain, tinted, recoloured, recolour );
+	}
+}
@@ -0,0 +1,156 @@
+//********************************************************************************************************************************
+// File:		DrawThreadTests.cpp
+// Description:	Checks that batched draws split into bands and shared between draw threads match drawing straight away,
+//				and benchmarks how EndBatch scales with the number of draw threads
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+namespace
+{
+	// Makes a random mixture of every kind of sprite draw, including ones partly off the display buffer
+	void DrawRandomScene( int seed, int draws )
+	{
+		PlayBlitter& blit = PlayTests::Blitter();
+		PlayTests::Random random( seed );
+		std::uniform_real_distribution< float > x( -150.0f, PlayTests::DISPLAY_WIDTH + 150.0f );
+		std::uniform_real_distribution< float > y( -150.0f, PlayTests::DISPLAY_HEIGHT + 150.0f );
+		std::uniform_real_distribution< float > unit( 0.0f, 1.0f );
+
+		for( int n = 0; n < draws; n++ )
+		{
+			const int spriteId = random() % blit.GetTotalLoadedSprites();
+			const int frame = random() % blit.GetSpriteFrames( spriteId );
+			const Point2f pos{ x( random ), y( random ) };
+
+			PlayBlitter::DrawParams params;
+			if( random() % 3 == 0 )
+				params.alphaMultiply = unit( random );
+			if( random() % 4 == 0 )
+				params.tint = random() & 0x00FFFFFF;
+			params.flipX = random() % 4 == 0;
+
+			switch( random() % 4 )
+			{
+				case 0: blit.Draw( spriteId, pos, frame ); break;
+				case 1: blit.Draw( spriteId, pos, frame, params ); break;
+				case 2: blit.DrawRotated( spriteId, pos, frame, unit( random ) * 2 * PLAY_PI, 1.0f, params ); break;
+				case 3: blit.DrawRotated( spriteId, pos, frame, unit( random ) * 2 * PLAY_PI, 0.5f + unit( random ) * 1.5f, params ); break;
+			}
+		}
+	}
+
+	// Draws a random scene straight away, or recorded in a batch, and returns the result
+	std::vector< uint32_t > RenderScene( int seed, int draws, bool batched )
+	{
+		PlayBlitter& blit = PlayTests::Blitter();
+		PlayTests::ClearDisplayBuffer();
+		if( batched )
+			blit.BeginBatch();
+		DrawRandomScene( seed, draws );
+		if( batched )
+			blit.EndBatch();
+		return std::vector< uint32_t >( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT );
+	}
+
+	// Enough threads for several to be working on neighbouring bands at once, even on a machine with fewer cores
+	int ManyThreads()
+	{
+		return std::max( 4, static_cast<int>( std::thread::hardware_concurrency() ) );
+	}
+}
+
+PT_TEST( BatchedDrawsMatchOnAnyNumberOfThreads )
+{
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int threadsBefore = blit.GetDrawThreads();
+
+	// The draws made straight away aren't clipped to bands, so they are the reference for the batched ones
+	// > With the rotation cache on, rotated draws blit cached frames instead, which are checked in the same way
+	const int cacheSteps[] = { 0, 64 };
+	for( int steps : cacheSteps )
+	{
+		blit.SetRotationCache( steps, 8 * 1024 * 1024 );
+		const std::vector< uint32_t > empty = RenderScene( 0, 0, false );
+		for( int scene = 0; scene < 6; scene++ )
+		{
+			const std::vector< uint32_t > immediate = RenderScene( scene, 300, false );
+			PT_CHECK( immediate != empty );
+
+			blit.SetDrawThreads( 1 );
+			PT_CHECK( RenderScene( scene, 300, true ) == immediate );
+
+			blit.SetDrawThreads( ManyThreads() );
+			PT_CHECK( RenderScene( scene, 300, true ) == immediate );
+		}
+	}
+
+	blit.SetRotationCache( 0, 0 );
+	blit.SetDrawThreads( threadsBefore );
+}
+
+PT_TEST( BatchedDrawsMatchWhenTheCacheEvictsMidBatch )
+{
+	// A budget too small for the scene's rotated frames makes the cache free frames that earlier draws in the batch use
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int threadsBefore = blit.GetDrawThreads();
+	blit.SetRotationCache( 256, 256 * 1024 );
+
+	const std::vector< uint32_t > immediate = RenderScene( 100, 400, false );
+	blit.SetDrawThreads( ManyThreads() );
+	PT_CHECK( RenderScene( 100, 400, true ) == immediate );
+	PT_CHECK( blit.GetRotationCacheStats().evictions > 0 );
+
+	blit.SetRotationCache( 0, 0 );
+	blit.SetDrawThreads( threadsBefore );
+}
+
+PT_BENCHMARK( DrawThreadScaling )
+{
+	// A busy game frame: asteroids, meteors and gems drawn rotated, and particles drawn transparent
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int threadsBefore = blit.GetDrawThreads();
+	const int asteroid = blit.GetSpriteId( "asteroid_2" );
+	const int meteor = blit.GetSpriteId( "meteor_2" );
+	const int gem = blit.GetSpriteId( "gem" );
+	const int particle = blit.GetSpriteId( "particle" );
+
+	PlayTests::Random random( 20 );
+	std::uniform_real_distribution< float > x( 0.0f, static_cast<float>( PlayTests::DISPLAY_WIDTH ) );
+	std::uniform_real_distribution< float > y( 0.0f, static_cast<float>( PlayTests::DISPLAY_HEIGHT ) );
+	std::uniform_real_distribution< float > angle( 0.0f, 2 * PLAY_PI );
+	struct Placed { int spriteId; Point2f pos; float angle; };
+	std::vector< Placed > vDraws;
+	for( int n = 0; n < 500; n++ ) vDraws.push_back( { asteroid, { x( random ), y( random ) }, angle( random ) } );
+	for( int n = 0; n < 200; n++ ) vDraws.push_back( { meteor, { x( random ), y( random ) }, angle( random ) } );
+	for( int n = 0; n < 300; n++ ) vDraws.push_back( { gem, { x( random ), y( random ) }, angle( random ) } );
+	for( int n = 0; n < 3000; n++ ) vDraws.push_back( { particle, { x( random ), y( random ) }, -1.0f } );
+
+	auto drawFrame = [&]()
+	{
+		for( const Placed& d : vDraws )
+		{
+			if( d.angle < 0 )
+				blit.DrawTransparent( d.spriteId, d.pos, 0, 0.5f );
+			else
+				blit.DrawRotated( d.spriteId, d.pos, 0, d.angle );
+		}
+	};
+
+	const double immediate = PlayTests::BestTime( drawFrame, 5 );
+	PlayTests::Report( "%d draws straight away: %.2f ms", static_cast<int>( vDraws.size() ), immediate / 1000.0 );
+
+	const int maxThreads = std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) );
+	for( int threads = 1; threads <= maxThreads; threads++ )
+	{
+		blit.SetDrawThreads( threads );
+		const double batched = PlayTests::BestTime( [&]
+		{
+			blit.BeginBatch();
+			drawFrame();
+			blit.EndBatch();
+		}, 5 );
+		PlayTests::Report( "batched on %2d threads: %.2f ms (%.2fx straight away)", threads, batched / 1000.0, immediate / batched );
+	}
+
+	blit.SetDrawThreads( threadsBefore );
+}
@@ -0,0 +1,326 @@
+//********************************************************************************************************************************
+// File:		GameObjectTests.cpp
+// Description:	Checks and benchmarks the GameObject registry: the update and draw layers, the type index, and creating and
+//				destroying objects
+//********************************************************************************************************************************
+#include "PlayTests.h"
+#include "../GameObject.h"
+
+namespace
+{
+	// An object with an update and a draw which do next to nothing, so the timings are all the registry's own work
+	class TestObject : public GameObject
+	{
+	public:
+		TestObject( Point2f pos ) : GameObject( pos ) {}
+		void Update( GameState& state ) override { (void)state; m_updates++; }
+		void Draw( GameState& state ) const override { (void)state; m_draws++; }
+
+		int m_updates{ 0 };
+		mutable int m_draws{ 0 };
+	};
+
+	// Makes objects spread over the update and draw orders the game uses, in a random order
+	std::vector< TestObject* > MakeObjects( int count, int seed )
+	{
+		PlayTests::Random random( seed );
+		std::vector< TestObject* > vObjects( count );
+		for( TestObject*& p : vObjects )
+		{
+			p = new TestObject( { 0.0f, 0.0f } );
+			p->SetUpdateOrder( random() % 5 );
+			p->SetDrawOrder( random() % 7 );
+		}
+		return vObjects;
+	}
+
+	// The objects visited by the latest UpdateAll and DrawAll, in the order they were visited
+	std::vector< const GameObject* >& UpdateLog() { static std::vector< const GameObject* > vLog; return vLog; }
+	std::vector< const GameObject* >& DrawLog() { static std::vector< const GameObject* > vLog; return vLog; }
+
+	// An object which logs its updates and draws, and can check that its slots point back at it
+	class LoggedObject : public GameObject
+	{
+	public:
+		LoggedObject( Type type, int updateOrder, int drawOrder ) : GameObject( { 0.0f, 0.0f } )
+		{
+			SetType( type );
+			SetUpdateOrder( updateOrder );
+			SetDrawOrder( drawOrder );
+		}
+		void Update( GameState& state ) override { (void)state; UpdateLog().push_back( this ); }
+		void Draw( GameState& state ) const override { (void)state; DrawLog().push_back( this ); }
+
+		bool InItsSlots() const
+		{
+			if( m_updateOrder == NO_UPDATE ? m_updateSlot != -1 : !InSlot( s_vUpdateLayers[m_updateOrder], m_updateSlot ) )
+				return false;
+			return InSlot( s_vDrawLayers[m_drawOrder], m_drawSlot ) && InSlot( TypeList( m_type ), m_typeSlot );
+		}
+
+		// Whether every layer and type list is free of the empty slots left by destroyed or moved objects
+		static bool Compacted()
+		{
+			for( int order = 0; order < MAX_ORDERS; order++ )
+			{
+				if( std::count( s_vUpdateLayers[order].begin(), s_vUpdateLayers[order].end(), nullptr ) > 0 ||
+					std::count( s_vDrawLayers[order].begin(), s_vDrawLayers[order].end(), nullptr ) > 0 )
+					return false;
+			}
+			for( const std::vector< GameObject* >& vList : s_vTypeLists )
+			{
+				if( std::count( vList.begin(), vList.end(), nullptr ) > 0 )
+					return false;
+			}
+			return true;
+		}
+
+	private:
+		bool InSlot( const std::vector< GameObject* >& vList, int slot ) const
+		{
+			return slot >= 0 && slot < static_cast<int>( vList.size() ) && vList[slot] == this;
+		}
+	};
+
+	// What the registry should hold, kept alongside it: each layer in the order objects joined it, and every live object
+	struct RegistryModel
+	{
+		std::vector< LoggedObject* > vUpdateLayers[GameObject::MAX_ORDERS];
+		std::vector< LoggedObject* > vDrawLayers[GameObject::MAX_ORDERS];
+		std::vector< LoggedObject* > vLive;
+
+		LoggedObject* Create( GameObject::Type type, int updateOrder, int drawOrder )
+		{
+			LoggedObject* p = new LoggedObject( type, updateOrder, drawOrder );
+			if( updateOrder != GameObject::NO_UPDATE )
+				vUpdateLayers[updateOrder].push_back( p );
+			vDrawLayers[drawOrder].push_back( p );
+			vLive.push_back( p );
+			return p;
+		}
+
+		void MoveDrawOrder( LoggedObject* p, int drawOrder )
+		{
+			if( drawOrder == p->GetDrawOrder() )
+				return;
+			std::vector< LoggedObject* >& vOld = vDrawLayers[p->GetDrawOrder()];
+			vOld.erase( std::find( vOld.begin(), vOld.end(), p ) );
+			vDrawLayers[drawOrder].push_back( p );
+			p->SetDrawOrder( drawOrder );
+		}
+
+		// The active objects, highest order first and in the order they joined each layer
+		std::vector< const GameObject* > Expected( const std::vector< LoggedObject* >* vLayers ) const
+		{
+			std::vector< const GameObject* > vExpected;
+			for( int order = GameObject::MAX_ORDERS - 1; order >= 0; order-- )
+			{
+				for( LoggedObject* p : vLayers[order] )
+				{
+					if( p->GetActive() )
+						vExpected.push_back( p );
+				}
+			}
+			return vExpected;
+		}
+
+		// Forgets the given objects once the registry has destroyed them (without touching them)
+		void Forget( const std::vector< LoggedObject* >& vDead )
+		{
+			auto dead = [&]( LoggedObject* p ) { return std::find( vDead.begin(), vDead.end(), p ) != vDead.end(); };
+			for( int order = 0; order < GameObject::MAX_ORDERS; order++ )
+			{
+				vUpdateLayers[order].erase( std::remove_if( vUpdateLayers[order].begin(), vUpdateLayers[order].end(), dead ), vUpdateLayers[order].end() );
+				vDrawLayers[order].erase( std::remove_if( vDrawLayers[order].begin(), vDrawLayers[order].end(), dead ), vDrawLayers[order].end() );
+			}
+			vLive.erase( std::remove_if( vLive.begin(), vLive.end(), dead ), vLive.end() );
+		}
+
+		// Whether the type view and count for each type hold exactly the live objects of that type
+		bool TypesMatch() const
+		{
+			if( GameObject::GetObjectCount( GameObject::OBJ_ALL ) != static_cast<int>( vLive.size() ) )
+				return false;
+
+			for( int type = GameObject::OBJ_NONE; type < GameObject::OBJ_TYPE_COUNT; type++ )
+			{
+				std::vector< const GameObject* > vExpected, vViewed;
+				for( LoggedObject* p : vLive )
+				{
+					if( p->GetType() == type )
+						vExpected.push_back( p );
+				}
+				for( GameObject* p : GameObject::GetTypeView( static_cast<GameObject::Type>( type ) ) )
+					vViewed.push_back( p );
+
+				std::sort( vExpected.begin(), vExpected.end() );
+				std::sort( vViewed.begin(), vViewed.end() );
+				if( vViewed != vExpected || GameObject::GetObjectCount( static_cast<GameObject::Type>( type ) ) != static_cast<int>( vExpected.size() ) )
+					return false;
+			}
+			return true;
+		}
+	};
+}
+
+PT_TEST( RegistryStaysConsistent )
+{
+	// Objects are created, moved, killed (and sometimes revived) in random orders over several frames, and after each frame
+	// the visit orders, the type views and every object's slots are checked against a model of what the registry should hold.
+	// Then everything is deactivated but one revived object, which takes the whole-world reclaim, and the registry is reused
+	GameState state;
+	PlayTests::Random random( 25 );
+	const GameObject::Type types[] = { GameObject::OBJ_NONE, GameObject::OBJ_METEOR, GameObject::OBJ_ASTEROID, GameObject::OBJ_GEM };
+	RegistryModel model;
+
+	auto runFrame = [&]
+	{
+		const std::vector< const GameObject* > vExpectedUpdates = model.Expected( model.vUpdateLayers );
+		std::vector< LoggedObject* > vDead;
+		for( LoggedObject* p : model.vLive )
+		{
+			if( !p->GetActive() )
+				vDead.push_back( p );
+		}
+
+		UpdateLog().clear();
+		GameObject::UpdateAll( state );
+		PT_CHECK( UpdateLog() == vExpectedUpdates );
+		model.Forget( vDead );
+
+		DrawLog().clear();
+		GameObject::DrawAll( state );
+		PT_CHECK( DrawLog() == model.Expected( model.vDrawLayers ) );
+
+		PT_CHECK( LoggedObject::Compacted() );
+		PT_CHECK( std::all_of( model.vLive.begin(), model.vLive.end(), []( const LoggedObject* p ) { return p->InItsSlots(); } ) );
+		PT_CHECK( model.TypesMatch() );
+	};
+
+	for( int frame = 0; frame < 8; frame++ )
+	{
+		for( int n = 0; n < 200; n++ )
+		{
+			const int updateOrder = random() % 6 == 0 ? GameObject::NO_UPDATE : static_cast<int>( random() % GameObject::MAX_ORDERS );
+			model.Create( types[random() % 4], updateOrder, random() % GameObject::MAX_ORDERS );
+		}
+
+		std::vector< LoggedObject* > vShuffled = model.vLive;
+		std::shuffle( vShuffled.begin(), vShuffled.end(), random );
+		for( size_t n = 0; n < vShuffled.size() / 3; n++ )
+		{
+			LoggedObject* p = vShuffled[n];
+			switch( random() % 4 )
+			{
+				case 0: model.MoveDrawOrder( p, random() % GameObject::MAX_ORDERS ); break;
+				case 1: p->SetType( types[random() % 4] ); break;
+				case 2: p->SetActive( false ); break;
+				case 3: p->SetActive( false ); p->SetActive( true ); break;
+			}
+		}
+		runFrame();
+	}
+
+	// Everything goes at once, apart from one object revived after being queued
+	LoggedObject* pSurvivor = model.vLive[random() % model.vLive.size()];
+	GameObject::DeactivateAll();
+	pSurvivor->SetActive( true );
+	runFrame();
+	PT_CHECK( model.vLive.size() == 1 && GameObject::GetObjectCount( GameObject::OBJ_ALL ) == 1 );
+
+	// Then with no survivors the registry is left empty
+	pSurvivor->SetActive( false );
+	runFrame();
+	PT_CHECK( GameObject::GetObjectCount( GameObject::OBJ_ALL ) == 0 && UpdateLog().empty() && DrawLog().empty() );
+
+	// And it can be used again straight away
+	for( int n = 0; n < 50; n++ )
+		model.Create( types[n % 4], n % GameObject::MAX_ORDERS, ( n * 3 ) % GameObject::MAX_ORDERS );
+	runFrame();
+	PT_CHECK( DrawLog().size() == 50 );
+
+	GameObject::DestroyAll();
+}
+
+PT_BENCHMARK( LayerWalkCost )
+{
+	// The layers walked by UpdateAll and DrawAll, against sorting one list by order every frame as they used to
+	// > The sorted lists are kept from frame to frame like the old ones, so after the first frame they're already in order
+	GameState state;
+	const int counts[] = { 10000, 100000 };
+	for( int count : counts )
+	{
+		std::vector< TestObject* > vObjects = MakeObjects( count, count );
+		std::vector< GameObject* > vUpdateList( vObjects.begin(), vObjects.end() );
+		std::vector< GameObject* > vDrawList( vObjects.begin(), vObjects.end() );
+
+		const double sortedUpdate = PlayTests::BestTime( [&]
+		{
+			std::sort( vUpdateList.begin(), vUpdateList.end(), []( const GameObject* a, const GameObject* b ) { return a->GetUpdateOrder() > b->GetUpdateOrder(); } );
+			for( GameObject* p : vUpdateList )
+				p->Update( state );
+		} );
+		const double layeredUpdate = PlayTests::BestTime( [&] { GameObject::UpdateAll( state ); } );
+
+		const double sortedDraw = PlayTests::BestTime( [&]
+		{
+			std::sort( vDrawList.begin(), vDrawList.end(), []( const GameObject* a, const GameObject* b ) { return a->GetDrawOrder() > b->GetDrawOrder(); } );
+			for( GameObject* p : vDrawList )
+				p->Draw( state );
+		} );
+		const double layeredDraw = PlayTests::BestTime( [&] { GameObject::DrawAll( state ); } );
+
+		PlayTests::Report( "%6d objects: update sorted %.3f ms, layered %.3f ms   draw sorted %.3f ms, layered %.3f ms",
+			count, sortedUpdate / 1000.0, layeredUpdate / 1000.0, sortedDraw / 1000.0, layeredDraw / 1000.0 );
+		GameObject::DestroyAll();
+	}
+}
+
+PT_BENCHMARK( DestroyCost )
+{
+	// 50k objects deactivated in a random order and destroyed at the end of one UpdateAll, alongside 50k which survive, and
+	// with nothing else left (which takes the path for the whole world being reset)
+	GameState state;
+	const int doomedCount = 50000;
+	auto timeDestroy = [&]( int seed )
+	{
+		double best = 1e30;
+		for( int run = 0; run < 5; run++ )
+		{
+			std::vector< TestObject* > vDoomed = MakeObjects( doomedCount, seed + run );
+			std::shuffle( vDoomed.begin(), vDoomed.end(), PlayTests::Random( seed ) );
+			for( TestObject* p : vDoomed )
+				p->SetActive( false );
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			GameObject::UpdateAll( state );
+			best = std::min( best, std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - start ).count() );
+		}
+		return best;
+	};
+
+	const double everything = timeDestroy( 1 );
+	MakeObjects( 50000, 2 );
+	const double nothing = PlayTests::BestTime( [&] { GameObject::UpdateAll( state ); } );
+	const double withSurvivors = timeDestroy( 3 );
+	PlayTests::Report( "UpdateAll destroying 50k of 100k objects: %.2f ms (%.2f ms destroying none of 50k)", withSurvivors / 1000.0, nothing / 1000.0 );
+	PlayTests::Report( "UpdateAll destroying all of 50k objects: %.2f ms", everything / 1000.0 );
+	GameObject::DestroyAll();
+
+	// The old destructor's std::find and erase on the update and draw lists, once as it takes so long
+	std::vector< GameObject* > vUpdateList( 2 * doomedCount ), vDrawList;
+	for( size_t n = 0; n < vUpdateList.size(); n++ )
+		vUpdateList[n] = reinterpret_cast<GameObject*>( ( n + 1 ) * 16 );
+	vDrawList = vUpdateList;
+	std::vector< GameObject* > vDoomed( vUpdateList.begin(), vUpdateList.begin() + doomedCount );
+	std::shuffle( vDoomed.begin(), vDoomed.end(), PlayTests::Random( 4 ) );
+	const double erased = PlayTests::BestTime( [&]
+	{
+		for( GameObject* p : vDoomed )
+		{
+			vDrawList.erase( std::find( vDrawList.begin(), vDrawList.end(), p ) );
+			vUpdateList.erase( std::find( vUpdateList.begin(), vUpdateList.end(), p ) );
+		}
+	}, 1 );
+	PlayTests::Report( "std::find and erase of 50k of 100k objects (the old way): %.2f ms", erased / 1000.0 );
+}
@@ -0,0 +1,41 @@
+//********************************************************************************************************************************
+// File:		MemoryTests.cpp
+// Description:	Benchmarks the memory tracker in Play.h
+// Notes:		The tracker is only compiled in when PLAY_MEMORY_TRACKING is on, which is the default for Debug builds
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+PT_BENCHMARK( TrackedDeleteCost )
+{
+#if PLAY_MEMORY_TRACKING
+	// The cost of a delete with more and more other allocations live, which should stay about the same
+	// > Each timing allocates a batch of small blocks, then times deleting them all
+	const int batch = 10000;
+	std::vector< char* > vBatch( batch );
+
+	for( int live = 100; live <= 1000000; live *= 10 )
+	{
+		std::vector< char* > vLive( live );
+		for( char*& p : vLive )
+			p = new char[16];
+
+		double best = 1e30;
+		for( int run = 0; run < 5; run++ )
+		{
+			for( char*& p : vBatch )
+				p = new char[16];
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for( char* p : vBatch )
+				delete[] p;
+			best = std::min( best, std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - start ).count() );
+		}
+		PlayTests::Report( "%7d live allocations: %.1f ns per delete", live, best * 1000.0 / batch );
+
+		for( char* p : vLive )
+			delete[] p;
+	}
+#else
+	PlayTests::Report( "The memory tracker is compiled out of this build (see PLAY_MEMORY_TRACKING), so there is nothing to time" );
+#endif
+}
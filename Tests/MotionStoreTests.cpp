@@ -0,0 +1,78 @@
+//********************************************************************************************************************************
+// File:		MotionStoreTests.cpp
+// Description:	Checks the SIMD integrate-and-wrap kernel in MotionStore against the scalar one, and benchmarks them both
+//********************************************************************************************************************************
+#include "PlayTests.h"
+#include "../MotionStore.h"
+
+namespace
+{
+	// Adds bodies spread just beyond every edge the wrap uses, half of them wrapping, and returns their slots
+	// > The slots are where MotionStore keeps each body's index up to date, so they mustn't move while the bodies exist
+	std::unique_ptr< int[] > AddBodies( int count, int seed )
+	{
+		PlayTests::Random random( seed );
+		std::uniform_real_distribution< float > x( -S_SCREEN_LIMIT - 20.0f, DISPLAY_WIDTH + S_SCREEN_LIMIT + 20.0f );
+		std::uniform_real_distribution< float > y( -20.0f, DISPLAY_HEIGHT + S_SCREEN_LIMIT + 20.0f );
+		std::uniform_real_distribution< float > speed( -10.0f, 10.0f );
+
+		std::unique_ptr< int[] > pSlots( new int[count] );
+		for( int n = 0; n < count; n++ )
+		{
+			const MotionStore::WrapMode wrap = random() % 2 ? MotionStore::WRAP_SCREEN : MotionStore::WRAP_NONE;
+			MotionStore::Add( &pSlots[n], { x( random ), y( random ) }, { speed( random ), speed( random ) }, wrap );
+		}
+		return pSlots;
+	}
+
+	// Removes every body, last first so none of them have to be moved
+	void RemoveAllBodies()
+	{
+		for( int slot = MotionStore::GetBodyCount() - 1; slot >= 0; slot-- )
+			MotionStore::Remove( slot );
+	}
+}
+
+PT_TEST( IntegrateAllMatchesScalar )
+{
+	// A count which leaves a tail after the groups of four, integrated for a few frames so plenty of bodies wrap
+	const int count = 100003;
+	std::unique_ptr< int[] > pSlots = AddBodies( count, 8 );
+	std::vector< Point2f > vStart( count ), vSimd( count );
+	for( int n = 0; n < count; n++ )
+		vStart[n] = MotionStore::GetPosition( n );
+
+	int failures = 0;
+	for( int frame = 0; frame < 10; frame++ )
+	{
+		MotionStore::IntegrateAll();
+		for( int n = 0; n < count; n++ )
+		{
+			vSimd[n] = MotionStore::GetPosition( n );
+			MotionStore::SetPosition( n, vStart[n] );
+		}
+
+		MotionStore::IntegrateAllScalar();
+		for( int n = 0; n < count; n++ )
+		{
+			const Point2f pos = MotionStore::GetPosition( n );
+			failures += pos.x != vSimd[n].x || pos.y != vSimd[n].y;
+			failures += MotionStore::GetPrevPosition( n ).x != vStart[n].x || MotionStore::GetPrevPosition( n ).y != vStart[n].y;
+			vStart[n] = pos;
+		}
+	}
+	PT_CHECK( failures == 0 );
+	RemoveAllBodies();
+}
+
+PT_BENCHMARK( IntegrateRate )
+{
+	for( int count = 1000; count <= 1000000; count *= 10 )
+	{
+		std::unique_ptr< int[] > pSlots = AddBodies( count, count );
+		const double scalar = PlayTests::BestTime( [] { MotionStore::IntegrateAllScalar(); } );
+		const double simd = PlayTests::BestTime( [] { MotionStore::IntegrateAll(); } );
+		PlayTests::Report( "%7d bodies: scalar %5.0fk objects/ms, SSE2 %5.0fk objects/ms", count, count / scalar, count / simd );
+		RemoveAllBodies();
+	}
+}
@@ -0,0 +1,88 @@
+//********************************************************************************************************************************
+// File:		ObjectPoolTests.cpp
+// Description:	Benchmarks allocating from an ObjectPool against the heap, for bare blocks and for whole game objects
+// Notes:		In builds with PLAY_MEMORY_TRACKING on, the heap timings include the memory tracker, as the game's do
+//********************************************************************************************************************************
+#include "PlayTests.h"
+#include "../Particle.h"
+
+namespace
+{
+	// An object the size of a Particle which does nothing, so the timings are all allocation and the registry's own work
+	class ParticleSizedObject : public GameObject
+	{
+	public:
+		ParticleSizedObject( Point2f pos ) : GameObject( pos ) {}
+		void Draw( GameState& state ) const override { (void)state; }
+
+	private:
+		char m_padding[sizeof( Particle ) - sizeof( GameObject )];
+	};
+
+	class HeapObject : public ParticleSizedObject
+	{
+	public:
+		HeapObject( Point2f pos ) : ParticleSizedObject( pos ) {}
+	};
+
+	class PooledTestObject : public ParticleSizedObject, public PooledObject< PooledTestObject, 1024 >
+	{
+	public:
+		PooledTestObject( Point2f pos ) : ParticleSizedObject( pos ) {}
+	};
+
+	// Creates objects, then destroys them all at the end of an UpdateAll as the game does
+	template< class T > double SpawnAndDestroyTime( int count )
+	{
+		GameState state;
+		std::vector< GameObject* > vObjects( count );
+		return PlayTests::BestTime( [&]
+		{
+			for( GameObject*& p : vObjects )
+				p = new T( { 0.0f, 0.0f } );
+			for( GameObject* p : vObjects )
+				p->SetActive( false );
+			GameObject::UpdateAll( state );
+		} );
+	}
+}
+
+PT_BENCHMARK( ObjectPoolCost )
+{
+	// Particle-sized blocks allocated together and freed in a random order, so the pool's free list ends up shuffled like
+	// the game's, against the same with new and delete
+	// > The pool keeps its chunks from run to run, as it does from frame to frame in the game
+	ObjectPool pool( "ObjectPoolCost", sizeof( Particle ), 1024 );
+	const int counts[] = { 1000, 10000, 100000 };
+	for( int count : counts )
+	{
+		std::vector< void* > vBlocks( count );
+		PlayTests::Random random( count );
+		const double pooled = PlayTests::BestTime( [&]
+		{
+			for( void*& p : vBlocks )
+				p = pool.Allocate( sizeof( Particle ) );
+			std::shuffle( vBlocks.begin(), vBlocks.end(), random );
+			for( void* p : vBlocks )
+				pool.Free( p );
+		} );
+		const double heap = PlayTests::BestTime( [&]
+		{
+			for( void*& p : vBlocks )
+				p = new char[sizeof( Particle )];
+			std::shuffle( vBlocks.begin(), vBlocks.end(), random );
+			for( void* p : vBlocks )
+				delete[] static_cast<char*>( p );
+		} );
+		PlayTests::Report( "%6d blocks: pool %8.1f us, heap %8.1f us (both including the shuffle)", count, pooled, heap );
+	}
+
+	// Whole objects created and destroyed through the GameObject registry, which the allocation is only a part of
+	for( int count : counts )
+	{
+		const double pooled = SpawnAndDestroyTime< PooledTestObject >( count );
+		const double heap = SpawnAndDestroyTime< HeapObject >( count );
+		PlayTests::Report( "%6d objects spawned and destroyed: pool %.3f ms, heap %.3f ms", count, pooled / 1000.0, heap / 1000.0 );
+	}
+	PT_CHECK( PooledTestObject::GetPool().GetLiveCount() == 0 );
+}
@@ -0,0 +1,135 @@
+//********************************************************************************************************************************
+// File:		PlayTests.cpp
+// Description:	The entry point of the PlayTests project, which runs the tests and benchmarks the other files register
+// Notes:		Usage: PlayTests [bench] [name]
+//				With "bench" the benchmarks run after the tests, and with a name only the tests and benchmarks whose
+//				names contain it run. The exit code is the number of failed checks.
+//********************************************************************************************************************************
+
+// The game has its own GameObject, so the PlayManager's is renamed in the files which use the manager
+#define PLAY_USING_GAMEOBJECT_MANAGER
+#define GameObject PlayManagerObject
+#define PLAY_IMPLEMENTATION
+#include "PlayTests.h"
+#undef GameObject
+#undef PLAY_IMPLEMENTATION
+#include "../Collision.h"
+
+// The game's code is linked in without MainGame.cpp, so the functions the rest of it expects from there are defined here
+bool MainGameUpdate( float elapsedTime )
+{
+	UNREFERENCED_PARAMETER( elapsedTime );
+	return true;
+}
+
+void MainGameExit( void )
+{
+}
+
+bool HasCollided( Point2f pos1, Point2f pos2 )
+{
+	return CollisionGrid::TorusDistanceSq( pos1, pos2 ) < S_SCREEN_LIMIT * S_SCREEN_LIMIT;
+}
+
+namespace PlayTests
+{
+	struct RegisteredTest
+	{
+		const char* name;
+		TestFunction function;
+		bool benchmark;
+	};
+
+	// A function's static, so it's made before any of the registrations in other files use it
+	static std::vector< RegisteredTest >& RegisteredTests()
+	{
+		static std::vector< RegisteredTest > s_vTests;
+		return s_vTests;
+	}
+
+	static int s_checks = 0;
+	static int s_failures = 0;
+
+	Registration::Registration( const char* name, TestFunction function, bool benchmark )
+	{
+		RegisteredTests().push_back( { name, function, benchmark } );
+	}
+
+	void Check( bool passed, const char* expression, const char* file, int line )
+	{
+		s_checks++;
+		if( !passed )
+		{
+			s_failures++;
+			printf( "  FAILED %s(%d): %s\n", file, line, expression );
+		}
+	}
+
+	void Report( const char* format, ... )
+	{
+		va_list args;
+		va_start( args, format );
+		printf( "  " );
+		vprintf( format, args );
+		printf( "\n" );
+		va_end( args );
+	}
+
+	PlayBlitter& Blitter()
+	{
+		static PlayBlitter& blitter = PlayBlitter::Instance( "Data\\Sprites\\" );
+		return blitter;
+	}
+
+	uint32_t* DisplayBuffer()
+	{
+		return PlayBuffer::Instance().GetDisplayBuffer();
+	}
+
+	void ClearDisplayBuffer()
+	{
+		uint32_t* pPixels = DisplayBuffer();
+		for( int n = 0; n < DISPLAY_WIDTH * DISPLAY_HEIGHT; n++ )
+			pPixels[n] = 0xFF000000 | ( n * 0x9E3779B1u >> 8 );
+	}
+}
+
+int main( int argc, char* argv[] )
+{
+	bool runBenchmarks = false;
+	const char* filter = nullptr;
+	for( int a = 1; a < argc; a++ )
+	{
+		if( strcmp( argv[a], "bench" ) == 0 )
+			runBenchmarks = true;
+		else
+			filter = argv[a];
+	}
+
+	// The display buffer comes from PlayBuffer, as in the game, which also starts up GDI+ for loading the sprites
+	// > No window is opened, as HandleWindows is never called
+	PlayBuffer& buff = PlayBuffer::Instance( PlayTests::DISPLAY_WIDTH, PlayTests::DISPLAY_HEIGHT, 1, 0 );
+	PlayTests::Blitter().SetDisplayBuffer( buff.GetDisplayBuffer(), PlayTests::DISPLAY_WIDTH, PlayTests::DISPLAY_HEIGHT );
+
+	// The tests run first, then the benchmarks
+	for( int pass = 0; pass < ( runBenchmarks ? 2 : 1 ); pass++ )
+	{
+		for( const PlayTests::RegisteredTest& test : PlayTests::RegisteredTests() )
+		{
+			if( test.benchmark != ( pass == 1 ) || ( filter && !strstr( test.name, filter ) ) )
+				continue;
+
+			const int failuresBefore = PlayTests::s_failures;
+			printf( "%s %s\n", test.benchmark ? "BENCHMARK" : "TEST", test.name );
+			test.function();
+			if( !test.benchmark )
+				printf( "  %s\n", PlayTests::s_failures == failuresBefore ? "passed" : "FAILED" );
+		}
+	}
+
+	printf( "%d checks, %d failed\n", PlayTests::s_checks, PlayTests::s_failures );
+
+	PlayBlitter::Destroy();
+	PlayBuffer::Destroy();
+	return PlayTests::s_failures;
+}
@@ -0,0 +1,112 @@
+#pragma once
+//********************************************************************************************************************************
+// File:		PlayTests.h
+// Description:	A small test and benchmark harness for Play.h and the game code, built by the PlayTests project
+// Notes:		Each test or benchmark registers itself with PT_TEST or PT_BENCHMARK, so a file only has to define them.
+//				Tests check their results with PT_CHECK and always run. Benchmarks print their timings with Report, and
+//				only run when "bench" is on the command line (build Release for meaningful numbers).
+//				Run from the project directory so that Data\Sprites can be found.
+//********************************************************************************************************************************
+
+// Standard headers go before Play.h, as the memory tracker's #define new breaks placement new inside them
+#include <cstdio>
+#include <cstdarg>
+#include <random>
+#include "../Play.h"
+
+namespace PlayTests
+{
+	using TestFunction = void (*)();
+
+	// Adds a test or benchmark to the list main runs (used by PT_TEST and PT_BENCHMARK)
+	struct Registration
+	{
+		Registration( const char* name, TestFunction function, bool benchmark );
+	};
+
+	// Records the result of a check, and prints it if it failed
+	void Check( bool passed, const char* expression, const char* file, int line );
+	// Prints a line of benchmark results, printf style
+	void Report( const char* format, ... );
+
+	// The best time for one run of a function in microseconds, out of the number of runs given
+	// > Taking the best rather than the average leaves out runs which were interrupted
+	template< class Function >
+	double BestTime( Function function, int runs = 10 )
+	{
+		double best = 1e30;
+		for( int run = 0; run < runs; run++ )
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			function();
+			best = std::min( best, std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - start ).count() );
+		}
+		return best;
+	}
+
+	// Every test starts from the same seed, so the same data is tested on every run
+	using Random = std::mt19937;
+
+	// The size of the display buffer the tests draw to, the same as the game's
+	constexpr int DISPLAY_WIDTH = 1280;
+	constexpr int DISPLAY_HEIGHT = 720;
+
+	// The blitter with every sprite in Data\Sprites loaded, drawing to the tests' display buffer
+	// > Tests which change its settings (SIMD level, draw threads and so on) put them back when they finish
+	PlayBlitter& Blitter();
+	// The tests' display buffer (DISPLAY_WIDTH x DISPLAY_HEIGHT)
+	uint32_t* DisplayBuffer();
+	// Fills the display buffer with the same opaque pattern every time, so a test's results don't depend on what was drawn before
+	void ClearDisplayBuffer();
+}
+
+// Checks a condition, counting it as a failure if it's false
+#define PT_CHECK( condition ) PlayTests::Check( ( condition ), #condition, __FILE__, __LINE__ )
+
+// Defines a test, which runs every time
+#define PT_TEST( name ) \
+	static void name(); \
+	static PlayTests::Registration name##Registration( #name, name, false ); \
+	static void name()
+
+// Defines a benchmark, which only runs when "bench" is on the command line
+#define PT_BENCHMARK( name ) \
+	static void name(); \
+	static PlayTests::Registration name##Registration( #name, name, true ); \
+	static void name()
+
+// PlayBlitter makes this class a friend, so the tests can reach its internal kernels and structures through it
+class PlayBlitterTests
+{
+public:
+	using SimdLevel = PlayBlitter::SimdLevel;
+
+	// The row kernels, which have a version for each SimdLevel that must give the same results
+	static constexpr auto BlendRow = &PlayBlitter::BlendRow;
+	static constexpr auto BlendRowSSE2 = &PlayBlitter::BlendRowSSE2;
+	static constexpr auto BlendRowAVX2 = &PlayBlitter::BlendRowAVX2;
+	static constexpr auto BlendRowAlpha = &PlayBlitter::BlendRowAlpha;
+	static constexpr auto BlendRowAlphaSSE2 = &PlayBlitter::BlendRowAlphaSSE2;
+	static constexpr auto BlendRowAlphaAVX2 = &PlayBlitter::BlendRowAlphaAVX2;
+	static constexpr auto CopyRow = &PlayBlitter::CopyRow;
+	static constexpr auto CopyRowSSE2 = &PlayBlitter::CopyRowSSE2;
+	static constexpr auto CopyRowAVX2 = &PlayBlitter::CopyRowAVX2;
+	static constexpr auto MarkTransparentRuns = &PlayBlitter::MarkTransparentRuns;
+
+	// How rotated sprites are sampled (see PlayBlitter::RotateScaleSprite)
+	using RotatedRect = PlayBlitter::RotatedRect;
+	static constexpr auto GetRotatedRect = &PlayBlitter::GetRotatedRect;
+	static constexpr auto ClipSpan = &PlayBlitter::ClipSpan;
+	static constexpr auto GatherRow = &PlayBlitter::GatherRow;
+	static constexpr auto GatherRowAVX2 = &PlayBlitter::GatherRowAVX2;
+
+	// The best instruction set the CPU supports
+	static SimdLevel GetMaxSimdLevel( const PlayBlitter& blitter ) { return blitter.m_maxSimdLevel; }
+	// A loaded sprite's pixels and layout
+	static const PlayBlitter::Sprite& GetSprite( const PlayBlitter& blitter, int spriteId ) { return blitter.vSpriteData[spriteId]; }
+
+	// Reads a collision shape as if it followed the origin in the sprite's .INF file
+	static void LoadCollisionShape( PlayBlitter& blitter, int spriteId, std::istream& info ) { blitter.LoadCollisionShape( spriteId, info ); }
+	// A sprite's collision shape as points relative to its origin, as SpriteShapeCollide uses it
+	static int GetShapePoints( const PlayBlitter& blitter, int spriteId, Point2f* pPoints, float& radius ) { return blitter.GetShapePoints( spriteId, pPoints, radius ); }
+};
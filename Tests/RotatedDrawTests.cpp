@@ -0,0 +1,402 @@
+//********************************************************************************************************************************
+// File:		RotatedDrawTests.cpp
+// Description:	Checks rotated and scaled sprite draws against a double-precision reference of the same sampling, the
+//				fixed-point span clipping and gather kernels they use, and the rotation cache, and benchmarks rotated draws at
+//				each SimdLevel and with the rotation cache
+// Notes:		The blitter steps the sampling position in 16.16 fixed point, so a pixel whose exact position is very close
+//				to a texel boundary can land on the neighbouring texel. The reference test allows for a small number of these.
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+namespace
+{
+	using RotatedRect = PlayBlitterTests::RotatedRect;
+
+	// The most pixels of a rotated draw which may differ from the reference, as a fraction of the pixels it draws
+	constexpr double MAX_DIFFERENT_PIXELS = 0.005;
+
+	// A rotated draw with everything that changes how the sprite is sampled
+	struct RotatedDraw
+	{
+		int spriteId, frame;
+		Point2f pos;
+		int originX, originY;
+		float angle, scale;
+		bool flipX;
+		float alphaMultiply;
+	};
+
+	// Makes a random rotated draw, which may be partly or completely off the display buffer
+	RotatedDraw RandomRotatedDraw( PlayTests::Random& random )
+	{
+		const PlayBlitter& blit = PlayTests::Blitter();
+		std::uniform_real_distribution< float > unit( 0.0f, 1.0f );
+
+		RotatedDraw draw;
+		draw.spriteId = random() % blit.GetTotalLoadedSprites();
+		draw.frame = random() % blit.GetSpriteFrames( draw.spriteId );
+		draw.pos = { -200.0f + unit( random ) * ( PlayTests::DISPLAY_WIDTH + 400 ), -200.0f + unit( random ) * ( PlayTests::DISPLAY_HEIGHT + 400 ) };
+
+		const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( blit, draw.spriteId );
+		draw.originX = static_cast<int>( random() % ( spr.width + 1 ) );
+		draw.originY = static_cast<int>( random() % ( spr.height + 1 ) );
+		draw.angle = unit( random ) * 4 * PLAY_PI - 2 * PLAY_PI;
+		draw.scale = 0.25f + unit( random ) * 3.0f;
+		draw.flipX = random() % 2 == 0;
+		draw.alphaMultiply = random() % 2 == 0 ? 1.0f : unit( random );
+		return draw;
+	}
+
+	// Draws a rotated draw with the blitter, at the current SimdLevel
+	void DrawWithBlitter( const RotatedDraw& draw )
+	{
+		PlayBlitter::DrawParams params;
+		params.useOrigin = true;
+		params.origin = { static_cast<float>( draw.originX ), static_cast<float>( draw.originY ) };
+		params.flipX = draw.flipX;
+		params.alphaMultiply = draw.alphaMultiply;
+		PlayTests::Blitter().DrawRotated( draw.spriteId, draw.pos, draw.frame, draw.angle, draw.scale, params );
+	}
+
+	// Draws a rotated draw into a buffer the same way as the blitter, but finding each pixel's position in the sprite frame in
+	// double precision, and returns the number of pixels which sample the frame
+	// > Uses the same RotatedRect as the blitter, so only the sampling along the rows is worked out differently
+	int DrawWithReference( const RotatedDraw& draw, uint32_t* pBuffer )
+	{
+		const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( PlayTests::Blitter(), draw.spriteId );
+		const uint32_t* pFrame = spr.FramePixels( draw.frame );
+
+		// The position is turned into whole pixels as in DrawRotated
+		const int xpos = static_cast<int>( draw.pos.x + 0.5f );
+		const int ypos = static_cast<int>( draw.pos.y + 0.5f );
+		RotatedRect rect;
+		PlayBlitterTests::GetRotatedRect( spr, draw.originX, draw.originY, draw.flipX, xpos, ypos, draw.angle, draw.scale, PlayTests::DISPLAY_WIDTH, PlayTests::DISPLAY_HEIGHT, rect );
+		const double dUdX = cos( -static_cast<double>( draw.angle ) ) / draw.scale;
+		const double dVdX = sin( -static_cast<double>( draw.angle ) ) / draw.scale;
+
+		int sampled = 0;
+		std::vector< uint32_t > row( PlayTests::DISPLAY_WIDTH );
+		for( int y = rect.startY; y < rect.endY; y++ )
+		{
+			const int count = rect.endX - rect.startX;
+			for( int x = 0; x < count; x++ )
+			{
+				const double u = rect.startU + static_cast<double>( rect.dUdY ) * ( y - rect.startY ) + dUdX * x;
+				const double v = rect.startV + static_cast<double>( rect.dVdY ) * ( y - rect.startY ) + dVdX * x;
+
+				// Positions of exactly zero are outside the frame, as in the blitter
+				row[x] = 0xFF000000;
+				if( u > 0.0 && v > 0.0 && u < spr.width && v < spr.height )
+				{
+					int texelU = static_cast<int>( u );
+					if( draw.flipX )
+						texelU = spr.width - 1 - texelU;
+					row[x] = pFrame[texelU + static_cast<int>( v ) * spr.frameStride];
+					sampled++;
+				}
+			}
+			PlayBlitterTests::MarkTransparentRuns( row.data(), count );
+			PlayBlitterTests::BlendRowAlpha( pBuffer + y * PlayTests::DISPLAY_WIDTH + rect.startX, row.data(), count, draw.alphaMultiply );
+		}
+		return sampled;
+	}
+
+	// The angle the rotation cache rounds draws to, worked out as GetRotatedFrame works it out
+	float CachedAngle( int angleStep, int angleSteps )
+	{
+		return angleStep * ( 2.0f * PLAY_PI / angleSteps );
+	}
+
+	// Makes a random rotated draw which the rotation cache would take (at a cached angle and a scale of 1, with an alpha
+	// multiply below 1), placed wholly on the display buffer so nothing is clipped
+	RotatedDraw RandomCachedDraw( PlayTests::Random& random, int angleSteps )
+	{
+		std::uniform_real_distribution< float > unit( 0.0f, 1.0f );
+		while( true )
+		{
+			RotatedDraw draw = RandomRotatedDraw( random );
+			const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( PlayTests::Blitter(), draw.spriteId );
+
+			// The furthest a corner can be from the origin, with a pixel either way for rounding
+			const int reachX = std::max( draw.originX, spr.width - draw.originX );
+			const int reachY = std::max( draw.originY, spr.height - draw.originY );
+			const float reach = sqrt( static_cast<float>( reachX * reachX + reachY * reachY ) ) + 2.0f;
+			if( 2.0f * reach >= PlayTests::DISPLAY_HEIGHT )
+				continue;
+
+			draw.pos = { reach + unit( random ) * ( PlayTests::DISPLAY_WIDTH - 2.0f * reach ), reach + unit( random ) * ( PlayTests::DISPLAY_HEIGHT - 2.0f * reach ) };
+			draw.angle = CachedAngle( random() % angleSteps, angleSteps );
+			draw.scale = 1.0f;
+			draw.alphaMultiply = 0.1f + unit( random ) * 0.8f;
+			return draw;
+		}
+	}
+
+	// Whether the CPU can run the AVX2 kernels (they aren't tested if it can't)
+	bool HasAVX2()
+	{
+		return PlayBlitterTests::GetMaxSimdLevel( PlayTests::Blitter() ) >= PlayBlitter::SIMD_AVX2;
+	}
+}
+
+PT_TEST( RotatedDrawsMatchReference )
+{
+	PlayBlitter& blit = PlayTests::Blitter();
+	const PlayBlitter::SimdLevel simdLevelBefore = blit.GetSimdLevel();
+	const int pixels = PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT;
+	PlayTests::ClearDisplayBuffer();
+	const std::vector< uint32_t > background( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + pixels );
+
+	PlayTests::Random random( 17 );
+	int64_t sampledPixels = 0, differentPixels = 0;
+	for( int n = 0; n < 1000; n++ )
+	{
+		const RotatedDraw draw = RandomRotatedDraw( random );
+
+		std::vector< uint32_t > reference = background;
+		sampledPixels += DrawWithReference( draw, reference.data() );
+
+		// Every SimdLevel must draw exactly the same pixels as the scalar code
+		blit.SetSimdLevel( PlayBlitter::SIMD_NONE );
+		PlayTests::ClearDisplayBuffer();
+		DrawWithBlitter( draw );
+		const std::vector< uint32_t > scalar( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + pixels );
+
+		for( PlayBlitter::SimdLevel level : { PlayBlitter::SIMD_SSE2, PlayBlitter::SIMD_AVX2 } )
+		{
+			if( level > PlayBlitterTests::GetMaxSimdLevel( blit ) )
+				continue;
+			blit.SetSimdLevel( level );
+			PlayTests::ClearDisplayBuffer();
+			DrawWithBlitter( draw );
+			PT_CHECK( std::equal( scalar.begin(), scalar.end(), PlayTests::DisplayBuffer() ) );
+		}
+
+		for( int p = 0; p < pixels; p++ )
+			differentPixels += scalar[p] != reference[p];
+	}
+
+	PlayTests::Report( "%lld of %lld sampled pixels differ from the reference", static_cast<long long>( differentPixels ), static_cast<long long>( sampledPixels ) );
+	PT_CHECK( sampledPixels > 0 );
+	PT_CHECK( differentPixels <= sampledPixels * MAX_DIFFERENT_PIXELS );
+	blit.SetSimdLevel( simdLevelBefore );
+}
+
+PT_TEST( ClipSpanMatchesStepping )
+{
+	// The span must be exactly the pixels a loop stepping the coordinate would find inside the range
+	PlayTests::Random random( 18 );
+	std::uniform_int_distribution< int64_t > position( -( 1 << 24 ), 1 << 24 );
+	std::uniform_int_distribution< int64_t > step( -( 1 << 18 ), 1 << 18 );
+
+	int failures = 0;
+	for( int n = 0; n < 20000; n++ )
+	{
+		const int count = random() % 600;
+		const int64_t start = position( random );
+		const int64_t stepSize = n % 10 == 0 ? 0 : step( random );
+		int64_t low = position( random ), high = position( random );
+		if( low > high )
+			std::swap( low, high );
+
+		int expectedFirst = count, expectedLast = 0;
+		for( int p = 0; p < count; p++ )
+		{
+			const int64_t coordinate = start + stepSize * p;
+			if( coordinate >= low && coordinate < high )
+			{
+				expectedFirst = std::min( expectedFirst, p );
+				expectedLast = p + 1;
+			}
+		}
+
+		int first = 0, last = count;
+		PlayBlitterTests::ClipSpan( start, stepSize, low, high, first, last );
+		if( expectedFirst < expectedLast )
+			failures += first != expectedFirst || last != expectedLast;
+		else
+			failures += first < last;
+	}
+	PT_CHECK( failures == 0 );
+}
+
+PT_TEST( GatherRowAVX2MatchesScalar )
+{
+	if( !HasAVX2() )
+		return;
+
+	// Lines through a frame of random pixels at every angle, of every length up to a few AVX2 groups with a tail
+	const int width = 64, stride = 72;
+	PlayTests::Random random( 19 );
+	std::vector< uint32_t > frame( stride * width );
+	for( uint32_t& pixel : frame )
+		pixel = random();
+
+	std::uniform_int_distribution< int32_t > start( 24 << 16, 40 << 16 );
+	std::uniform_int_distribution< int32_t > step( -( 1 << 16 ) / 2, ( 1 << 16 ) / 2 );
+	int failures = 0;
+	for( int n = 0; n < 5000; n++ )
+	{
+		const int count = n % 48;
+		const int32_t u = start( random ), v = start( random ), uStep = step( random ), vStep = step( random );
+		uint32_t reference[48], kernel[48];
+		PlayBlitterTests::GatherRow( frame.data(), stride, u, v, uStep, vStep, count, reference );
+		PlayBlitterTests::GatherRowAVX2( frame.data(), stride, u, v, uStep, vStep, count, kernel );
+		failures += !std::equal( reference, reference + count, kernel );
+	}
+	PT_CHECK( failures == 0 );
+}
+
+PT_TEST( RotationCacheMatchesDirectDraws )
+{
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int pixels = PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT;
+	const int angleSteps = 256;
+	PlayTests::Random random( 24 );
+
+	// A cached draw must match a direct draw at the angle the cache rounds to, both when the frame is made and when it's reused
+	int different = 0, cached = 0;
+	const int draws = 200;
+	for( int n = 0; n < draws; n++ )
+	{
+		const RotatedDraw draw = RandomCachedDraw( random, angleSteps );
+		blit.SetRotationCache( 0, 0 );
+		PlayTests::ClearDisplayBuffer();
+		DrawWithBlitter( draw );
+		const std::vector< uint32_t > direct( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + pixels );
+
+		blit.SetRotationCache( angleSteps, 64 * 1024 * 1024 );
+		const PlayBlitter::RotationCacheStats before = blit.GetRotationCacheStats();
+		for( int pass = 0; pass < 2; pass++ )
+		{
+			PlayTests::ClearDisplayBuffer();
+			DrawWithBlitter( draw );
+			different += !std::equal( direct.begin(), direct.end(), PlayTests::DisplayBuffer() );
+		}
+		const PlayBlitter::RotationCacheStats& after = blit.GetRotationCacheStats();
+		cached += after.misses == before.misses + 1 && after.hits == before.hits + 1;
+	}
+	PT_CHECK( different == 0 );
+	PT_CHECK( cached == draws );
+
+	// A budget a few frames fill must never be exceeded, however many frames have to be freed to stay in it
+	const size_t budget = 256 * 1024;
+	blit.SetRotationCache( angleSteps, budget );
+	const uint64_t evictionsBefore = blit.GetRotationCacheStats().evictions;
+	bool inBudget = true;
+	for( int n = 0; n < 2000; n++ )
+	{
+		DrawWithBlitter( RandomCachedDraw( random, angleSteps ) );
+		inBudget &= blit.GetRotationCacheStats().bytes <= budget;
+	}
+	PT_CHECK( inBudget );
+	PT_CHECK( blit.GetRotationCacheStats().evictions > evictionsBefore );
+
+	// Three frames of a gem fill the budget exactly. Drawing the first again leaves the second as the least recently drawn,
+	// so it's the one freed to make room for a fourth
+	const int gem = blit.GetSpriteId( "gem" );
+	auto drawGem = [&]( int angleStep ) { blit.DrawRotated( gem, { PlayTests::DISPLAY_WIDTH / 2.0f, PlayTests::DISPLAY_HEIGHT / 2.0f }, 0, CachedAngle( angleStep, angleSteps ) ); };
+	blit.SetRotationCache( 0, 0 );
+	blit.SetRotationCache( angleSteps, 64 * 1024 * 1024 );
+	drawGem( 0 );
+	drawGem( 64 );
+	drawGem( 128 );
+	blit.SetRotationCache( angleSteps, blit.GetRotationCacheStats().bytes );
+	drawGem( 0 );
+	drawGem( 192 );
+
+	const PlayBlitter::RotationCacheStats before = blit.GetRotationCacheStats();
+	drawGem( 0 );
+	PT_CHECK( blit.GetRotationCacheStats().hits == before.hits + 1 );
+	drawGem( 64 );
+	PT_CHECK( blit.GetRotationCacheStats().misses == before.misses + 1 );
+
+	blit.SetRotationCache( 0, 0 );
+}
+
+PT_BENCHMARK( RotatedDrawRate )
+{
+	// Asteroids drawn at random angles all over the display buffer, at the game's scale and magnified
+	PlayBlitter& blit = PlayTests::Blitter();
+	const PlayBlitter::SimdLevel simdLevelBefore = blit.GetSimdLevel();
+	const int asteroid = blit.GetSpriteId( "asteroid_2" );
+
+	PlayTests::Random random( 21 );
+	std::uniform_real_distribution< float > x( 0.0f, static_cast<float>( PlayTests::DISPLAY_WIDTH ) );
+	std::uniform_real_distribution< float > y( 0.0f, static_cast<float>( PlayTests::DISPLAY_HEIGHT ) );
+	std::uniform_real_distribution< float > angle( 0.0f, 2 * PLAY_PI );
+	struct Placed { Point2f pos; float angle; };
+	std::vector< Placed > vDraws( 500 );
+	for( Placed& d : vDraws )
+		d = { { x( random ), y( random ) }, angle( random ) };
+
+	const char* names[] = { "scalar", "SSE2", "AVX2" };
+	const float scales[] = { 1.0f, 2.0f };
+	for( float scale : scales )
+	{
+		for( int level = PlayBlitter::SIMD_NONE; level <= PlayBlitterTests::GetMaxSimdLevel( blit ); level++ )
+		{
+			blit.SetSimdLevel( static_cast<PlayBlitter::SimdLevel>( level ) );
+			const double time = PlayTests::BestTime( [&]
+			{
+				for( const Placed& d : vDraws )
+					blit.DrawRotated( asteroid, d.pos, 0, d.angle, scale );
+			} );
+			PlayTests::Report( "scale %.0f %-6s  %6.1f rotated sprites/ms", scale, names[level], vDraws.size() * 1000.0 / time );
+		}
+	}
+
+	blit.SetSimdLevel( simdLevelBefore );
+}
+
+PT_BENCHMARK( RotationCacheFrameTime )
+{
+	// Frames of 500 asteroids drifting at the fixed random angles they spawn with, each starting with a copy of the
+	// background as the game's do, with the rotation cache off and on
+	PlayBlitter& blit = PlayTests::Blitter();
+	const int asteroid = blit.GetSpriteId( "asteroid_2" );
+	const int pixels = PlayTests::DISPLAY_WIDTH * PlayTests::DISPLAY_HEIGHT;
+	PlayTests::ClearDisplayBuffer();
+	const std::vector< uint32_t > background( PlayTests::DisplayBuffer(), PlayTests::DisplayBuffer() + pixels );
+
+	PlayTests::Random random( 19 );
+	std::uniform_real_distribution< float > x( 0.0f, static_cast<float>( PlayTests::DISPLAY_WIDTH ) );
+	std::uniform_real_distribution< float > y( 0.0f, static_cast<float>( PlayTests::DISPLAY_HEIGHT ) );
+	std::uniform_real_distribution< float > angle( 0.0f, 2 * PLAY_PI );
+	std::uniform_real_distribution< float > speed( -3.0f, 3.0f );
+	struct Asteroid { Point2f pos; Vector2f velocity; float angle; };
+	std::vector< Asteroid > vAsteroids( 500 );
+	for( Asteroid& a : vAsteroids )
+		a = { { x( random ), y( random ) }, { speed( random ), speed( random ) }, angle( random ) };
+
+	auto drawFrame = [&]()
+	{
+		std::copy( background.begin(), background.end(), PlayTests::DisplayBuffer() );
+		for( Asteroid& a : vAsteroids )
+		{
+			a.pos += a.velocity;
+			a.pos.x = a.pos.x < 0.0f ? a.pos.x + PlayTests::DISPLAY_WIDTH : a.pos.x > PlayTests::DISPLAY_WIDTH ? a.pos.x - PlayTests::DISPLAY_WIDTH : a.pos.x;
+			a.pos.y = a.pos.y < 0.0f ? a.pos.y + PlayTests::DISPLAY_HEIGHT : a.pos.y > PlayTests::DISPLAY_HEIGHT ? a.pos.y - PlayTests::DISPLAY_HEIGHT : a.pos.y;
+			blit.DrawRotated( asteroid, a.pos, 0, a.angle );
+		}
+	};
+
+	blit.SetRotationCache( 0, 0 );
+	PlayTests::Report( "cache off:          %5.1f ms per frame", PlayTests::BestTime( drawFrame ) / 1000.0 );
+
+	// Fewer angles, then the number the game uses (both with the game's budget)
+	const int steps[] = { 64, 256 };
+	for( int angleSteps : steps )
+	{
+		blit.SetRotationCache( angleSteps, 64 * 1024 * 1024 );
+		const double cold = PlayTests::BestTime( drawFrame, 1 );
+		const PlayBlitter::RotationCacheStats before = blit.GetRotationCacheStats();
+		const double warm = PlayTests::BestTime( drawFrame );
+		const PlayBlitter::RotationCacheStats& after = blit.GetRotationCacheStats();
+		const uint64_t hits = after.hits - before.hits, misses = after.misses - before.misses;
+		PlayTests::Report( "cache, %3d angles:  %5.1f ms per frame (first frame %.1f ms), %.1f%% hits, %.1f MB",
+			angleSteps, warm / 1000.0, cold / 1000.0, 100.0 * hits / ( hits + misses ), after.bytes / ( 1024.0 * 1024.0 ) );
+	}
+
+	blit.SetRotationCache( 0, 0 );
+}
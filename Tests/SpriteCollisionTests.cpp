@@ -0,0 +1,211 @@
+//********************************************************************************************************************************
+// File:		SpriteCollisionTests.cpp
+// Description:	Checks the bitmask sprite collision test (and its cache of rotated masks) against the pixel-by-pixel
+//				SpriteCollide it replaces, and benchmarks them both
+// Notes:		SpriteCollide rounds the rotated positions of the pixels differently from the rotated masks, so a few pairs
+//				which only just touch or only just miss can differ when they are rotated
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+namespace
+{
+	// The most rotated pairs which may differ from SpriteCollide, as a fraction of the pairs
+	constexpr double MAX_ROTATED_DIFFERENCES = 0.01;
+
+	// A pair of sprites placed close enough for their bounding circles to overlap, as after the circle broadphase
+	struct SpritePair
+	{
+		int spriteA, spriteB;
+		Point2f posA, posB;
+		float angleA, angleB;
+	};
+
+	// Makes pairs of the player against asteroids and meteors with their centres within 90 pixels, unrotated or at random
+	// angles
+	// > At whole pixels, as SpriteMaskCollide rounds positions the way DrawRotated does and SpriteCollide doesn't
+	std::vector< SpritePair > MakePairs( PlayTests::Random& random, int count, bool rotated )
+	{
+		const PlayBlitter& blit = PlayTests::Blitter();
+		const int player = blit.GetSpriteId( "agent8_fly" );
+		const int targets[] = { blit.GetSpriteId( "asteroid_2" ), blit.GetSpriteId( "meteor_2" ) };
+		std::uniform_real_distribution< float > offset( -90.0f, 90.0f );
+		std::uniform_real_distribution< float > angle( 0.0f, 2 * PLAY_PI );
+
+		std::vector< SpritePair > vPairs( count );
+		for( SpritePair& pair : vPairs )
+		{
+			pair.spriteA = player;
+			pair.spriteB = targets[random() % 2];
+			pair.posA = { 640.0f, 360.0f };
+			pair.posB = { 640.0f + std::floor( offset( random ) ), 360.0f + std::floor( offset( random ) ) };
+			pair.angleA = rotated ? angle( random ) : 0.0f;
+			pair.angleB = rotated ? angle( random ) : 0.0f;
+		}
+		return vPairs;
+	}
+
+	// SpriteCollide's collision box for the whole of a sprite, relative to its origin
+	void WholeSpriteBox( const PlayBlitter::Sprite& spr, int box[4] )
+	{
+		box[0] = -spr.originX;
+		box[1] = -spr.originY;
+		box[2] = spr.width - 1 - spr.originX;
+		box[3] = spr.height - 1 - spr.originY;
+	}
+
+	// Tests a pair with SpriteCollide over the whole of both sprites
+	bool PixelCollide( const SpritePair& pair )
+	{
+		const PlayBlitter& blit = PlayTests::Blitter();
+		int boxA[4], boxB[4];
+		WholeSpriteBox( PlayBlitterTests::GetSprite( blit, pair.spriteA ), boxA );
+		WholeSpriteBox( PlayBlitterTests::GetSprite( blit, pair.spriteB ), boxB );
+		return blit.SpriteCollide( pair.spriteA, pair.posA, 0, pair.angleA, boxA, pair.spriteB, pair.posB, 0, pair.angleB, boxB );
+	}
+
+	// Tests a pair with SpriteMaskCollide
+	bool MaskCollide( const SpritePair& pair )
+	{
+		return PlayTests::Blitter().SpriteMaskCollide( pair.spriteA, pair.posA, 0, pair.angleA, pair.spriteB, pair.posB, 0, pair.angleB );
+	}
+}
+
+PT_TEST( SpriteMaskCollideMatchesSpriteCollide )
+{
+	PlayBlitter& blit = PlayTests::Blitter();
+	PlayTests::Random random( 14 );
+	const int pairs = 2000;
+
+	for( bool rotated : { false, true } )
+	{
+		const std::vector< SpritePair > vPairs = MakePairs( random, pairs, rotated );
+		std::vector< bool > vPixelHits( pairs );
+		int hits = 0;
+		for( int n = 0; n < pairs; n++ )
+		{
+			vPixelHits[n] = PixelCollide( vPairs[n] );
+			hits += vPixelHits[n];
+		}
+		// Enough of the pairs touch, and enough miss, for the comparison to mean something
+		PT_CHECK( hits > pairs / 10 && hits < pairs * 9 / 10 );
+
+		// The first pass builds the rotated masks and the second uses the cached ones, which must give the same answers
+		blit.ClearMaskCache();
+		std::vector< bool > vColdHits( pairs );
+		int coldDifferences = 0, warmDifferences = 0, cacheDifferences = 0;
+		for( int n = 0; n < pairs; n++ )
+		{
+			vColdHits[n] = MaskCollide( vPairs[n] );
+			coldDifferences += vColdHits[n] != vPixelHits[n];
+		}
+		for( int n = 0; n < pairs; n++ )
+		{
+			const bool hit = MaskCollide( vPairs[n] );
+			warmDifferences += hit != vPixelHits[n];
+			cacheDifferences += hit != vColdHits[n];
+		}
+
+		PlayTests::Report( "%s: %d of %d pairs differ from SpriteCollide", rotated ? "rotated" : "unrotated", warmDifferences, pairs );
+		PT_CHECK( cacheDifferences == 0 );
+		if( rotated )
+		{
+			PT_CHECK( coldDifferences <= pairs * MAX_ROTATED_DIFFERENCES );
+			PT_CHECK( warmDifferences <= pairs * MAX_ROTATED_DIFFERENCES );
+		}
+		else
+		{
+			PT_CHECK( coldDifferences == 0 );
+			PT_CHECK( warmDifferences == 0 );
+		}
+	}
+	blit.ClearMaskCache();
+}
+
+PT_TEST( MaskCacheStaysWithinBudget )
+{
+	// Rotated pairs tested with room for every mask, then again with a quarter of the memory they needed, with one pair
+	// tested between each of the others. The answers must match, the cache must never go over the budget, and the pair
+	// tested every other time must never be evicted
+	PlayBlitter& blit = PlayTests::Blitter();
+	PlayTests::Random random( 19 );
+	const int pairs = 2000;
+	const std::vector< SpritePair > vPairs = MakePairs( random, pairs, true );
+	const SpritePair hotPair = vPairs[0];
+
+	blit.ClearMaskCache();
+	std::vector< bool > vHits( pairs );
+	for( int n = 0; n < pairs; n++ )
+		vHits[n] = MaskCollide( vPairs[n] );
+	const size_t budget = blit.GetMaskCacheStats().bytes / 4;
+	const bool hotHit = MaskCollide( hotPair );
+
+	blit.ClearMaskCache();
+	blit.SetMaskCacheBudget( budget );
+	const uint64_t evictions = blit.GetMaskCacheStats().evictions;
+	MaskCollide( hotPair );
+	int differences = 0, overBudget = 0, hotMisses = 0;
+	for( int n = 0; n < pairs; n++ )
+	{
+		differences += MaskCollide( vPairs[n] ) != vHits[n];
+		overBudget += blit.GetMaskCacheStats().bytes > budget;
+
+		const uint64_t misses = blit.GetMaskCacheStats().misses;
+		differences += MaskCollide( hotPair ) != hotHit;
+		hotMisses += blit.GetMaskCacheStats().misses != misses;
+	}
+
+	PT_CHECK( differences == 0 );
+	PT_CHECK( overBudget == 0 );
+	PT_CHECK( hotMisses == 0 );
+	PT_CHECK( blit.GetMaskCacheStats().evictions > evictions );
+
+	blit.SetMaskCacheBudget( PlayBlitter::DEFAULT_MASK_BUDGET );
+	blit.ClearMaskCache();
+}
+
+PT_BENCHMARK( SpriteMaskCollideRate )
+{
+	// The same pairs as the test
+	PlayBlitter& blit = PlayTests::Blitter();
+	PlayTests::Random random( 13 );
+	const int pairs = 3000;
+
+	for( bool rotated : { false, true } )
+	{
+		const std::vector< SpritePair > vPairs = MakePairs( random, pairs, rotated );
+		int pixelHits = 0, maskHits = 0, agree = 0;
+		std::vector< bool > vPixelHits( pairs );
+		const double pixelTime = PlayTests::BestTime( [&]
+		{
+			pixelHits = 0;
+			for( int n = 0; n < pairs; n++ )
+			{
+				vPixelHits[n] = PixelCollide( vPairs[n] );
+				pixelHits += vPixelHits[n];
+			}
+		}, 3 );
+
+		// The first run builds the rotated masks, and the best of the rest is with them all cached
+		blit.ClearMaskCache();
+		const double coldTime = PlayTests::BestTime( [&]
+		{
+			for( const SpritePair& pair : vPairs )
+				MaskCollide( pair );
+		}, 1 );
+		const double maskTime = PlayTests::BestTime( [&]
+		{
+			maskHits = agree = 0;
+			for( int n = 0; n < pairs; n++ )
+			{
+				const bool hit = MaskCollide( vPairs[n] );
+				maskHits += hit;
+				agree += hit == vPixelHits[n];
+			}
+		} );
+
+		PlayTests::Report( "%-10s SpriteCollide %7.0fk tests/s, SpriteMaskCollide %7.0fk tests/s (%.0fk with the cache cold)",
+			rotated ? "rotated:" : "unrotated:", pairs * 1000.0 / pixelTime, pairs * 1000.0 / maskTime, pairs * 1000.0 / coldTime );
+		PlayTests::Report( "%-10s %d and %d hits, the tests agree on %d of %d pairs", "", pixelHits, maskHits, agree, pairs );
+	}
+	blit.ClearMaskCache();
+}
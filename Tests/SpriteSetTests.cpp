@@ -0,0 +1,146 @@
+//********************************************************************************************************************************
+// File:		SpriteSetTests.cpp
+// Description:	Benchmarks how the sprites in Data/Sprites are stored after loading, how fast the whole set draws, and
+//				looking sprites up by name
+//********************************************************************************************************************************
+#include "PlayTests.h"
+
+namespace
+{
+	const char* SIMD_NAMES[] = { "scalar", "SSE2", "AVX2" };
+
+	// Draws every frame of every sprite once, in the middle of the display buffer
+	void DrawSpriteSet( bool rotated )
+	{
+		PlayBlitter& blit = PlayTests::Blitter();
+		const Point2f middle = { PlayTests::DISPLAY_WIDTH / 2.0f, PlayTests::DISPLAY_HEIGHT / 2.0f };
+		for( int id = 0; id < blit.GetTotalLoadedSprites(); id++ )
+		{
+			for( int frame = 0; frame < blit.GetSpriteFrames( id ); frame++ )
+			{
+				if( rotated )
+					blit.DrawRotated( id, middle, frame, 0.5f );
+				else
+					blit.Draw( id, middle, frame );
+			}
+		}
+	}
+}
+
+PT_BENCHMARK( SpriteSpanCost )
+{
+	// The memory the row spans take against the pixels, and where the pixels end up
+	PlayBlitter& blit = PlayTests::Blitter();
+	size_t pixelBytes = 0, spanBytes = 0;
+	int64_t copyPixels = 0, blendPixels = 0, rowPixels = 0;
+	for( int id = 0; id < blit.GetTotalLoadedSprites(); id++ )
+	{
+		const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( blit, id );
+		pixelBytes += sizeof( uint32_t ) * spr.frameStride * spr.height * spr.totalCount;
+		spanBytes += sizeof( uint32_t ) * spr.vRowSpanStarts.size() + sizeof( PlayBlitter::PixelSpan ) * spr.vSpans.size();
+		rowPixels += static_cast<int64_t>( spr.width ) * spr.height * spr.totalCount;
+		for( const PlayBlitter::PixelSpan& span : spr.vSpans )
+			( span.copy ? copyPixels : blendPixels ) += span.right - span.left;
+	}
+	PlayTests::Report( "spans %zu KB for %zu KB of pixels (%.1f%%)", spanBytes / 1024, pixelBytes / 1024, 100.0 * spanBytes / pixelBytes );
+	PlayTests::Report( "%.1f%% of the pixels are copied, %.1f%% blended and %.1f%% skipped", 100.0 * copyPixels / rowPixels,
+		100.0 * blendPixels / rowPixels, 100.0 * ( rowPixels - copyPixels - blendPixels ) / rowPixels );
+
+	// Drawing every frame, straight from the spans and through the rotation cache (which stores its frames as spans too)
+	const PlayBlitter::SimdLevel simdLevelBefore = blit.GetSimdLevel();
+	blit.SetRotationCache( 64, 64 * 1024 * 1024 );
+	for( int level = PlayBlitter::SIMD_NONE; level <= PlayBlitterTests::GetMaxSimdLevel( blit ); level++ )
+	{
+		blit.SetSimdLevel( static_cast<PlayBlitter::SimdLevel>( level ) );
+		const double drawTime = PlayTests::BestTime( [] { DrawSpriteSet( false ); } );
+		const double cachedTime = PlayTests::BestTime( [] { DrawSpriteSet( true ); } );
+		PlayTests::Report( "%-6s  draw %.3f ms, cached rotation %.3f ms", SIMD_NAMES[level], drawTime / 1000.0, cachedTime / 1000.0 );
+	}
+	blit.SetRotationCache( 0, 0 );
+	blit.SetSimdLevel( simdLevelBefore );
+}
+
+PT_BENCHMARK( FrameLayoutCost )
+{
+	// Sprites with several frames to a sheet, whose frames are each stored contiguously with rows starting on cache lines
+	// > The cache lines one draw of a frame reads are counted for the frames as they are stored, and as they would be read
+	//   from the loaded canvas (pCanvasBuffer), where each row of a frame is a whole row of the sheet away from the next
+	PlayBlitter& blit = PlayTests::Blitter();
+	const char* names[] = { "agent8_left_7", "agent8_right_7", "asteroid_pieces_3", "rocket_4", "font64px_10x10", "font105px_10x10", "font151px_10x10" };
+	std::vector< char > flush( 32 * 1024 * 1024 );
+	const Point2f middle = { PlayTests::DISPLAY_WIDTH / 2.0f, PlayTests::DISPLAY_HEIGHT / 2.0f };
+
+	for( const char* name : names )
+	{
+		const int id = blit.GetSpriteId( name );
+		const PlayBlitter::Sprite& spr = PlayBlitterTests::GetSprite( blit, id );
+		auto linesTouched = [&spr]( const uint32_t* pFirstRow, int stride )
+		{
+			int64_t lines = 0;
+			for( int y = 0; y < spr.height; y++ )
+			{
+				const uintptr_t start = reinterpret_cast<uintptr_t>( pFirstRow + static_cast<size_t>( stride ) * y );
+				lines += ( start + sizeof( uint32_t ) * spr.width - 1 ) / 64 - start / 64 + 1;
+			}
+			return lines;
+		};
+
+		int64_t canvasLines = 0, frameLines = 0;
+		double coldTime = 0.0;
+		for( int frame = 0; frame < spr.totalCount; frame++ )
+		{
+			const uint32_t* pCanvasFrame = spr.pCanvasBuffer + static_cast<size_t>( frame / spr.hCount ) * spr.height * spr.canvasWidth + ( frame % spr.hCount ) * spr.width;
+			canvasLines += linesTouched( pCanvasFrame, spr.canvasWidth );
+			frameLines += linesTouched( spr.FramePixels( frame ), spr.frameStride );
+
+			// Something else has been through the cache since the frame was last drawn
+			for( size_t n = 0; n < flush.size(); n += 64 )
+				flush[n]++;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			blit.Draw( id, middle, frame );
+			coldTime += std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - start ).count();
+		}
+		const double hotTime = PlayTests::BestTime( [&]
+		{
+			for( int frame = 0; frame < spr.totalCount; frame++ )
+				blit.Draw( id, middle, frame );
+		} );
+
+		PlayTests::Report( "%-17s %3d frames: %5lld cache lines per draw (%5lld from the canvas), %5.2f us cold, %5.2f us hot",
+			name, spr.totalCount, static_cast<long long>( frameLines / spr.totalCount ), static_cast<long long>( canvasLines / spr.totalCount ),
+			coldTime / spr.totalCount, hotTime / spr.totalCount );
+	}
+}
+
+PT_BENCHMARK( SpriteLookupCost )
+{
+	// The sprites the game draws, looked up with compile-time handles, with names hashed as they are looked up, and with
+	// the substring search GetSpriteId used to do (now FindSpriteId)
+	PlayBlitter& blit = PlayTests::Blitter();
+	constexpr PlayBlitter::SpriteHandle handles[] = { "asteroid_2", "meteor_2", "agent8_fly", "gem", "particle", "font64px_10x10" };
+	const std::vector< std::string > names = { "asteroid_2", "meteor_2", "agent8_fly", "gem", "particle", "font64px_10x10" };
+	// The lookups of a typical frame: 6 asteroids, 2 meteors, the player, 4 gems, 31 particles and the score
+	const int frameLookups[] = { 6, 2, 1, 4, 31, 1 };
+	const int calls = 10000;
+
+	double frameTime[3] = { 0.0, 0.0, 0.0 };
+	// The ids are stored somewhere the compiler can't leave out
+	volatile int lastId = 0;
+	for( size_t n = 0; n < names.size(); n++ )
+	{
+		const PlayBlitter::SpriteHandle handle = handles[n];
+		const char* name = names[n].c_str();
+		const double times[3] =
+		{
+			PlayTests::BestTime( [&] { for( int c = 0; c < calls; c++ ) lastId = blit.GetSpriteId( handle ); } ),
+			PlayTests::BestTime( [&] { for( int c = 0; c < calls; c++ ) lastId = blit.GetSpriteId( name ); } ),
+			PlayTests::BestTime( [&] { for( int c = 0; c < calls; c++ ) lastId = blit.FindSpriteId( name ); } ),
+		};
+		PlayTests::Report( "%-15s handle %5.1f ns, hashed name %5.1f ns, substring search %6.1f ns",
+			name, times[0] * 1000.0 / calls, times[1] * 1000.0 / calls, times[2] * 1000.0 / calls );
+		for( int way = 0; way < 3; way++ )
+			frameTime[way] += times[way] / calls * frameLookups[n];
+	}
+	PlayTests::Report( "a typical frame's 45 lookups: handles %.2f us, hashed names %.2f us, substring search %.2f us",
+		frameTime[0], frameTime[1], frameTime[2] );
+}
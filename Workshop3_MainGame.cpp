@@ -74,7 +74,7 @@ bool MainGameUpdate( float elapsedTime )
     UpdateLasers(); // Call Laser::UpdateAll() passing through a reference to the GameState
     UpdatePlayer();
     UpdateSaucers(); // Call Saucer::UpdateAll() passing through a reference to the GameState
-    blit.DrawStringCentred( blit.GetSpriteId( "105px" ), { DISPLAY_WIDTH / 2, 50 }, "SCORE: " + std::to_string( gState.score ) );
+    blit.DrawStringCentred( blit.FindSpriteId( "105px" ), { DISPLAY_WIDTH / 2, 50 }, "SCORE: " + std::to_string( gState.score ) );
     buff.Present();
 
     return PlayBuffer::Instance().KeyDown( VK_ESCAPE );
@@ -118,7 +118,7 @@ void UpdatePlayer( void ) // Stays in MainGame.cpp
         SpawnSaucers(); // Call Saucer::SpawnWave() passing through a reference to the GameState
 
     float yWobble = sin( gState.time * PLAY_PI ) * 3;
-    blit.Draw( blit.GetSpriteId( "Rocket" ), { gState.playerPos.x, gState.playerPos.y + yWobble }, 2 * gState.time );
+    blit.Draw( blit.FindSpriteId( "Rocket" ), { gState.playerPos.x, gState.playerPos.y + yWobble }, 2 * gState.time );
 }
 
 void UpdateLasers( void ) // Becomes Laser::UpdateAll() which calls Laser::Update() for each Laser in the vector
@@ -146,7 +146,7 @@ void UpdateLasers( void ) // Becomes Laser::UpdateAll() which calls Laser::Updat
         if( l.pos.y < 0 )
             l.active = false;
 
-        blit.Draw( blit.GetSpriteId( "Laser" ), l.pos, 0 );
+        blit.Draw( blit.FindSpriteId( "Laser" ), l.pos, 0 );
         // End of Laser::Update()
     }
 
@@ -199,7 +199,7 @@ void UpdateSaucers( void ) // Becomes Saucer::UpdateAll() which calls Saucer::Up
 
         s.pos += s.velocity;
 
-        blit.DrawRotated( blit.GetSpriteId( "Saucer" ), s.pos, 0, s.rot );
+        blit.DrawRotated( blit.FindSpriteId( "Saucer" ), s.pos, 0, s.rot );
         // End of Saucer::Update()
     }
 